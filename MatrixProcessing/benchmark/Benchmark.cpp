@@ -0,0 +1,603 @@
+/*
+
+This file contains benchmark executable timing every processor across shape classes and element types
+
+Usage: MatrixBenchmark [--filter <substring>] [--min-time <seconds>] [--out <file.json>]
+JSON report goes to the file or to stdout, human-readable table goes to stderr.
+
+*/
+
+#include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <sstream>
+#include "Matrix.h"
+#include "MatrixVectCol.h"
+#include "MatrixVectRow.h"
+#include "MatrixProcessors.h"
+#include "MatrixExpression.h"
+#include "MatrixText.h"
+#include "Benchmark.h"
+
+
+namespace Benchmarks {
+
+  template <typename T> const char* type_name();
+  template <> const char* type_name<int>() { return "int"; }
+  template <> const char* type_name<float>() { return "float"; }
+  template <> const char* type_name<double>() { return "double"; }
+  template <> const char* type_name<int8_t>() { return "int8"; }
+  template <> const char* type_name<Float16>() { return "float16"; }
+  template <> const char* type_name<BFloat16>() { return "bfloat16"; }
+
+  template <typename T, typename U>
+  std::string type_names()
+    {
+    return std::string(type_name<T>()) + "," + type_name<U>();
+    }
+
+  std::string shape_name(size_t rows, size_t cols)
+    {
+    return std::to_string(rows) + "x" + std::to_string(cols);
+    }
+
+  std::string shape_name(size_t m, size_t k, size_t n)
+    {
+    return std::to_string(m) + "x" + std::to_string(k) + "x" + std::to_string(n);
+    }
+
+  // small values keep int products exact and floating point sums away from overflow;
+  // the vector has the allocator of matrices, so they take the buffer over instead of copying it
+  template <typename T>
+  std::vector<T, AlignedAllocator<T>> make_data(size_t size, size_t seed)
+    {
+    std::vector<T, AlignedAllocator<T>> data(size);
+    for (size_t i = 0; i < size; ++i)
+      {
+      data[i] = static_cast<T>(int((i * 7 + seed) % 17) - 8);
+      }
+    return data;
+    }
+
+  template <typename T, size_t R, size_t C>
+  Matrix<T, R, C> make_matrix(size_t seed)
+    {
+    return Matrix<T, R, C>(make_data<T>(R * C, seed));
+    }
+
+
+  /// <summary>
+  /// AddScalar, SubtractScalar, MultiplyScalar and AddMatrix of R x C Matrix<T> and U operand.
+  /// </summary>
+  template <typename T, typename U, size_t R, size_t C>
+  void bench_elementwise(Runner& runner, const char* shape_class)
+    {
+    using W = decltype(std::declval<T>() + std::declval<U>());
+    const auto lhs = make_matrix<T, R, C>(1);
+    const auto rhs = make_matrix<U, R, C>(2);
+    const U scal = U(3);
+    Matrix<W, R, C> out;
+
+    const std::string shape = shape_name(R, C);
+    const std::string types = type_names<T, U>();
+    const double n = double(R * C);
+    const double scalar_bytes = n * (sizeof(T) + sizeof(W));
+    const double matrix_bytes = n * (sizeof(T) + sizeof(U) + sizeof(W));
+
+    runner.run({ "AddScalar", shape_class, shape, types }, n, scalar_bytes, [&]
+      {
+      MatrixProcessors::AddScalar{}.perform_operation_into(lhs, scal, out);
+      do_not_optimize(out);
+      });
+    runner.run({ "SubtractScalar", shape_class, shape, types }, n, scalar_bytes, [&]
+      {
+      MatrixProcessors::SubtractScalar{}.perform_operation_into(lhs, scal, out);
+      do_not_optimize(out);
+      });
+    runner.run({ "MultiplyScalar", shape_class, shape, types }, n, scalar_bytes, [&]
+      {
+      MatrixProcessors::MultiplyScalar{}.perform_operation_into(lhs, scal, out);
+      do_not_optimize(out);
+      });
+    runner.run({ "AddMatrix", shape_class, shape, types }, n, matrix_bytes, [&]
+      {
+      MatrixProcessors::AddMatrix{}.perform_operation_into(lhs, rhs, out);
+      do_not_optimize(out);
+      });
+
+    // (lhs + rhs) * scal - scal fused by a lazy expression, and the same chain pass by pass in place
+    runner.run({ "Expression[lazy]", shape_class, shape, types }, 3.0 * n, matrix_bytes, [&]
+      {
+      out = (MatrixExpressions::lazy(lhs) + rhs) * scal - scal;
+      do_not_optimize(out);
+      });
+    runner.run({ "Expression[eager]", shape_class, shape, types }, 3.0 * n, matrix_bytes, [&]
+      {
+      MatrixProcessors::AddMatrix{}.perform_operation_into(lhs, rhs, out);
+      MatrixProcessors::MultiplyScalar{}.perform_operation_into(out, scal, out);
+      MatrixProcessors::SubtractScalar{}.perform_operation_into(out, scal, out);
+      do_not_optimize(out);
+      });
+    }
+
+
+  template <typename T, size_t R, size_t C>
+  void bench_transpose(Runner& runner, const char* shape_class)
+    {
+    const auto mat = make_matrix<T, R, C>(1);
+    Matrix<T, C, R> out;
+
+    runner.run({ "Transpose", shape_class, shape_name(R, C), type_name<T>() }, 0.0, 2.0 * R * C * sizeof(T), [&]
+      {
+      MatrixProcessors::Transpose{}.perform_operation_into(mat, out);
+      do_not_optimize(out);
+      });
+    }
+
+
+  /// <summary>
+  /// MultiplyMatrix of M x K Matrix<T> and K x N Matrix<U>. Large products are also run with
+  /// every hardware thread and by StrassenMultiplyMatrix.
+  /// </summary>
+  template <typename T, typename U, size_t M, size_t K, size_t N>
+  void bench_multiply(Runner& runner, const char* shape_class, bool large)
+    {
+    using W = decltype(std::declval<T>() + std::declval<U>());
+    const auto lhs = make_matrix<T, M, K>(1);
+    const auto rhs = make_matrix<U, K, N>(2);
+    Matrix<W, M, N> out;
+
+    const std::string shape = shape_name(M, K, N);
+    const std::string types = type_names<T, U>();
+    const double flops = 2.0 * M * K * N;
+    const double bytes = double(M * K * sizeof(T) + K * N * sizeof(U) + M * N * sizeof(W));
+
+    runner.run({ "MultiplyMatrix", shape_class, shape, types }, flops, bytes, [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(lhs, rhs, out);
+      do_not_optimize(out);
+      });
+
+    if (!large)
+      {
+      return;
+      }
+
+    const ExecutionPolicy parallel = ExecutionPolicy::parallel();
+    Result parallel_case { "MultiplyMatrix", shape_class, shape, types };
+    parallel_case.n_threads = ThreadPool::resolve_n_threads(parallel);
+    if (parallel_case.n_threads > 1)
+      {
+      runner.run(parallel_case, flops, bytes, [&]
+        {
+        MatrixProcessors::MultiplyMatrix(parallel).perform_operation_into(lhs, rhs, out);
+        do_not_optimize(out);
+        });
+      }
+
+    // flops of the classic product, so GFLOP/s of both processors compare directly
+    runner.run({ "StrassenMultiplyMatrix", shape_class, shape, types }, flops, bytes, [&]
+      {
+      MatrixProcessors::StrassenMultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(lhs, rhs, out);
+      do_not_optimize(out);
+      });
+    }
+
+
+  template <typename T, typename U>
+  void bench_types(Runner& runner)
+    {
+    bench_elementwise<T, U, 4, 4>(runner, "small");
+    bench_elementwise<T, U, 128, 128>(runner, "medium");
+    bench_elementwise<T, U, 1024, 1024>(runner, "large");
+
+    bench_multiply<T, U, 3, 3, 3>(runner, "small", false);
+    bench_multiply<T, U, 4, 4, 4>(runner, "small", false);
+    bench_multiply<T, U, 4, 4, 1>(runner, "small", false);
+    bench_multiply<T, U, 64, 64, 64>(runner, "medium", false);
+    bench_multiply<T, U, 1024, 1024, 1024>(runner, "large", true);
+    }
+
+
+  template <typename T>
+  void bench_batch(Runner& runner)
+    {
+    constexpr size_t size = 4096;
+    std::vector<Matrix<T, 4, 4>> lhs_mats;
+    std::vector<Matrix<T, 4, 4>> rhs_mats;
+    for (size_t i = 0; i < size; ++i)
+      {
+      lhs_mats.push_back(make_matrix<T, 4, 4>(i));
+      rhs_mats.push_back(make_matrix<T, 4, 4>(i + 1));
+      }
+    const MatrixBatch<T, 4, 4> lhs(lhs_mats);
+    const MatrixBatch<T, 4, 4> rhs(rhs_mats);
+    MatrixBatch<T, 4, 4> out(size);
+
+    const std::string shape = std::to_string(size) + "x" + shape_name(4, 4, 4);
+    runner.run({ "MultiplyMatrix[batch]", "small", shape, type_names<T, T>() }, 2.0 * 64 * size, 3.0 * 16 * size * sizeof(T), [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(lhs, rhs, out);
+      do_not_optimize(out);
+      });
+    runner.run({ "AddMatrix[batch]", "small", std::to_string(size) + "x" + shape_name(4, 4), type_names<T, T>() }, 16.0 * size, 3.0 * 16 * size * sizeof(T), [&]
+      {
+      MatrixProcessors::AddMatrix(ExecutionPolicy::serial()).perform_operation_into(lhs, rhs, out);
+      do_not_optimize(out);
+      });
+    }
+
+
+  template <typename T>
+  void bench_dynamic(Runner& runner)
+    {
+    constexpr size_t n = 256;
+    const DynamicMatrix<T> lhs(n, n, make_data<T>(n * n, 1));
+    const DynamicMatrix<T> rhs(n, n, make_data<T>(n * n, 2));
+    DynamicMatrix<T> out(n, n);
+
+    runner.run({ "AddMatrix[dynamic]", "medium", shape_name(n, n), type_names<T, T>() }, double(n * n), 3.0 * n * n * sizeof(T), [&]
+      {
+      MatrixProcessors::AddMatrix(ExecutionPolicy::serial()).perform_operation_into(lhs, rhs, out);
+      do_not_optimize(out);
+      });
+    runner.run({ "MultiplyMatrix[dynamic]", "medium", shape_name(n, n, n), type_names<T, T>() }, 2.0 * n * n * n, 3.0 * n * n * sizeof(T), [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(lhs, rhs, out);
+      do_not_optimize(out);
+      });
+    }
+
+
+  /// <summary>
+  /// Matrix times column and row times matrix for 2000 x 2000 matrix, both read the matrix once.
+  /// </summary>
+  template <typename T>
+  void bench_matrix_vector(Runner& runner)
+    {
+    constexpr size_t n = 2000;
+    const auto mat = make_matrix<T, n, n>(1);
+    const MatrixVectCol<T, n> col(make_data<T>(n, 2));
+    const MatrixVectRow<T, n> row(make_data<T>(n, 3));
+    Matrix<T, n, 1> out_col;
+    Matrix<T, 1, n> out_row;
+    const double flops = 2.0 * n * n;
+    const double bytes = double((n * n + 2 * n) * sizeof(T));
+    const std::string types = type_names<T, T>();
+
+    runner.run({ "MultiplyMatrix[gemv]", "large", shape_name(n, n, 1), types }, flops, bytes, [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(mat, col, out_col);
+      do_not_optimize(out_col);
+      });
+    runner.run({ "MultiplyMatrix[gevm]", "large", shape_name(1, n, n), types }, flops, bytes, [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(row, mat, out_row);
+      do_not_optimize(out_row);
+      });
+
+    const ExecutionPolicy parallel = ExecutionPolicy::parallel();
+    Result parallel_case { "MultiplyMatrix[gemv]", "large", shape_name(n, n, 1), types };
+    parallel_case.n_threads = ThreadPool::resolve_n_threads(parallel);
+    if (parallel_case.n_threads > 1)
+      {
+      runner.run(parallel_case, flops, bytes, [&]
+        {
+        MatrixProcessors::MultiplyMatrix(parallel).perform_operation_into(mat, col, out_col);
+        do_not_optimize(out_col);
+        });
+      }
+    }
+
+  /// <summary>
+  /// Outer product of 2000-element column and row, and rank-1 update A += x * y^T of 2000 x 2000 matrix.
+  /// </summary>
+  template <typename T>
+  void bench_outer_product(Runner& runner)
+    {
+    constexpr size_t n = 2000;
+    const MatrixVectCol<T, n> col(make_data<T>(n, 1));
+    const MatrixVectRow<T, n> row(make_data<T>(n, 2));
+    Matrix<T, n, n> out;
+    const std::string types = type_names<T, T>();
+
+    runner.run({ "MultiplyMatrix[outer]", "large", shape_name(n, 1, n), types }, double(n * n), double((n * n + 2 * n) * sizeof(T)), [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(col, row, out);
+      do_not_optimize(out);
+      });
+    runner.run({ "MultiplyAddMatrix[rank-1]", "large", shape_name(n, 1, n), types }, 2.0 * n * n, double((2 * n * n + 2 * n) * sizeof(T)), [&]
+      {
+      MatrixProcessors::MultiplyAddMatrix(ExecutionPolicy::serial()).perform_operation_into(col, row, out);
+      do_not_optimize(out);
+      });
+    }
+
+  /// <summary>
+  /// alpha * A * B + beta * C for 512 x 512 matrices: chain of three processors against the fused one.
+  /// </summary>
+  template <typename T>
+  void bench_multiply_add(Runner& runner)
+    {
+    constexpr size_t n = 512;
+    const DynamicMatrix<T> lhs(n, n, make_data<T>(n * n, 1));
+    const DynamicMatrix<T> rhs(n, n, make_data<T>(n * n, 2));
+    const DynamicMatrix<T> addend(n, n, make_data<T>(n * n, 3));
+    DynamicMatrix<T> out(addend);
+    const double flops = 2.0 * n * n * n + 3.0 * n * n;
+
+    runner.run({ "MultiplyAddMatrix[chained]", "large", shape_name(n, n, n), type_names<T, T>() }, flops, 4.0 * n * n * sizeof(T), [&]
+      {
+      const MatrixProcessors::MultiplyMatrix multiply(ExecutionPolicy::serial());
+      const MatrixProcessors::MultiplyScalar scale(ExecutionPolicy::serial());
+      const MatrixProcessors::AddMatrix add(ExecutionPolicy::serial());
+      out = add.perform_operation(scale.perform_operation(multiply.perform_operation(lhs, rhs), T(2)), scale.perform_operation(addend, T(0.5)));
+      do_not_optimize(out);
+      });
+    runner.run({ "MultiplyAddMatrix", "large", shape_name(n, n, n), type_names<T, T>() }, flops, 4.0 * n * n * sizeof(T), [&]
+      {
+      out = addend;
+      MatrixProcessors::MultiplyAddMatrix(ExecutionPolicy::serial(), 2.0, 0.5).perform_operation_into(lhs, rhs, out);
+      do_not_optimize(out);
+      });
+    }
+
+  /// <summary>
+  /// Sparse x vector and sparse x matrix for 2000 x 2000 matrix with 5% nonzeros.
+  /// </summary>
+  template <typename T>
+  void bench_sparse(Runner& runner)
+    {
+    constexpr size_t n = 2000;
+    constexpr size_t cols = 64;
+    std::vector<T> data(n * n, T(0));
+    for (size_t i = 0; i < data.size(); i += 20)
+      {
+      data[(i * 7919) % data.size()] = T(int(i % 17) - 8);
+      }
+    const Matrix<T, n, n> dense(data);
+    const CsrMatrix<T, n, n> csr(dense);
+    const CscMatrix<T, n, n> csc(dense);
+    const MatrixVectCol<T, n> vec(make_data<T>(n, 1));
+    const auto mat = make_matrix<T, n, cols>(2);
+    Matrix<T, n, 1> out_vec;
+    Matrix<T, n, cols> out_mat;
+
+    const double nnz = double(csr.get_n_nonzeros());
+    const double sparse_bytes = nnz * (sizeof(T) + sizeof(uint32_t)) + (n + 1) * sizeof(size_t);
+    const std::string types = type_names<T, T>();
+
+    runner.run({ "MultiplyMatrix[csr]", "large", shape_name(n, n, 1), types }, 2.0 * nnz, sparse_bytes + 2.0 * n * sizeof(T), [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(csr, vec, out_vec);
+      do_not_optimize(out_vec);
+      });
+    runner.run({ "MultiplyMatrix[csc]", "large", shape_name(n, n, 1), types }, 2.0 * nnz, sparse_bytes + 2.0 * n * sizeof(T), [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(csc, vec, out_vec);
+      do_not_optimize(out_vec);
+      });
+    runner.run({ "MultiplyMatrix[csr]", "large", shape_name(n, n, cols), types }, 2.0 * nnz * cols, sparse_bytes + 2.0 * n * cols * sizeof(T), [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(csr, mat, out_mat);
+      do_not_optimize(out_mat);
+      });
+    }
+
+
+  /// <summary>
+  /// OutOfCoreMultiplyMatrix of 1024 x 1024 files with 4 MB budget, files are in the page cache after the warm-up.
+  /// The files are written only when the filter selects the case.
+  /// </summary>
+  void bench_out_of_core(Runner& runner)
+    {
+    constexpr size_t n = 1024;
+    const Result result { "OutOfCoreMultiplyMatrix", "large", shape_name(n, n, n), type_names<double, double>() };
+    if (!runner.selected(result))
+      {
+      return;
+      }
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path();
+    const std::string path_a = (dir / "matrix_benchmark_a.bin").string();
+    const std::string path_b = (dir / "matrix_benchmark_b.bin").string();
+    const std::string path_c = (dir / "matrix_benchmark_c.bin").string();
+
+    MatrixIO::write_binary(path_a, DynamicMatrix<double>(n, n, make_data<double>(n * n, 1)));
+    MatrixIO::write_binary(path_b, DynamicMatrix<double>(n, n, make_data<double>(n * n, 2)));
+    const MatrixIO::MatrixFile<double> file_a(path_a);
+    const MatrixIO::MatrixFile<double> file_b(path_b);
+    const auto file_c = MatrixIO::MatrixFile<double>::create(path_c, n, n);
+
+    runner.run(result, 2.0 * n * n * n, 3.0 * n * n * sizeof(double), [&]
+      {
+      MatrixProcessors::OutOfCoreMultiplyMatrix(ExecutionPolicy::serial(), size_t(4) << 20).perform_operation_into(file_a, file_b, file_c);
+      });
+
+    std::remove(path_a.c_str());
+    std::remove(path_b.c_str());
+    std::remove(path_c.c_str());
+    }
+
+
+  /// <summary>
+  /// 1024 x 1024 products stored in 16-bit floats and accumulated in float, and int8 quantized product
+  /// accumulated in int32 with float result. Bytes are the operands and the result as stored.
+  /// </summary>
+  void bench_reduced_precision(Runner& runner)
+    {
+    constexpr size_t n = 1024;
+    const DynamicMatrix<float> lhs(n, n, make_data<float>(n * n, 1));
+    const DynamicMatrix<float> rhs(n, n, make_data<float>(n * n, 2));
+    const auto lhs16 = MatrixProcessors::ConvertMatrix<Float16>().perform_operation(lhs);
+    const auto rhs16 = MatrixProcessors::ConvertMatrix<Float16>().perform_operation(rhs);
+    const auto lhs_b16 = MatrixProcessors::ConvertMatrix<BFloat16>().perform_operation(lhs);
+    const auto rhs_b16 = MatrixProcessors::ConvertMatrix<BFloat16>().perform_operation(rhs);
+    const auto params = MatrixProcessors::Quantization::choose_params<int8_t>(-8.0f, 8.0f);
+    const auto lhs8 = MatrixProcessors::Quantization::quantize<int8_t>(lhs, params);
+    const auto rhs8 = MatrixProcessors::Quantization::quantize<int8_t>(rhs, params);
+    DynamicMatrix<float> out(n, n);
+    const double flops = 2.0 * n * n * n;
+
+    runner.run({ "MultiplyMatrix", "large", shape_name(n, n, n), type_names<Float16, Float16>() }, flops, double(n * n * (2 + 2 + 4)), [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(lhs16, rhs16, out);
+      do_not_optimize(out);
+      });
+    runner.run({ "MultiplyMatrix", "large", shape_name(n, n, n), type_names<BFloat16, BFloat16>() }, flops, double(n * n * (2 + 2 + 4)), [&]
+      {
+      MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation_into(lhs_b16, rhs_b16, out);
+      do_not_optimize(out);
+      });
+    runner.run({ "QuantizedMultiplyMatrix", "large", shape_name(n, n, n), type_names<int8_t, int8_t>() }, flops, double(n * n * (1 + 1 + 4)), [&]
+      {
+      MatrixProcessors::QuantizedMultiplyMatrix<>(ExecutionPolicy::serial(), params, params).perform_operation_into(lhs8, rhs8, out);
+      do_not_optimize(out);
+      });
+    }
+
+
+  /// <summary>
+  /// CSV text of 1024 x 1024 doubles written to memory and parsed back, bytes are the text size.
+  /// </summary>
+  void bench_text(Runner& runner)
+    {
+    constexpr size_t n = 1024;
+    const DynamicMatrix<double> mat(n, n, make_data<double>(n * n, 1));
+    std::ostringstream text;
+    MatrixIO::write_text(text, mat);
+    const std::string csv = text.str();
+
+    runner.run({ "TextWrite[csv]", "large", shape_name(n, n), type_names<double, double>() }, double(n * n), double(csv.size()), [&]
+      {
+      std::ostringstream out;
+      MatrixIO::write_text(out, mat, MatrixIO::TextFormat::Csv, ExecutionPolicy::serial());
+      });
+    runner.run({ "TextParse[csv]", "large", shape_name(n, n), type_names<double, double>() }, double(n * n), double(csv.size()), [&]
+      {
+      MatrixIO::parse_text<double>(csv, MatrixIO::TextFormat::Csv, ExecutionPolicy::serial());
+      });
+    }
+
+
+  const char* instruction_set_name(MatrixProcessors::Simd::InstructionSet isa)
+    {
+    switch (isa)
+      {
+      case MatrixProcessors::Simd::InstructionSet::AVX512: return "AVX512";
+      case MatrixProcessors::Simd::InstructionSet::AVX2: return "AVX2";
+      case MatrixProcessors::Simd::InstructionSet::SSE2: return "SSE2";
+      default: return "Scalar";
+      }
+    }
+
+
+  std::vector<std::pair<std::string, std::string>> context(double min_time)
+    {
+#if defined(__clang__)
+    const std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    const std::string compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    const std::string compiler = "msvc " + std::to_string(_MSC_VER);
+#else
+    const std::string compiler = "unknown";
+#endif
+#if defined(MATRIX_PROCESSING_NATIVE)
+    const bool native = true;
+#else
+    const bool native = false;
+#endif
+    return {
+      { "compiler", json_string(compiler) },
+      { "native_build", native ? "true" : "false" },
+      { "gemm_avx2_kernel", MatrixProcessors::Simd::fma_enabled() ? "true" : "false" },
+      { "simd_instruction_set", json_string(instruction_set_name(MatrixProcessors::Simd::active_instruction_set())) },
+      { "hardware_threads", std::to_string(std::thread::hardware_concurrency()) },
+      { "min_time_s", std::to_string(min_time) },
+      };
+    }
+
+  }
+
+
+int main(int argc, char** argv)
+  {
+  std::string filter;
+  std::string out_path;
+  double min_time = 0.05;
+
+  for (int i = 1; i < argc; ++i)
+    {
+    const std::string arg = argv[i];
+    if (arg == "--filter" && i + 1 < argc)
+      {
+      filter = argv[++i];
+      }
+    else if (arg == "--min-time" && i + 1 < argc)
+      {
+      min_time = std::atof(argv[++i]);
+      }
+    else if (arg == "--out" && i + 1 < argc)
+      {
+      out_path = argv[++i];
+      }
+    else
+      {
+      std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--min-time <seconds>] [--out <file.json>]\n";
+      return 1;
+      }
+    }
+
+  Benchmarks::Runner runner(min_time, filter);
+
+  Benchmarks::bench_types<int, int>(runner);
+  Benchmarks::bench_types<float, float>(runner);
+  Benchmarks::bench_types<double, double>(runner);
+  Benchmarks::bench_types<int, double>(runner);
+  Benchmarks::bench_types<float, double>(runner);
+
+  Benchmarks::bench_transpose<float, 4, 4>(runner, "small");
+  Benchmarks::bench_transpose<double, 128, 128>(runner, "medium");
+  Benchmarks::bench_transpose<double, 2048, 2048>(runner, "large");
+
+  Benchmarks::bench_batch<float>(runner);
+  Benchmarks::bench_batch<double>(runner);
+  Benchmarks::bench_dynamic<float>(runner);
+  Benchmarks::bench_dynamic<double>(runner);
+  Benchmarks::bench_multiply_add<float>(runner);
+  Benchmarks::bench_matrix_vector<float>(runner);
+  Benchmarks::bench_matrix_vector<double>(runner);
+  Benchmarks::bench_outer_product<float>(runner);
+  Benchmarks::bench_sparse<double>(runner);
+  Benchmarks::bench_out_of_core(runner);
+  Benchmarks::bench_reduced_precision(runner);
+  Benchmarks::bench_text(runner);
+
+  for (const Benchmarks::Result& r : runner.get_results())
+    {
+    std::fprintf(stderr, "%-64s %14.1f ns/op %9.2f GFLOP/s %9.2f GB/s\n", r.name().c_str(), r.ns_per_op, r.gflops, r.gbps);
+    }
+
+  const auto context = Benchmarks::context(min_time);
+  if (out_path.empty())
+    {
+    Benchmarks::write_json(std::cout, context, runner.get_results());
+    }
+  else
+    {
+    std::ofstream out(out_path);
+    Benchmarks::write_json(out, context, runner.get_results());
+    if (!out)
+      {
+      std::cerr << "Can`t write " << out_path << "\n";
+      return 1;
+      }
+    }
+  return 0;
+  }
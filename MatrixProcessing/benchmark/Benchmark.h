@@ -0,0 +1,182 @@
+/*
+
+This file contains timing harness and JSON report of the benchmark executable
+
+*/
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+/// <summary>
+/// This namespace contains microbenchmarks of the processors
+/// </summary>
+namespace Benchmarks {
+
+  /// <summary>
+  /// Keeps the compiler from dropping computation whose result is never read.
+  /// </summary>
+  template <typename T>
+  void do_not_optimize(T& value)
+    {
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r"(&value) : "memory");
+#endif
+    }
+
+
+  /// <summary>
+  /// One measured case. flops and bytes are counted per operation: bytes are those the operation
+  /// has to read and write at least once, so GB/s shows how close memory bound cases get to the bus.
+  /// </summary>
+  struct Result
+    {
+    std::string processor;
+    std::string shape_class;
+    std::string shape;
+    std::string types;
+    size_t n_threads = 1;
+    size_t iterations = 0;
+    double ns_per_op = 0.0;
+    double gflops = 0.0;
+    double gbps = 0.0;
+
+    std::string name() const
+      {
+      return processor + "/" + shape_class + "/" + shape + "/" + types + (n_threads == 1 ? "" : "/threads:" + std::to_string(n_threads));
+      }
+    };
+
+
+  class Runner
+    {
+    double m_min_time;
+    std::string m_filter;
+    std::vector<Result> m_results;
+
+    static constexpr size_t n_samples = 5;
+
+    public:
+
+    /// <summary>
+    /// Every sample runs the operation for at least min_time seconds. Only cases whose name
+    /// contains filter are run.
+    /// </summary>
+    Runner(double min_time, const std::string& filter) : m_min_time(min_time), m_filter(filter) {}
+
+    const std::vector<Result>& get_results() const
+      {
+      return m_results;
+      }
+
+    /// <summary>
+    /// True when the filter lets the case run. Cases with costly setup check it before preparing their operands.
+    /// </summary>
+    bool selected(const Result& result) const
+      {
+      return result.name().find(m_filter) != std::string::npos;
+      }
+
+    /// <summary>
+    /// Times op() and stores median of the samples as the result of the case.
+    /// </summary>
+    template <typename F>
+    void run(Result result, double flops, double bytes, F&& op)
+      {
+      if (!selected(result))
+        {
+        return;
+        }
+
+      using clock = std::chrono::steady_clock;
+      auto time_batch = [&](size_t iterations)
+        {
+        const auto start = clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+          {
+          op();
+          }
+        return std::chrono::duration<double>(clock::now() - start).count();
+        };
+
+      // warm-up doubles the batch until one batch takes min_time
+      size_t iterations = 1;
+      for (double elapsed = time_batch(iterations); elapsed < m_min_time; elapsed = time_batch(iterations))
+        {
+        iterations = elapsed <= 0.0 ? iterations * 2 : std::max(iterations + 1, static_cast<size_t>(iterations * std::min(2.0, 1.2 * m_min_time / elapsed)));
+        }
+
+      std::vector<double> samples(n_samples);
+      for (double& sample : samples)
+        {
+        sample = time_batch(iterations) * 1e9 / double(iterations);
+        }
+      std::sort(samples.begin(), samples.end());
+
+      result.iterations = iterations;
+      result.ns_per_op = samples[n_samples / 2];
+      result.gflops = flops / result.ns_per_op;
+      result.gbps = bytes / result.ns_per_op;
+      m_results.push_back(result);
+      }
+    };
+
+
+  inline std::string json_string(const std::string& str)
+    {
+    std::string escaped = "\"";
+    for (const char ch : str)
+      {
+      if (ch == '"' || ch == '\\')
+        {
+        escaped += '\\';
+        }
+      escaped += ch;
+      }
+    return escaped + "\"";
+    }
+
+
+  /// <summary>
+  /// Writes {"context": {...}, "benchmarks": [...]}, context holds name/value pairs describing the build and machine.
+  /// </summary>
+  inline void write_json(std::ostream& o, const std::vector<std::pair<std::string, std::string>>& context, const std::vector<Result>& results)
+    {
+    o << "{\n  \"context\": {";
+    for (size_t i = 0; i < context.size(); ++i)
+      {
+      o << (i == 0 ? "\n" : ",\n") << "    " << json_string(context[i].first) << ": " << context[i].second;
+      }
+    o << "\n  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+      {
+      const Result& r = results[i];
+      o << (i == 0 ? "\n" : ",\n")
+        << "    { \"name\": " << json_string(r.name())
+        << ", \"processor\": " << json_string(r.processor)
+        << ", \"shape_class\": " << json_string(r.shape_class)
+        << ", \"shape\": " << json_string(r.shape)
+        << ", \"types\": " << json_string(r.types)
+        << ", \"threads\": " << r.n_threads
+        << ", \"iterations\": " << r.iterations
+        << ", \"ns_per_op\": " << r.ns_per_op
+        << ", \"gflops\": " << r.gflops
+        << ", \"gbps\": " << r.gbps << " }";
+      }
+    o << "\n  ]\n}\n";
+    }
+
+  }
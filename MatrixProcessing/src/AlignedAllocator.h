@@ -0,0 +1,71 @@
+/*
+
+This class represents allocator returning memory aligned to the given boundary
+
+*/
+
+#pragma once
+
+#include <new>
+#include <memory>
+#include <cstddef>
+#include <limits>
+
+
+/// <summary>
+/// Allocator aligning every buffer to Alignment bytes (cache line by default),
+/// so SIMD loads never split across cache lines and aligned stores are allowed.
+/// </summary>
+template <typename T, size_t Alignment = 64>
+class AlignedAllocator
+  {
+  static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0, "Alignment must be a power of two not less than alignof(T)");
+
+  public:
+
+  using value_type = T;
+
+  template <typename U>
+  struct rebind
+    {
+    using other = AlignedAllocator<U, Alignment>;
+    };
+
+  AlignedAllocator() = default;
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+  T* allocate(size_t n)
+    {
+    if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+      {
+      throw std::bad_array_new_length();
+      }
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+  void deallocate(T* p, size_t) noexcept
+    {
+    ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+  template <typename U>
+  bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept
+    {
+    return true;
+    }
+
+  template <typename U>
+  bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept
+    {
+    return false;
+    }
+  };
+
+
+/// <summary>
+/// Allocator A rebound to element type V, used to give processor results the allocator of their operand.
+/// </summary>
+template <typename A, typename V>
+using rebind_allocator_t = typename std::allocator_traits<A>::template rebind_alloc<V>;
@@ -0,0 +1,42 @@
+/*
+
+This file contains detection of constant evaluation used by constexpr processors
+
+*/
+
+#pragma once
+
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#include <type_traits>
+#endif
+
+
+/// <summary>
+/// This namespace tells constexpr code whether it runs in the compiler or at run time.
+/// </summary>
+namespace ConstantEvaluation {
+
+  /// <summary>
+  /// True while the call is evaluated as a constant expression. Processors then take plain loops,
+  /// SIMD intrinsics, threads and pointer arithmetic on addresses are not allowed there.
+  /// C++17 has no std::is_constant_evaluated, so the builtin GCC 9, Clang 9 and MSVC 19.25 provide is used.
+  /// Without it the function is always false and processors can't be evaluated at compile time.
+  /// </summary>
+  constexpr bool is_constant_evaluated() noexcept
+    {
+#if defined(__cpp_lib_is_constant_evaluated)
+    return std::is_constant_evaluated();
+#elif defined(__clang__) && defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+    return __builtin_is_constant_evaluated();
+#else
+    return false;
+#endif
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+    return __builtin_is_constant_evaluated();
+#else
+    return false;
+#endif
+    }
+
+  }
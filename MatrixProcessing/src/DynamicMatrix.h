@@ -0,0 +1,356 @@
+/*
+
+This class represents Matrix with dimensions known only at runtime
+
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cassert>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include "IMatrixProcessor.h"
+#include "AlignedAllocator.h"
+#include "Matrix.h"
+#include "StridedIterator.h"
+
+
+template <typename T, typename A = AlignedAllocator<T>>
+class DynamicMatrix
+  {
+  public:
+
+  using allocator_type = A;
+  using storage_type = std::vector<T, A>;
+
+  protected:
+
+  storage_type m_data;
+  size_t m_rows = 0;
+  size_t m_cols = 0;
+
+
+  public:
+
+  DynamicMatrix() = default;
+  DynamicMatrix(size_t rows, size_t cols);
+
+  template <typename VA = std::allocator<T>>
+  DynamicMatrix(size_t rows, size_t cols, const std::vector<T, VA>& vec);
+
+  /// <summary>
+  /// Takes over the buffer of vec when its allocator is A, e.g. std::vector<T, AlignedAllocator<T>> for
+  /// the default A. Plain std::vector<T> has a different allocator, so its elements are copied into aligned storage.
+  /// </summary>
+  template <typename VA = std::allocator<T>>
+  DynamicMatrix(size_t rows, size_t cols, std::vector<T, VA>&& vec);
+
+  DynamicMatrix(size_t rows, size_t cols, std::initializer_list<T>&& init_list);
+
+  template <size_t R, size_t C>
+  DynamicMatrix(const Matrix<T, R, C, A>& mat);
+
+  template <size_t R, size_t C>
+  DynamicMatrix(Matrix<T, R, C, A>&& mat);
+
+  DynamicMatrix(const DynamicMatrix<T, A>&) = default;
+  DynamicMatrix(DynamicMatrix<T, A>&&) = default;
+  ~DynamicMatrix() = default;
+
+  DynamicMatrix& operator=(const DynamicMatrix&) = default;
+  DynamicMatrix& operator=(DynamicMatrix&&) = default;
+
+  template <size_t R, size_t C>
+  Matrix<T, R, C, A> to_fixed() const &;
+
+  template <size_t R, size_t C>
+  Matrix<T, R, C, A> to_fixed() &&;
+
+  const storage_type& get_data() const;
+  T* data();
+  const T* data() const;
+  size_t get_n_rows() const;
+  size_t get_n_cols() const;
+
+  const T& at(size_t row, size_t col) const;
+  T& at(size_t row, size_t col);
+
+  /// <summary>
+  /// Same element as at(), indices start from 1, but they are checked only by assert in debug builds.
+  /// </summary>
+  const T& operator()(size_t row, size_t col) const;
+  T& operator()(size_t row, size_t col);
+
+  using iterator = T*;
+  using const_iterator = const T*;
+  using col_iterator = StridedIterator<T>;
+  using const_col_iterator = StridedIterator<const T>;
+
+  // all elements in row-major order, one row or one column, indices start from 1 and are not checked
+  iterator begin() { return data(); }
+  iterator end() { return data() + m_data.size(); }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + m_data.size(); }
+
+  iterator row_begin(size_t row) { return data() + (row - 1) * m_cols; }
+  iterator row_end(size_t row) { return data() + row * m_cols; }
+  const_iterator row_begin(size_t row) const { return data() + (row - 1) * m_cols; }
+  const_iterator row_end(size_t row) const { return data() + row * m_cols; }
+
+  col_iterator col_begin(size_t col) { return col_iterator(data() + col - 1, m_cols); }
+  col_iterator col_end(size_t col) { return col_iterator(data() + col - 1, m_cols, m_rows); }
+  const_col_iterator col_begin(size_t col) const { return const_col_iterator(data() + col - 1, m_cols); }
+  const_col_iterator col_end(size_t col) const { return const_col_iterator(data() + col - 1, m_cols, m_rows); }
+
+  template <typename U, typename B>
+  friend std::ostream& operator<< (std::ostream& o, const DynamicMatrix<U, B>& mat);
+
+  template <typename U, typename B>
+  friend bool operator== (const DynamicMatrix<U, B>& mat1, const DynamicMatrix<U, B>& mat2);
+
+  template <typename U, typename B>
+  friend bool operator!= (const DynamicMatrix<U, B>& mat1, const DynamicMatrix<U, B>& mat2);
+
+  template <typename P>
+  auto UnaryOperation(const IMatrixProcessor<P>& imp) const;
+
+  template <typename P, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+  auto UnaryOperation(const IMatrixProcessor<P>& imp, const U& scal) const;
+
+  template <typename P, typename U, typename B>
+  auto BinaryOperation(const IMatrixProcessor<P>& imp, const DynamicMatrix<U, B>& mat) const;
+
+  private:
+
+  void check_size(size_t size) const;
+  };
+
+
+template <typename T, typename A>
+DynamicMatrix<T, A>::DynamicMatrix(size_t rows, size_t cols)
+  : m_data(rows * cols, T()), m_rows(rows), m_cols(cols)
+  {
+  }
+
+
+template <typename T, typename A>
+template <typename VA>
+DynamicMatrix<T, A>::DynamicMatrix(size_t rows, size_t cols, const std::vector<T, VA>& vec)
+  : m_rows(rows), m_cols(cols)
+  {
+  check_size(vec.size());
+  m_data.assign(vec.begin(), vec.end());
+  }
+
+
+template <typename T, typename A>
+template <typename VA>
+DynamicMatrix<T, A>::DynamicMatrix(size_t rows, size_t cols, std::vector<T, VA>&& vec)
+  : m_rows(rows), m_cols(cols)
+  {
+  check_size(vec.size());
+  if constexpr (std::is_same_v<storage_type, std::vector<T, VA>>)
+    {
+    m_data = std::move(vec);
+    }
+  else
+    {
+    m_data.assign(vec.begin(), vec.end());
+    }
+  }
+
+
+template <typename T, typename A>
+DynamicMatrix<T, A>::DynamicMatrix(size_t rows, size_t cols, std::initializer_list<T>&& init_list)
+  : m_data(init_list), m_rows(rows), m_cols(cols)
+  {
+  check_size(init_list.size());
+  }
+
+
+template <typename T, typename A>
+template <size_t R, size_t C>
+DynamicMatrix<T, A>::DynamicMatrix(const Matrix<T, R, C, A>& mat)
+  : m_data(mat.get_data().begin(), mat.get_data().end()), m_rows(R), m_cols(C)
+  {
+  }
+
+
+template <typename T, typename A>
+template <size_t R, size_t C>
+DynamicMatrix<T, A>::DynamicMatrix(Matrix<T, R, C, A>&& mat)
+  : m_rows(R), m_cols(C)
+  {
+  // heap buffer of the fixed matrix is taken over, inline storage has to be copied
+  m_data = std::move(mat).release_data();
+  }
+
+
+template <typename T, typename A>
+template <size_t R, size_t C>
+Matrix<T, R, C, A> DynamicMatrix<T, A>::to_fixed() const &
+  {
+  if (m_rows != R || m_cols != C)
+    {
+    throw std::length_error("Shape of the dynamic matrix doesn`t match requested matrix size");
+    }
+  return Matrix<T, R, C, A>(m_data);
+  }
+
+
+template <typename T, typename A>
+template <size_t R, size_t C>
+Matrix<T, R, C, A> DynamicMatrix<T, A>::to_fixed() &&
+  {
+  if (m_rows != R || m_cols != C)
+    {
+    throw std::length_error("Shape of the dynamic matrix doesn`t match requested matrix size");
+    }
+  m_rows = 0;
+  m_cols = 0;
+  return Matrix<T, R, C, A>(std::move(m_data));
+  }
+
+
+template <typename T, typename A>
+const typename DynamicMatrix<T, A>::storage_type& DynamicMatrix<T, A>::get_data() const
+  {
+  return m_data;
+  }
+
+
+template <typename T, typename A>
+T* DynamicMatrix<T, A>::data()
+  {
+  return m_data.data();
+  }
+
+
+template <typename T, typename A>
+const T* DynamicMatrix<T, A>::data() const
+  {
+  return m_data.data();
+  }
+
+
+template <typename T, typename A>
+size_t DynamicMatrix<T, A>::get_n_rows() const
+  {
+  return m_rows;
+  }
+
+
+template <typename T, typename A>
+size_t DynamicMatrix<T, A>::get_n_cols() const
+  {
+  return m_cols;
+  }
+
+
+template <typename T, typename A>
+const T& DynamicMatrix<T, A>::at(size_t row, size_t col) const
+  {
+  if (row == 0 || row > m_rows || col == 0 || col > m_cols)
+    {
+    throw std::out_of_range("Index is out of matrix bounds");
+    }
+  return m_data[(row - 1) * m_cols + col - 1];
+  }
+
+
+template <typename T, typename A>
+T& DynamicMatrix<T, A>::at(size_t row, size_t col)
+  {
+  if (row == 0 || row > m_rows || col == 0 || col > m_cols)
+    {
+    throw std::out_of_range("Index is out of matrix bounds");
+    }
+  return m_data[(row - 1) * m_cols + col - 1];
+  }
+
+
+template <typename T, typename A>
+const T& DynamicMatrix<T, A>::operator()(size_t row, size_t col) const
+  {
+  assert(row >= 1 && row <= m_rows && col >= 1 && col <= m_cols);
+  return m_data[(row - 1) * m_cols + col - 1];
+  }
+
+
+template <typename T, typename A>
+T& DynamicMatrix<T, A>::operator()(size_t row, size_t col)
+  {
+  assert(row >= 1 && row <= m_rows && col >= 1 && col <= m_cols);
+  return m_data[(row - 1) * m_cols + col - 1];
+  }
+
+
+template <typename T, typename A>
+void DynamicMatrix<T, A>::check_size(size_t size) const
+  {
+  if (size != m_rows * m_cols)
+    {
+    throw std::length_error("Length of the provided data doesn`t match matrix size");
+    }
+  }
+
+
+template <typename U, typename B>
+std::ostream& operator<< (std::ostream& ostr, const DynamicMatrix<U, B>& mat)
+  {
+  for (size_t row = 0; row < mat.m_rows; ++row)
+    {
+    ostr << "| ";
+    for (size_t col = 0; col < mat.m_cols; ++col)
+      {
+      ostr << mat.m_data[row * mat.m_cols + col];
+      ostr << (col + 1 < mat.m_cols ? "\t" : " |\n");
+      }
+    }
+
+  return ostr;
+  }
+
+
+template <typename U, typename B>
+bool operator==(const DynamicMatrix<U, B>& mat1, const DynamicMatrix<U, B>& mat2)
+  {
+  return mat1.m_rows == mat2.m_rows && mat1.m_cols == mat2.m_cols && mat1.m_data == mat2.m_data;
+  }
+
+
+template <typename U, typename B>
+bool operator!=(const DynamicMatrix<U, B>& mat1, const DynamicMatrix<U, B>& mat2)
+  {
+  return !(mat1 == mat2);
+  }
+
+
+template <typename T, typename A>
+template <typename P>
+auto DynamicMatrix<T, A>::UnaryOperation(const IMatrixProcessor<P>& imp) const
+  {
+  auto result = imp.perform_operation(*this);
+  return result;
+  }
+
+
+template <typename T, typename A>
+template <typename P, typename U, std::enable_if_t<std::is_arithmetic_v<U>>*>
+auto DynamicMatrix<T, A>::UnaryOperation(const IMatrixProcessor<P>& imp, const U& scal) const
+  {
+  auto result = imp.perform_operation(*this, scal);
+  return result;
+  }
+
+
+template <typename T, typename A>
+template <typename P, typename U, typename B>
+auto DynamicMatrix<T, A>::BinaryOperation(const IMatrixProcessor<P>& imp, const DynamicMatrix<U, B>& mat) const
+  {
+  auto result = imp.perform_operation(*this, mat);
+  return result;
+  }
@@ -0,0 +1,62 @@
+/*
+
+This class represents policy telling processors how many threads they may use
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+
+class ExecutionPolicy
+  {
+  // process_default is read when the policy is used, so processors can be constructed at compile time
+  static constexpr size_t use_default = static_cast<size_t>(-1);
+
+  size_t m_n_threads = use_default;
+
+  static std::atomic<size_t>& process_default()
+    {
+    static std::atomic<size_t> n_threads { 1 };
+    return n_threads;
+    }
+
+  constexpr explicit ExecutionPolicy(size_t n_threads) : m_n_threads(n_threads) {}
+
+  public:
+
+  /// <summary>
+  /// Thread count meaning "every hardware thread".
+  /// </summary>
+  static constexpr size_t all_threads = 0;
+
+  /// <summary>
+  /// Follows the process-wide default, which is serial unless changed by set_default().
+  /// </summary>
+  constexpr ExecutionPolicy() = default;
+
+  static constexpr ExecutionPolicy serial()
+    {
+    return ExecutionPolicy(1);
+    }
+
+  static constexpr ExecutionPolicy parallel(size_t n_threads = all_threads)
+    {
+    return ExecutionPolicy(n_threads);
+    }
+
+  /// <summary>
+  /// Changes policy used by processors constructed without an explicit one.
+  /// </summary>
+  static void set_default(const ExecutionPolicy& policy)
+    {
+    process_default().store(policy.get_n_threads(), std::memory_order_relaxed);
+    }
+
+  size_t get_n_threads() const
+    {
+    return m_n_threads == use_default ? process_default().load(std::memory_order_relaxed) : m_n_threads;
+    }
+  };
@@ -0,0 +1,254 @@
+/*
+
+This file contains fully unrolled products of 2x2, 3x3 and 4x4 matrices
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+#include "ConstantEvaluation.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIX_PROCESSING_FIXED_SSE2
+#include <immintrin.h>
+#endif
+
+/// <summary>
+/// This namespace contains kernels MultiplyMatrix uses for the smallest square products, where loop counters
+/// and the generic path cost more than the arithmetic. Selection happens at compile time from the dimensions:
+/// N x N times N x N and N x N times N x 1 for N from 2 to 4.
+/// Every element is summed in order of the inner index starting from zero, as in Gemm::multiply_small.
+/// Multiplication and addition are fused only when FMA is enabled at compile time.
+/// </summary>
+namespace MatrixProcessors { namespace FixedKernels {
+
+  template <size_t M, size_t K, size_t N>
+  constexpr bool is_unrolled = M == K && M >= 2 && M <= 4 && (N == M || N == 1);
+
+
+  namespace Detail {
+
+    // c[i * N + j] = sum of a[i * K + p] * b[p * N + j] over p, written out for every p
+    template <size_t K, size_t N, typename T, typename U, typename V, size_t... P>
+    constexpr V dot(const T* a_row, const U* b, size_t j, std::index_sequence<P...>)
+      {
+      V sum = 0;
+      ((sum += a_row[P] * b[P * N + j]), ...);
+      return sum;
+      }
+
+    template <size_t K, size_t N, typename T, typename U, typename V, size_t... J>
+    constexpr void row(const T* a_row, const U* b, V* c_row, std::index_sequence<J...>)
+      {
+      ((c_row[J] = dot<K, N, T, U, V>(a_row, b, J, std::make_index_sequence<K>{})), ...);
+      }
+
+    template <size_t M, size_t K, size_t N, typename T, typename U, typename V, size_t... I>
+    constexpr void unrolled(const T* a, const U* b, V* c, std::index_sequence<I...>)
+      {
+      (row<K, N, T, U, V>(a + I * K, b, c + I * N, std::make_index_sequence<N>{}), ...);
+      }
+
+
+#if defined(MATRIX_PROCESSING_FIXED_SSE2)
+
+    // acc + a * b, fused when FMA is enabled, as the compiler fuses sum += a * b of the plain loop then
+    inline __m128 multiply_add(__m128 a, __m128 b, __m128 acc)
+      {
+#if defined(__FMA__)
+      return _mm_fmadd_ps(a, b, acc);
+#else
+      return _mm_add_ps(acc, _mm_mul_ps(a, b));
+#endif
+      }
+
+    inline __m128d multiply_add(__m128d a, __m128d b, __m128d acc)
+      {
+#if defined(__FMA__)
+      return _mm_fmadd_pd(a, b, acc);
+#else
+      return _mm_add_pd(acc, _mm_mul_pd(a, b));
+#endif
+      }
+
+#if defined(__AVX__)
+    inline __m256d multiply_add(__m256d a, __m256d b, __m256d acc)
+      {
+#if defined(__FMA__)
+      return _mm256_fmadd_pd(a, b, acc);
+#else
+      return _mm256_add_pd(acc, _mm256_mul_pd(a, b));
+#endif
+      }
+#endif
+
+    // C row i = 0 + a[i][0] * B row 0 + a[i][1] * B row 1 + ..., one register per row of B
+    inline void multiply_4x4(const float* a, const float* b, float* c)
+      {
+      const __m128 b0 = _mm_loadu_ps(b);
+      const __m128 b1 = _mm_loadu_ps(b + 4);
+      const __m128 b2 = _mm_loadu_ps(b + 8);
+      const __m128 b3 = _mm_loadu_ps(b + 12);
+      for (size_t i = 0; i < 4; ++i)
+        {
+        __m128 acc = multiply_add(_mm_set1_ps(a[4 * i]), b0, _mm_setzero_ps());
+        acc = multiply_add(_mm_set1_ps(a[4 * i + 1]), b1, acc);
+        acc = multiply_add(_mm_set1_ps(a[4 * i + 2]), b2, acc);
+        acc = multiply_add(_mm_set1_ps(a[4 * i + 3]), b3, acc);
+        _mm_storeu_ps(c + 4 * i, acc);
+        }
+      }
+
+    // c = 0 + column 0 of A * b[0] + column 1 of A * b[1] + ..., columns come from transposing rows in registers
+    inline void multiply_4x1(const float* a, const float* b, float* c)
+      {
+      __m128 a0 = _mm_loadu_ps(a);
+      __m128 a1 = _mm_loadu_ps(a + 4);
+      __m128 a2 = _mm_loadu_ps(a + 8);
+      __m128 a3 = _mm_loadu_ps(a + 12);
+      _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+      __m128 acc = multiply_add(a0, _mm_set1_ps(b[0]), _mm_setzero_ps());
+      acc = multiply_add(a1, _mm_set1_ps(b[1]), acc);
+      acc = multiply_add(a2, _mm_set1_ps(b[2]), acc);
+      acc = multiply_add(a3, _mm_set1_ps(b[3]), acc);
+      _mm_storeu_ps(c, acc);
+      }
+
+    // whole 2x2 matrix in one register: [a00 a00 a10 a10] * [b00 b01 b00 b01] + [a01 a01 a11 a11] * [b10 b11 b10 b11]
+    inline void multiply_2x2(const float* a, const float* b, float* c)
+      {
+      const __m128 a_all = _mm_loadu_ps(a);
+      const __m128 b_all = _mm_loadu_ps(b);
+      const __m128 a_col0 = _mm_shuffle_ps(a_all, a_all, _MM_SHUFFLE(2, 2, 0, 0));
+      const __m128 a_col1 = _mm_shuffle_ps(a_all, a_all, _MM_SHUFFLE(3, 3, 1, 1));
+      const __m128 b_row0 = _mm_movelh_ps(b_all, b_all);
+      const __m128 b_row1 = _mm_movehl_ps(b_all, b_all);
+      const __m128 acc = multiply_add(a_col1, b_row1, multiply_add(a_col0, b_row0, _mm_setzero_ps()));
+      _mm_storeu_ps(c, acc);
+      }
+
+    inline void multiply_2x2(const double* a, const double* b, double* c)
+      {
+      const __m128d b0 = _mm_loadu_pd(b);
+      const __m128d b1 = _mm_loadu_pd(b + 2);
+      for (size_t i = 0; i < 2; ++i)
+        {
+        __m128d acc = multiply_add(_mm_set1_pd(a[2 * i]), b0, _mm_setzero_pd());
+        acc = multiply_add(_mm_set1_pd(a[2 * i + 1]), b1, acc);
+        _mm_storeu_pd(c + 2 * i, acc);
+        }
+      }
+
+#if defined(__AVX__)
+
+    inline void multiply_4x4(const double* a, const double* b, double* c)
+      {
+      const __m256d b0 = _mm256_loadu_pd(b);
+      const __m256d b1 = _mm256_loadu_pd(b + 4);
+      const __m256d b2 = _mm256_loadu_pd(b + 8);
+      const __m256d b3 = _mm256_loadu_pd(b + 12);
+      for (size_t i = 0; i < 4; ++i)
+        {
+        __m256d acc = multiply_add(_mm256_set1_pd(a[4 * i]), b0, _mm256_setzero_pd());
+        acc = multiply_add(_mm256_set1_pd(a[4 * i + 1]), b1, acc);
+        acc = multiply_add(_mm256_set1_pd(a[4 * i + 2]), b2, acc);
+        acc = multiply_add(_mm256_set1_pd(a[4 * i + 3]), b3, acc);
+        _mm256_storeu_pd(c + 4 * i, acc);
+        }
+      }
+
+    inline void multiply_4x1(const double* a, const double* b, double* c)
+      {
+      const __m256d r0 = _mm256_loadu_pd(a);
+      const __m256d r1 = _mm256_loadu_pd(a + 4);
+      const __m256d r2 = _mm256_loadu_pd(a + 8);
+      const __m256d r3 = _mm256_loadu_pd(a + 12);
+      const __m256d lo01 = _mm256_unpacklo_pd(r0, r1);
+      const __m256d hi01 = _mm256_unpackhi_pd(r0, r1);
+      const __m256d lo23 = _mm256_unpacklo_pd(r2, r3);
+      const __m256d hi23 = _mm256_unpackhi_pd(r2, r3);
+      const __m256d col0 = _mm256_permute2f128_pd(lo01, lo23, 0x20);
+      const __m256d col1 = _mm256_permute2f128_pd(hi01, hi23, 0x20);
+      const __m256d col2 = _mm256_permute2f128_pd(lo01, lo23, 0x31);
+      const __m256d col3 = _mm256_permute2f128_pd(hi01, hi23, 0x31);
+      __m256d acc = multiply_add(col0, _mm256_set1_pd(b[0]), _mm256_setzero_pd());
+      acc = multiply_add(col1, _mm256_set1_pd(b[1]), acc);
+      acc = multiply_add(col2, _mm256_set1_pd(b[2]), acc);
+      acc = multiply_add(col3, _mm256_set1_pd(b[3]), acc);
+      _mm256_storeu_pd(c, acc);
+      }
+
+#else
+
+    // rows of 4 doubles are two SSE2 registers each
+    inline void multiply_4x4(const double* a, const double* b, double* c)
+      {
+      for (size_t half = 0; half < 4; half += 2)
+        {
+        const __m128d b0 = _mm_loadu_pd(b + half);
+        const __m128d b1 = _mm_loadu_pd(b + 4 + half);
+        const __m128d b2 = _mm_loadu_pd(b + 8 + half);
+        const __m128d b3 = _mm_loadu_pd(b + 12 + half);
+        for (size_t i = 0; i < 4; ++i)
+          {
+          __m128d acc = multiply_add(_mm_set1_pd(a[4 * i]), b0, _mm_setzero_pd());
+          acc = multiply_add(_mm_set1_pd(a[4 * i + 1]), b1, acc);
+          acc = multiply_add(_mm_set1_pd(a[4 * i + 2]), b2, acc);
+          acc = multiply_add(_mm_set1_pd(a[4 * i + 3]), b3, acc);
+          _mm_storeu_pd(c + 4 * i + half, acc);
+          }
+        }
+      }
+
+#endif
+
+    template <size_t M, size_t N, typename T>
+    constexpr bool has_simd_kernel = (std::is_same_v<T, float> && ((M == 4 && (N == 4 || N == 1)) || (M == 2 && N == 2)))
+                                  || (std::is_same_v<T, double> && ((M == 4 && N == 4) || (M == 2 && N == 2)))
+#if defined(__AVX__)
+                                  || (std::is_same_v<T, double> && M == 4 && N == 1)
+#endif
+                                  ;
+
+#endif
+
+    }
+
+
+  /// <summary>
+  /// c = a * b for row-major M x K matrix a, K x N matrix b and M x N matrix c, where is_unrolled<M, K, N>.
+  /// float and double operands of one type take SSE2 or AVX kernels, 3x3 and all other types take
+  /// unrolled scalar code, which the compiler vectorizes where it can. c must not overlap a or b.
+  /// </summary>
+  template <size_t M, size_t K, size_t N, typename T, typename U, typename V>
+  constexpr void multiply(const T* a, const U* b, V* c)
+    {
+    static_assert(is_unrolled<M, K, N>, "There is no unrolled kernel for this shape");
+#if defined(MATRIX_PROCESSING_FIXED_SSE2)
+    if constexpr (std::is_same_v<T, U> && std::is_same_v<T, V> && Detail::has_simd_kernel<M, N, T>)
+      {
+      if (!ConstantEvaluation::is_constant_evaluated())
+        {
+        if constexpr (M == 2)
+          {
+          Detail::multiply_2x2(a, b, c);
+          }
+        else if constexpr (N == 1)
+          {
+          Detail::multiply_4x1(a, b, c);
+          }
+        else
+          {
+          Detail::multiply_4x4(a, b, c);
+          }
+        return;
+        }
+      }
+#endif
+    Detail::unrolled<M, K, N>(a, b, c, std::make_index_sequence<M>{});
+    }
+
+  } }
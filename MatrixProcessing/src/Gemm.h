@@ -0,0 +1,827 @@
+/*
+
+This file contains cache-blocked, register-tiled matrix multiplication engine
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "AlignedAllocator.h"
+#include "ThreadPool.h"
+#include "Simd.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIX_PROCESSING_GEMM_PAIRS
+#include <immintrin.h>
+#endif
+
+/// <summary>
+/// This namespace contains GEMM engine used by MultiplyMatrix for large products
+/// </summary>
+namespace MatrixProcessors { namespace Gemm {
+
+  /// <summary>
+  /// Products with R1*C1_R2*C2 not greater than this value are computed by the plain loop,
+  /// packing buffers simply do not pay off for them.
+  /// </summary>
+  constexpr size_t small_product_threshold = 32 * 32 * 32;
+
+
+  /// <summary>
+  /// Micro-kernel families of the engine. PortableKernel is plain C++ vectorized by the compiler for the
+  /// baseline instruction set, Avx2Kernel uses 256-bit FMA intrinsics compiled with per-function target.
+  /// The engine takes Avx2Kernel at run time when Simd::fma_enabled(), whatever flags the build used.
+  /// </summary>
+  struct PortableKernel {};
+  struct Avx2Kernel {};
+
+
+  /// <summary>
+  /// Blocking parameters for the accumulation type T and kernel family K.
+  /// MR x NR is the register tile of the micro-kernel, KC x NR sliver of B is kept in L1,
+  /// MC x KC block of A is kept in L2 and KC x NC panel of B is kept in L3.
+  /// </summary>
+  template <typename T, typename K = PortableKernel>
+  struct Blocking
+    {
+    static constexpr size_t MR = 4;
+    static constexpr size_t NR = 8;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 64;
+    static constexpr size_t NC = 4096;
+    };
+
+  // tiles sized for sixteen 128-bit registers
+  template <>
+  struct Blocking<float, PortableKernel>
+    {
+    static constexpr size_t MR = 4;
+    static constexpr size_t NR = 8;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 128;
+    static constexpr size_t NC = 4096;
+    };
+
+  template <>
+  struct Blocking<double, PortableKernel>
+    {
+    static constexpr size_t MR = 4;
+    static constexpr size_t NR = 4;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 96;
+    static constexpr size_t NC = 4096;
+    };
+
+  template <>
+  struct Blocking<float, Avx2Kernel>
+    {
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 16;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 96;
+    static constexpr size_t NC = 4080;
+    };
+
+  template <>
+  struct Blocking<double, Avx2Kernel>
+    {
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 8;
+    static constexpr size_t KC = 256;
+    static constexpr size_t MC = 72;
+    static constexpr size_t NC = 4080;
+    };
+
+
+  /// <summary>
+  /// Tells whether V has an Avx2Kernel micro-kernel compiled in.
+  /// </summary>
+  template <typename V>
+  constexpr bool has_avx2_kernel =
+#if defined(MATRIX_PROCESSING_X86)
+    std::is_same_v<V, float> || std::is_same_v<V, double>;
+#else
+    false;
+#endif
+
+
+  /// <summary>
+  /// Copies mc x kc block of A into MR-row micro-panels, converting elements to V.
+  /// Rows beyond mc are padded with zeros so the micro-kernel never checks bounds.
+  /// </summary>
+  template <typename V, typename K, typename T>
+  void pack_a(size_t mc, size_t kc, const T* a, size_t rsa, size_t csa, V* buf)
+    {
+    constexpr size_t MR = Blocking<V, K>::MR;
+
+    for (size_t ir = 0; ir < mc; ir += MR)
+      {
+      const size_t mr = std::min(MR, mc - ir);
+      for (size_t p = 0; p < kc; ++p)
+        {
+        for (size_t i = 0; i < MR; ++i)
+          {
+          buf[i] = i < mr ? static_cast<V>(a[(ir + i) * rsa + p * csa]) : V(0);
+          }
+        buf += MR;
+        }
+      }
+    }
+
+
+  /// <summary>
+  /// Copies kc x nc panel of B into NR-column micro-panels, converting elements to V.
+  /// Columns beyond nc are padded with zeros.
+  /// </summary>
+  template <typename V, typename K, typename U>
+  void pack_b(size_t kc, size_t nc, const U* b, size_t rsb, size_t csb, V* buf)
+    {
+    constexpr size_t NR = Blocking<V, K>::NR;
+
+    for (size_t jr = 0; jr < nc; jr += NR)
+      {
+      const size_t nr = std::min(NR, nc - jr);
+      for (size_t p = 0; p < kc; ++p)
+        {
+        for (size_t j = 0; j < NR; ++j)
+          {
+          buf[j] = j < nr ? static_cast<V>(b[p * rsb + (jr + j) * csb]) : V(0);
+          }
+        buf += NR;
+        }
+      }
+    }
+
+
+  /// <summary>
+  /// Computes MR x NR tile acc = a * b over kc packed elements.
+  /// </summary>
+  template <typename V>
+  void micro_kernel(size_t kc, const V* a, const V* b, V* acc, PortableKernel)
+    {
+    constexpr size_t MR = Blocking<V>::MR;
+    constexpr size_t NR = Blocking<V>::NR;
+
+    V c[MR][NR] = {};
+    for (size_t p = 0; p < kc; ++p)
+      {
+      for (size_t i = 0; i < MR; ++i)
+        {
+        const V a_i = a[i];
+        for (size_t j = 0; j < NR; ++j)
+          {
+          c[i][j] += a_i * b[j];
+          }
+        }
+      a += MR;
+      b += NR;
+      }
+
+    for (size_t i = 0; i < MR; ++i)
+      {
+      for (size_t j = 0; j < NR; ++j)
+        {
+        acc[i * NR + j] = c[i][j];
+        }
+      }
+    }
+
+
+#if defined(MATRIX_PROCESSING_X86)
+
+  // 6x16 tile kept in twelve ymm accumulators
+  MATRIX_PROCESSING_TARGET("avx2,fma") inline void micro_kernel(size_t kc, const float* a, const float* b, float* acc, Avx2Kernel)
+    {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+    for (size_t p = 0; p < kc; ++p)
+      {
+      const __m256 b0 = _mm256_loadu_ps(b);
+      const __m256 b1 = _mm256_loadu_ps(b + 8);
+      __m256 a_i;
+      a_i = _mm256_broadcast_ss(a + 0); c00 = _mm256_fmadd_ps(a_i, b0, c00); c01 = _mm256_fmadd_ps(a_i, b1, c01);
+      a_i = _mm256_broadcast_ss(a + 1); c10 = _mm256_fmadd_ps(a_i, b0, c10); c11 = _mm256_fmadd_ps(a_i, b1, c11);
+      a_i = _mm256_broadcast_ss(a + 2); c20 = _mm256_fmadd_ps(a_i, b0, c20); c21 = _mm256_fmadd_ps(a_i, b1, c21);
+      a_i = _mm256_broadcast_ss(a + 3); c30 = _mm256_fmadd_ps(a_i, b0, c30); c31 = _mm256_fmadd_ps(a_i, b1, c31);
+      a_i = _mm256_broadcast_ss(a + 4); c40 = _mm256_fmadd_ps(a_i, b0, c40); c41 = _mm256_fmadd_ps(a_i, b1, c41);
+      a_i = _mm256_broadcast_ss(a + 5); c50 = _mm256_fmadd_ps(a_i, b0, c50); c51 = _mm256_fmadd_ps(a_i, b1, c51);
+      a += 6;
+      b += 16;
+      }
+
+    _mm256_storeu_ps(acc + 0,  c00); _mm256_storeu_ps(acc + 8,  c01);
+    _mm256_storeu_ps(acc + 16, c10); _mm256_storeu_ps(acc + 24, c11);
+    _mm256_storeu_ps(acc + 32, c20); _mm256_storeu_ps(acc + 40, c21);
+    _mm256_storeu_ps(acc + 48, c30); _mm256_storeu_ps(acc + 56, c31);
+    _mm256_storeu_ps(acc + 64, c40); _mm256_storeu_ps(acc + 72, c41);
+    _mm256_storeu_ps(acc + 80, c50); _mm256_storeu_ps(acc + 88, c51);
+    }
+
+
+  // 6x8 tile kept in twelve ymm accumulators
+  MATRIX_PROCESSING_TARGET("avx2,fma") inline void micro_kernel(size_t kc, const double* a, const double* b, double* acc, Avx2Kernel)
+    {
+    __m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd();
+    __m256d c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+    __m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd();
+    __m256d c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+    __m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd();
+    __m256d c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+
+    for (size_t p = 0; p < kc; ++p)
+      {
+      const __m256d b0 = _mm256_loadu_pd(b);
+      const __m256d b1 = _mm256_loadu_pd(b + 4);
+      __m256d a_i;
+      a_i = _mm256_broadcast_sd(a + 0); c00 = _mm256_fmadd_pd(a_i, b0, c00); c01 = _mm256_fmadd_pd(a_i, b1, c01);
+      a_i = _mm256_broadcast_sd(a + 1); c10 = _mm256_fmadd_pd(a_i, b0, c10); c11 = _mm256_fmadd_pd(a_i, b1, c11);
+      a_i = _mm256_broadcast_sd(a + 2); c20 = _mm256_fmadd_pd(a_i, b0, c20); c21 = _mm256_fmadd_pd(a_i, b1, c21);
+      a_i = _mm256_broadcast_sd(a + 3); c30 = _mm256_fmadd_pd(a_i, b0, c30); c31 = _mm256_fmadd_pd(a_i, b1, c31);
+      a_i = _mm256_broadcast_sd(a + 4); c40 = _mm256_fmadd_pd(a_i, b0, c40); c41 = _mm256_fmadd_pd(a_i, b1, c41);
+      a_i = _mm256_broadcast_sd(a + 5); c50 = _mm256_fmadd_pd(a_i, b0, c50); c51 = _mm256_fmadd_pd(a_i, b1, c51);
+      a += 6;
+      b += 8;
+      }
+
+    _mm256_storeu_pd(acc + 0,  c00); _mm256_storeu_pd(acc + 4,  c01);
+    _mm256_storeu_pd(acc + 8,  c10); _mm256_storeu_pd(acc + 12, c11);
+    _mm256_storeu_pd(acc + 16, c20); _mm256_storeu_pd(acc + 20, c21);
+    _mm256_storeu_pd(acc + 24, c30); _mm256_storeu_pd(acc + 28, c31);
+    _mm256_storeu_pd(acc + 32, c40); _mm256_storeu_pd(acc + 36, c41);
+    _mm256_storeu_pd(acc + 40, c50); _mm256_storeu_pd(acc + 44, c51);
+    }
+
+#endif
+
+
+  /// <summary>
+  /// Writes valid mr x nr part of the register tile to C.
+  /// The first kc block overwrites C, the following ones accumulate into it.
+  /// </summary>
+  template <typename V, size_t NR = Blocking<V>::NR>
+  void write_back(const V* acc, V* c, size_t rsc, size_t mr, size_t nr, bool accumulate)
+    {
+    for (size_t i = 0; i < mr; ++i)
+      {
+      V* c_row = c + i * rsc;
+      const V* acc_row = acc + i * NR;
+      if (accumulate)
+        {
+        for (size_t j = 0; j < nr; ++j)
+          {
+          c_row[j] += acc_row[j];
+          }
+        }
+      else
+        {
+        for (size_t j = 0; j < nr; ++j)
+          {
+          c_row[j] = acc_row[j];
+          }
+        }
+      }
+    }
+
+  /// <summary>
+  /// Same as above for C = alpha * tile + beta * C. beta equal to zero overwrites C without reading it,
+  /// so NaN or garbage there doesn`t reach the result. alpha = 1 with beta = 0 or 1 takes the plain loops.
+  /// </summary>
+  template <typename V, size_t NR = Blocking<V>::NR>
+  void write_back(const V* acc, V* c, size_t rsc, size_t mr, size_t nr, V alpha, V beta)
+    {
+    if (alpha == V(1) && (beta == V(0) || beta == V(1)))
+      {
+      write_back<V, NR>(acc, c, rsc, mr, nr, beta == V(1));
+      return;
+      }
+    for (size_t i = 0; i < mr; ++i)
+      {
+      V* c_row = c + i * rsc;
+      const V* acc_row = acc + i * NR;
+      if (beta == V(0))
+        {
+        for (size_t j = 0; j < nr; ++j)
+          {
+          c_row[j] = alpha * acc_row[j];
+          }
+        }
+      else
+        {
+        for (size_t j = 0; j < nr; ++j)
+          {
+          c_row[j] = alpha * acc_row[j] + beta * c_row[j];
+          }
+        }
+      }
+    }
+
+
+  /// <summary>
+  /// Accumulates C += A * B with the plain loop, all three matrices are row-major and contiguous.
+  /// Used for products too small to pay for packing.
+  /// </summary>
+  template <typename T, typename U, typename V>
+  constexpr void multiply_small(size_t m, size_t n, size_t k, const T* a, const U* b, V* c)
+    {
+    for (size_t i = 0; i < m; ++i)
+      {
+      for (size_t j = 0; j < n; ++j)
+        {
+        for (size_t p = 0; p < k; ++p)
+          {
+          c[i * n + j] += a[i * k + p] * b[p * n + j];
+          }
+        }
+      }
+    }
+
+
+  /// <summary>
+  /// Same as above for A and B addressed through row and column strides, C is row-major with row stride rsc.
+  /// The inner loop runs along rows of B and C, so transposed A costs nothing extra.
+  /// Every element of C is still summed in order of p, results match the contiguous version.
+  /// </summary>
+  template <typename T, typename U, typename V>
+  void multiply_small(size_t m, size_t n, size_t k,
+                      const T* a, size_t rsa, size_t csa,
+                      const U* b, size_t rsb, size_t csb,
+                      V* c, size_t rsc)
+    {
+    for (size_t i = 0; i < m; ++i)
+      {
+      V* c_row = c + i * rsc;
+      for (size_t p = 0; p < k; ++p)
+        {
+        const T a_ip = a[i * rsa + p * csa];
+        const U* b_row = b + p * rsb;
+        for (size_t j = 0; j < n; ++j)
+          {
+          c_row[j] += a_ip * b_row[j * csb];
+          }
+        }
+      }
+    }
+
+  /// <summary>
+  /// C = alpha * A * B + beta * C with the loop above, accumulated straight into C: every row of C is scaled by beta
+  /// first, beta = 0 overwrites it without reading, then alpha * a[i][p] * b[p][j] is added in order of p.
+  /// </summary>
+  template <typename T, typename U, typename V>
+  void multiply_add_small(size_t m, size_t n, size_t k, V alpha,
+                          const T* a, size_t rsa, size_t csa,
+                          const U* b, size_t rsb, size_t csb,
+                          V beta, V* c, size_t rsc)
+    {
+    for (size_t i = 0; i < m; ++i)
+      {
+      V* c_row = c + i * rsc;
+      if (beta == V(0))
+        {
+        std::fill(c_row, c_row + n, V(0));
+        }
+      else if (beta != V(1))
+        {
+        for (size_t j = 0; j < n; ++j)
+          {
+          c_row[j] = beta * c_row[j];
+          }
+        }
+      for (size_t p = 0; p < k; ++p)
+        {
+        const V a_ip = alpha * V(a[i * rsa + p * csa]);
+        const U* b_row = b + p * rsb;
+        for (size_t j = 0; j < n; ++j)
+          {
+          c_row[j] += a_ip * b_row[j * csb];
+          }
+        }
+      }
+    }
+
+
+  /// <summary>
+  /// Products with fewer multiply-adds than this are always computed by one thread.
+  /// </summary>
+  constexpr size_t parallel_product_threshold = 128 * 128 * 128;
+
+
+  /// <summary>
+  /// Loop nest of multiply_add below with the micro-kernel family K, k must not be zero.
+  /// </summary>
+  template <typename K, typename T, typename U, typename V>
+  void multiply_add_tiled(size_t m, size_t n, size_t k, V alpha,
+                          const T* a, size_t rsa, size_t csa,
+                          const U* b, size_t rsb, size_t csb,
+                          V beta, V* c, size_t rsc,
+                          const ExecutionPolicy& policy)
+    {
+    constexpr size_t MR = Blocking<V, K>::MR;
+    constexpr size_t NR = Blocking<V, K>::NR;
+    constexpr size_t KC = Blocking<V, K>::KC;
+    constexpr size_t MC = Blocking<V, K>::MC;
+    constexpr size_t NC = Blocking<V, K>::NC;
+
+    const ExecutionPolicy& effective_policy = m * n * k < parallel_product_threshold ? ExecutionPolicy::serial() : policy;
+    const size_t n_threads = ThreadPool::resolve_n_threads(effective_policy);
+
+    // packed panel of B is shared by all threads, blocks of A are packed by each thread on its own
+    thread_local std::vector<V, AlignedAllocator<V>> b_buf;
+    b_buf.resize(std::max(b_buf.size(), (std::min(NC, n) + NR - 1) / NR * NR * std::min(KC, k)));
+    V* const b_packed = b_buf.data();
+
+    for (size_t jc = 0; jc < n; jc += NC)
+      {
+      const size_t nc = std::min(NC, n - jc);
+      const size_t n_panels = (nc + NR - 1) / NR;
+
+      const size_t n_ic = (m + MC - 1) / MC;
+      const size_t n_jg = std::min(n_panels, std::max<size_t>(1, (2 * n_threads + n_ic - 1) / n_ic));
+      const size_t panels_per_group = (n_panels + n_jg - 1) / n_jg;
+
+      for (size_t pc = 0; pc < k; pc += KC)
+        {
+        const size_t kc = std::min(KC, k - pc);
+
+        parallel_for(effective_policy, n_panels, 1, [&](size_t first, size_t last)
+          {
+          const size_t jr = first * NR;
+          pack_b<V, K>(kc, std::min(nc, last * NR) - jr, b + pc * rsb + (jc + jr) * csb, rsb, csb, b_packed + jr * kc);
+          });
+
+        parallel_for(effective_policy, n_ic * n_jg, 1, [&](size_t first, size_t last)
+          {
+          thread_local std::vector<V, AlignedAllocator<V>> a_buf;
+          a_buf.resize(std::max(a_buf.size(), MC * KC));
+          alignas(64) V acc[MR * NR];
+
+          for (size_t task = first; task < last; ++task)
+            {
+            const size_t ic = task / n_jg * MC;
+            const size_t mc = std::min(MC, m - ic);
+            const size_t jr_begin = task % n_jg * panels_per_group * NR;
+            const size_t jr_end = std::min(nc, jr_begin + panels_per_group * NR);
+            if (jr_begin >= jr_end)
+              {
+              continue;
+              }
+
+            pack_a<V, K>(mc, kc, a + ic * rsa + pc * csa, rsa, csa, a_buf.data());
+
+            for (size_t jr = jr_begin; jr < jr_end; jr += NR)
+              {
+              const size_t nr = std::min(NR, nc - jr);
+              const V* b_panel = b_packed + jr * kc;
+
+              for (size_t ir = 0; ir < mc; ir += MR)
+                {
+                const size_t mr = std::min(MR, mc - ir);
+                micro_kernel(kc, a_buf.data() + ir * kc, b_panel, acc, K{});
+                write_back<V, NR>(acc, c + (ic + ir) * rsc + jc + jr, rsc, mr, nr, alpha, pc == 0 ? beta : V(1));
+                }
+              }
+            }
+          });
+        }
+      }
+    }
+
+
+  /// <summary>
+  /// Computes C = alpha * A * B + beta * C, where A is m x k, B is k x n and C is m x n.
+  /// A and B are addressed through row and column strides, C is row-major with row stride rsc.
+  /// Scaling is applied where register tiles are written back: the first kc block stores alpha * tile + beta * C,
+  /// the following ones add alpha * tile, so C is passed over once per kc block as in the plain product.
+  /// With parallel policy every packed block of A is split into output tiles computed by different
+  /// threads. Each element of C is still reduced in the same order, so results match the serial run bit for bit.
+  /// The micro-kernel is picked per call: Avx2Kernel for float and double when Simd::fma_enabled(), PortableKernel otherwise.
+  /// </summary>
+  template <typename T, typename U, typename V>
+  void multiply_add(size_t m, size_t n, size_t k, V alpha,
+                    const T* a, size_t rsa, size_t csa,
+                    const U* b, size_t rsb, size_t csb,
+                    V beta, V* c, size_t rsc,
+                    const ExecutionPolicy& policy = ExecutionPolicy::serial())
+    {
+    if (k == 0)
+      {
+      // empty product, only C is scaled
+      for (size_t i = 0; i < m; ++i)
+        {
+        V* c_row = c + i * rsc;
+        for (size_t j = 0; j < n; ++j)
+          {
+          c_row[j] = beta == V(0) ? V(0) : beta * c_row[j];
+          }
+        }
+      return;
+      }
+
+    if constexpr (has_avx2_kernel<V>)
+      {
+      if (Simd::fma_enabled())
+        {
+        multiply_add_tiled<Avx2Kernel>(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, policy);
+        return;
+        }
+      }
+    multiply_add_tiled<PortableKernel>(m, n, k, alpha, a, rsa, csa, b, rsb, csb, beta, c, rsc, policy);
+    }
+
+
+  /// <summary>
+  /// Computes C = A * B, or C += A * B when accumulate is set.
+  /// </summary>
+  template <typename T, typename U, typename V>
+  void multiply(size_t m, size_t n, size_t k,
+                const T* a, size_t rsa, size_t csa,
+                const U* b, size_t rsb, size_t csb,
+                V* c, size_t rsc,
+                const ExecutionPolicy& policy = ExecutionPolicy::serial(),
+                bool accumulate = false)
+    {
+    multiply_add(m, n, k, V(1), a, rsa, csa, b, rsb, csb, accumulate ? V(1) : V(0), c, rsc, policy);
+    }
+
+  /// <summary>
+  /// Products of 8-bit integers accumulated in int32 take the engine below: operands are packed as pairs
+  /// of int16 along the inner index and pmaddwd multiplies two pairs and adds them in every int32 lane,
+  /// twice the multiply-adds of float FMA per instruction. Available wherever SSE2 is.
+  /// </summary>
+  template <typename T, typename U, typename V>
+  constexpr bool has_pair_kernel =
+#if defined(MATRIX_PROCESSING_GEMM_PAIRS)
+    std::is_same_v<V, int32_t> && std::is_integral_v<T> && std::is_integral_v<U> && sizeof(T) == 1 && sizeof(U) == 1;
+#else
+    false;
+#endif
+
+#if defined(MATRIX_PROCESSING_GEMM_PAIRS)
+
+  /// <summary>
+  /// Blocking of the pair engine, KC counts elements of the inner index, i.e. KC / 2 packed pairs.
+  /// </summary>
+  template <typename K>
+  struct PairBlocking
+    {
+    static constexpr size_t MR = 4;
+    static constexpr size_t NR = 8;
+    static constexpr size_t KC = 512;
+    static constexpr size_t MC = 96;
+    static constexpr size_t NC = 4080;
+    };
+
+  template <>
+  struct PairBlocking<Avx2Kernel>
+    {
+    static constexpr size_t MR = 6;
+    static constexpr size_t NR = 16;
+    static constexpr size_t KC = 512;
+    static constexpr size_t MC = 96;
+    static constexpr size_t NC = 4080;
+    };
+
+
+  inline int32_t pack_pair(int32_t lo, int32_t hi)
+    {
+    return static_cast<int32_t>((uint32_t(uint16_t(lo)) | (uint32_t(uint16_t(hi)) << 16)));
+    }
+
+  /// <summary>
+  /// Copies mc x kc block of A into MR-row micro-panels of pairs (a[i][2q], a[i][2q + 1]), zero padded.
+  /// </summary>
+  template <typename K, typename T>
+  void pack_pairs_a(size_t mc, size_t kc, const T* a, size_t rsa, size_t csa, int32_t* buf)
+    {
+    constexpr size_t MR = PairBlocking<K>::MR;
+
+    for (size_t ir = 0; ir < mc; ir += MR)
+      {
+      const size_t mr = std::min(MR, mc - ir);
+      for (size_t p = 0; p < kc; p += 2)
+        {
+        for (size_t i = 0; i < MR; ++i)
+          {
+          const T* a_i = a + (ir + i) * rsa;
+          buf[i] = i < mr ? pack_pair(a_i[p * csa], p + 1 < kc ? a_i[(p + 1) * csa] : 0) : 0;
+          }
+        buf += MR;
+        }
+      }
+    }
+
+  /// <summary>
+  /// Copies kc x nc panel of B into NR-column micro-panels of pairs (b[2q][j], b[2q + 1][j]), zero padded.
+  /// </summary>
+  template <typename K, typename U>
+  void pack_pairs_b(size_t kc, size_t nc, const U* b, size_t rsb, size_t csb, int32_t* buf)
+    {
+    constexpr size_t NR = PairBlocking<K>::NR;
+
+    for (size_t jr = 0; jr < nc; jr += NR)
+      {
+      const size_t nr = std::min(NR, nc - jr);
+      for (size_t p = 0; p < kc; p += 2)
+        {
+        for (size_t j = 0; j < NR; ++j)
+          {
+          const U* b_j = b + (jr + j) * csb;
+          buf[j] = j < nr ? pack_pair(b_j[p * rsb], p + 1 < kc ? b_j[(p + 1) * rsb] : 0) : 0;
+          }
+        buf += NR;
+        }
+      }
+    }
+
+
+  // 6x16 tile kept in twelve ymm accumulators, every madd adds two products to each of 8 lanes
+  MATRIX_PROCESSING_TARGET("avx2") inline void pair_kernel(size_t n_pairs, const int32_t* a, const int32_t* b, int32_t* acc, Avx2Kernel)
+    {
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+    __m256i c40 = _mm256_setzero_si256(), c41 = _mm256_setzero_si256();
+    __m256i c50 = _mm256_setzero_si256(), c51 = _mm256_setzero_si256();
+
+    for (size_t q = 0; q < n_pairs; ++q)
+      {
+      const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+      const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 8));
+      __m256i a_i;
+      a_i = _mm256_set1_epi32(a[0]); c00 = _mm256_add_epi32(c00, _mm256_madd_epi16(a_i, b0)); c01 = _mm256_add_epi32(c01, _mm256_madd_epi16(a_i, b1));
+      a_i = _mm256_set1_epi32(a[1]); c10 = _mm256_add_epi32(c10, _mm256_madd_epi16(a_i, b0)); c11 = _mm256_add_epi32(c11, _mm256_madd_epi16(a_i, b1));
+      a_i = _mm256_set1_epi32(a[2]); c20 = _mm256_add_epi32(c20, _mm256_madd_epi16(a_i, b0)); c21 = _mm256_add_epi32(c21, _mm256_madd_epi16(a_i, b1));
+      a_i = _mm256_set1_epi32(a[3]); c30 = _mm256_add_epi32(c30, _mm256_madd_epi16(a_i, b0)); c31 = _mm256_add_epi32(c31, _mm256_madd_epi16(a_i, b1));
+      a_i = _mm256_set1_epi32(a[4]); c40 = _mm256_add_epi32(c40, _mm256_madd_epi16(a_i, b0)); c41 = _mm256_add_epi32(c41, _mm256_madd_epi16(a_i, b1));
+      a_i = _mm256_set1_epi32(a[5]); c50 = _mm256_add_epi32(c50, _mm256_madd_epi16(a_i, b0)); c51 = _mm256_add_epi32(c51, _mm256_madd_epi16(a_i, b1));
+      a += 6;
+      b += 16;
+      }
+
+    __m256i* out = reinterpret_cast<__m256i*>(acc);
+    _mm256_storeu_si256(out + 0, c00);  _mm256_storeu_si256(out + 1, c01);
+    _mm256_storeu_si256(out + 2, c10);  _mm256_storeu_si256(out + 3, c11);
+    _mm256_storeu_si256(out + 4, c20);  _mm256_storeu_si256(out + 5, c21);
+    _mm256_storeu_si256(out + 6, c30);  _mm256_storeu_si256(out + 7, c31);
+    _mm256_storeu_si256(out + 8, c40);  _mm256_storeu_si256(out + 9, c41);
+    _mm256_storeu_si256(out + 10, c50); _mm256_storeu_si256(out + 11, c51);
+    }
+
+
+  // 4x8 tile kept in eight xmm accumulators
+  inline void pair_kernel(size_t n_pairs, const int32_t* a, const int32_t* b, int32_t* acc, PortableKernel)
+    {
+    __m128i c00 = _mm_setzero_si128(), c01 = _mm_setzero_si128();
+    __m128i c10 = _mm_setzero_si128(), c11 = _mm_setzero_si128();
+    __m128i c20 = _mm_setzero_si128(), c21 = _mm_setzero_si128();
+    __m128i c30 = _mm_setzero_si128(), c31 = _mm_setzero_si128();
+
+    for (size_t q = 0; q < n_pairs; ++q)
+      {
+      const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+      const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 4));
+      __m128i a_i;
+      a_i = _mm_set1_epi32(a[0]); c00 = _mm_add_epi32(c00, _mm_madd_epi16(a_i, b0)); c01 = _mm_add_epi32(c01, _mm_madd_epi16(a_i, b1));
+      a_i = _mm_set1_epi32(a[1]); c10 = _mm_add_epi32(c10, _mm_madd_epi16(a_i, b0)); c11 = _mm_add_epi32(c11, _mm_madd_epi16(a_i, b1));
+      a_i = _mm_set1_epi32(a[2]); c20 = _mm_add_epi32(c20, _mm_madd_epi16(a_i, b0)); c21 = _mm_add_epi32(c21, _mm_madd_epi16(a_i, b1));
+      a_i = _mm_set1_epi32(a[3]); c30 = _mm_add_epi32(c30, _mm_madd_epi16(a_i, b0)); c31 = _mm_add_epi32(c31, _mm_madd_epi16(a_i, b1));
+      a += 4;
+      b += 8;
+      }
+
+    __m128i* out = reinterpret_cast<__m128i*>(acc);
+    _mm_storeu_si128(out + 0, c00); _mm_storeu_si128(out + 1, c01);
+    _mm_storeu_si128(out + 2, c10); _mm_storeu_si128(out + 3, c11);
+    _mm_storeu_si128(out + 4, c20); _mm_storeu_si128(out + 5, c21);
+    _mm_storeu_si128(out + 6, c30); _mm_storeu_si128(out + 7, c31);
+    }
+
+
+  /// <summary>
+  /// Loop nest of multiply_pairs below with the pair kernel family K, k must not be zero.
+  /// </summary>
+  template <typename K, typename T, typename U>
+  void multiply_pairs_tiled(size_t m, size_t n, size_t k,
+                            const T* a, size_t rsa, size_t csa,
+                            const U* b, size_t rsb, size_t csb,
+                            int32_t* c, size_t rsc,
+                            const ExecutionPolicy& policy, bool accumulate)
+    {
+    constexpr size_t MR = PairBlocking<K>::MR;
+    constexpr size_t NR = PairBlocking<K>::NR;
+    constexpr size_t KC = PairBlocking<K>::KC;
+    constexpr size_t MC = PairBlocking<K>::MC;
+    constexpr size_t NC = PairBlocking<K>::NC;
+
+    const ExecutionPolicy& effective_policy = m * n * k < parallel_product_threshold ? ExecutionPolicy::serial() : policy;
+    const size_t n_threads = ThreadPool::resolve_n_threads(effective_policy);
+
+    thread_local std::vector<int32_t, AlignedAllocator<int32_t>> b_buf;
+    b_buf.resize(std::max(b_buf.size(), (std::min(NC, n) + NR - 1) / NR * NR * ((std::min(KC, k) + 1) / 2)));
+    int32_t* const b_packed = b_buf.data();
+
+    for (size_t jc = 0; jc < n; jc += NC)
+      {
+      const size_t nc = std::min(NC, n - jc);
+      const size_t n_panels = (nc + NR - 1) / NR;
+
+      const size_t n_ic = (m + MC - 1) / MC;
+      const size_t n_jg = std::min(n_panels, std::max<size_t>(1, (2 * n_threads + n_ic - 1) / n_ic));
+      const size_t panels_per_group = (n_panels + n_jg - 1) / n_jg;
+
+      for (size_t pc = 0; pc < k; pc += KC)
+        {
+        const size_t kc = std::min(KC, k - pc);
+        const size_t n_pairs = (kc + 1) / 2;
+
+        parallel_for(effective_policy, n_panels, 1, [&](size_t first, size_t last)
+          {
+          const size_t jr = first * NR;
+          pack_pairs_b<K>(kc, std::min(nc, last * NR) - jr, b + pc * rsb + (jc + jr) * csb, rsb, csb, b_packed + jr * n_pairs);
+          });
+
+        parallel_for(effective_policy, n_ic * n_jg, 1, [&](size_t first, size_t last)
+          {
+          thread_local std::vector<int32_t, AlignedAllocator<int32_t>> a_buf;
+          a_buf.resize(std::max(a_buf.size(), MC * KC / 2));
+          alignas(64) int32_t acc[MR * NR];
+
+          for (size_t task = first; task < last; ++task)
+            {
+            const size_t ic = task / n_jg * MC;
+            const size_t mc = std::min(MC, m - ic);
+            const size_t jr_begin = task % n_jg * panels_per_group * NR;
+            const size_t jr_end = std::min(nc, jr_begin + panels_per_group * NR);
+            if (jr_begin >= jr_end)
+              {
+              continue;
+              }
+
+            pack_pairs_a<K>(mc, kc, a + ic * rsa + pc * csa, rsa, csa, a_buf.data());
+
+            for (size_t jr = jr_begin; jr < jr_end; jr += NR)
+              {
+              const size_t nr = std::min(NR, nc - jr);
+              const int32_t* b_panel = b_packed + jr * n_pairs;
+
+              for (size_t ir = 0; ir < mc; ir += MR)
+                {
+                const size_t mr = std::min(MR, mc - ir);
+                pair_kernel(n_pairs, a_buf.data() + ir * n_pairs, b_panel, acc, K{});
+                write_back<int32_t, NR>(acc, c + (ic + ir) * rsc + jc + jr, rsc, mr, nr, accumulate || pc != 0);
+                }
+              }
+            }
+          });
+        }
+      }
+    }
+
+
+  /// <summary>
+  /// Computes C = A * B in int32 for 8-bit A and B, or C += A * B when accumulate is set.
+  /// Same loop nest and division of work between threads as multiply above, so integer results
+  /// don`t depend on the policy. The 6x16 AVX2 kernel is taken when Simd reports AVX2, the 4x8 SSE2 one otherwise.
+  /// </summary>
+  template <typename T, typename U>
+  void multiply_pairs(size_t m, size_t n, size_t k,
+                      const T* a, size_t rsa, size_t csa,
+                      const U* b, size_t rsb, size_t csb,
+                      int32_t* c, size_t rsc,
+                      const ExecutionPolicy& policy = ExecutionPolicy::serial(),
+                      bool accumulate = false)
+    {
+    if (k == 0)
+      {
+      if (accumulate)
+        {
+        return;
+        }
+      for (size_t i = 0; i < m; ++i)
+        {
+        std::fill(c + i * rsc, c + i * rsc + n, 0);
+        }
+      return;
+      }
+
+    if (Simd::active_instruction_set() >= Simd::InstructionSet::AVX2)
+      {
+      multiply_pairs_tiled<Avx2Kernel>(m, n, k, a, rsa, csa, b, rsb, csb, c, rsc, policy, accumulate);
+      return;
+      }
+    multiply_pairs_tiled<PortableKernel>(m, n, k, a, rsa, csa, b, rsb, csb, c, rsc, policy, accumulate);
+    }
+
+#endif
+
+  } }
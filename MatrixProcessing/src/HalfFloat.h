@@ -0,0 +1,235 @@
+/*
+
+This file contains 16-bit floating-point storage types: IEEE half precision and bfloat16
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+
+namespace HalfFloatDetail {
+
+  inline uint32_t float_bits(float value)
+    {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+    }
+
+  inline float bits_float(uint32_t bits)
+    {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+    }
+
+  }
+
+
+/// <summary>
+/// IEEE 754 binary16: 1 sign, 5 exponent and 10 mantissa bits, about 3 decimal digits in [6e-8, 65504].
+/// Only storage is 16-bit: the value reads as float, so arithmetic on it is float arithmetic
+/// and processors accumulate products of Float16 matrices in float.
+/// Conversion from float rounds to nearest even, overflow gives infinity. F16C instructions
+/// are used when enabled at compile time, software conversion rounds the same way otherwise.
+/// </summary>
+class Float16
+  {
+  uint16_t m_bits = 0;
+
+  public:
+
+  constexpr Float16() = default;
+  explicit Float16(float value) : m_bits(from_float(value)) {}
+
+  operator float() const
+    {
+    return to_float(m_bits);
+    }
+
+  static constexpr Float16 from_bits(uint16_t bits)
+    {
+    Float16 result;
+    result.m_bits = bits;
+    return result;
+    }
+
+  constexpr uint16_t bits() const
+    {
+    return m_bits;
+    }
+
+  Float16& operator+=(float rhs) { return *this = Float16(float(*this) + rhs); }
+  Float16& operator-=(float rhs) { return *this = Float16(float(*this) - rhs); }
+  Float16& operator*=(float rhs) { return *this = Float16(float(*this) * rhs); }
+  Float16& operator/=(float rhs) { return *this = Float16(float(*this) / rhs); }
+
+
+  static uint16_t from_float(float value)
+    {
+#if defined(__F16C__)
+    return static_cast<uint16_t>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+#else
+    // exponent is rebiased with integer addition, subnormals are rounded by the FPU adding 0.5f
+    uint32_t bits = HalfFloatDetail::float_bits(value);
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t result;
+    if (bits >= 0x47800000u)
+      {
+      // 65536 and above, infinity, NaN turns quiet
+      result = bits > 0x7f800000u ? 0x7e00u : 0x7c00u;
+      }
+    else if (bits < 0x38800000u)
+      {
+      // below 2^-14 the result is subnormal or zero
+      const uint32_t magic = 126u << 23;
+      result = HalfFloatDetail::float_bits(HalfFloatDetail::bits_float(bits) + HalfFloatDetail::bits_float(magic)) - magic;
+      }
+    else
+      {
+      const uint32_t mantissa_odd = (bits >> 13) & 1u;
+      result = (bits - (112u << 23) + 0xfffu + mantissa_odd) >> 13;
+      }
+    return static_cast<uint16_t>(result | (sign >> 16));
+#endif
+    }
+
+  static float to_float(uint16_t bits)
+    {
+#if defined(__F16C__)
+    return _cvtsh_ss(bits);
+#else
+    uint32_t result = (uint32_t(bits) & 0x7fffu) << 13;
+    const uint32_t exponent = result & (0x7c00u << 13);
+    result += 112u << 23;
+    if (exponent == 0x7c00u << 13)
+      {
+      // infinity or NaN
+      result += 112u << 23;
+      }
+    else if (exponent == 0)
+      {
+      // zero or subnormal, renormalized by the FPU
+      result = HalfFloatDetail::float_bits(HalfFloatDetail::bits_float(result + (1u << 23)) - HalfFloatDetail::bits_float(113u << 23));
+      }
+    return HalfFloatDetail::bits_float(result | ((uint32_t(bits) & 0x8000u) << 16));
+#endif
+    }
+
+
+  /// <summary>
+  /// Converts n values, eight at a time with F16C.
+  /// </summary>
+  static void convert(const float* in, Float16* out, size_t n)
+    {
+    size_t i = 0;
+#if defined(__F16C__) && defined(__AVX__)
+    for (; i + 8 <= n; i += 8)
+      {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+      }
+#endif
+    for (; i < n; ++i)
+      {
+      out[i] = Float16(in[i]);
+      }
+    }
+
+  static void convert(const Float16* in, float* out, size_t n)
+    {
+    size_t i = 0;
+#if defined(__F16C__) && defined(__AVX__)
+    for (; i + 8 <= n; i += 8)
+      {
+      _mm256_storeu_ps(out + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+      }
+#endif
+    for (; i < n; ++i)
+      {
+      out[i] = float(in[i]);
+      }
+    }
+  };
+
+
+/// <summary>
+/// bfloat16: upper half of float, 8 exponent and 7 mantissa bits. Range of float with about 2 decimal digits,
+/// conversions are shifts, so it suits storing weights and activations that may be large.
+/// Reads as float like Float16, conversion from float rounds to nearest even.
+/// </summary>
+class BFloat16
+  {
+  uint16_t m_bits = 0;
+
+  public:
+
+  constexpr BFloat16() = default;
+  explicit BFloat16(float value) : m_bits(from_float(value)) {}
+
+  operator float() const
+    {
+    return to_float(m_bits);
+    }
+
+  static constexpr BFloat16 from_bits(uint16_t bits)
+    {
+    BFloat16 result;
+    result.m_bits = bits;
+    return result;
+    }
+
+  constexpr uint16_t bits() const
+    {
+    return m_bits;
+    }
+
+  BFloat16& operator+=(float rhs) { return *this = BFloat16(float(*this) + rhs); }
+  BFloat16& operator-=(float rhs) { return *this = BFloat16(float(*this) - rhs); }
+  BFloat16& operator*=(float rhs) { return *this = BFloat16(float(*this) * rhs); }
+  BFloat16& operator/=(float rhs) { return *this = BFloat16(float(*this) / rhs); }
+
+
+  static uint16_t from_float(float value)
+    {
+    const uint32_t bits = HalfFloatDetail::float_bits(value);
+    if ((bits & 0x7fffffffu) > 0x7f800000u)
+      {
+      // NaN stays NaN, rounding could carry it into infinity
+      return static_cast<uint16_t>((bits >> 16) | 0x40u);
+      }
+    return static_cast<uint16_t>((bits + 0x7fffu + ((bits >> 16) & 1u)) >> 16);
+    }
+
+  static float to_float(uint16_t bits)
+    {
+    return HalfFloatDetail::bits_float(uint32_t(bits) << 16);
+    }
+
+
+  // loops of shifts, the compiler vectorizes them
+  static void convert(const float* in, BFloat16* out, size_t n)
+    {
+    for (size_t i = 0; i < n; ++i)
+      {
+      out[i].m_bits = from_float(in[i]);
+      }
+    }
+
+  static void convert(const BFloat16* in, float* out, size_t n)
+    {
+    for (size_t i = 0; i < n; ++i)
+      {
+      out[i] = to_float(in[i].m_bits);
+      }
+    }
+  };
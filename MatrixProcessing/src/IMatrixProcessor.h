@@ -7,21 +7,125 @@ This class represents general interface of Matrix Processors
 #pragma once
 
 #include <vector>
+#include "ExecutionPolicy.h"
+#include "ConstantEvaluation.h"
 #include "Matrix.h"
+#include "Instrumentation.h"
 
 template <typename Implementation>
 class IMatrixProcessor 
   {
+  protected:
+
+  ExecutionPolicy m_policy;
+
   public:
 
-  IMatrixProcessor() = default;
+  constexpr IMatrixProcessor() = default;
+  constexpr explicit IMatrixProcessor(const ExecutionPolicy& policy) : m_policy(policy) {}
   ~IMatrixProcessor() = default;
 
+  const ExecutionPolicy& get_execution_policy() const
+    {
+    return m_policy;
+    }
+
+  // Concrete processors implement perform_operation_impl and perform_operation_into_impl,
+  // every call goes through the forwarders below, which is where instrumentation counts it.
+  // Calls evaluated at compile time are not counted.
+
+  template <typename T>
+  constexpr decltype(auto) perform_operation(const T& operand) const
+    {
+#if defined(MATRIX_PROCESSING_INSTRUMENTATION)
+    if (!ConstantEvaluation::is_constant_evaluated())
+      {
+      return counted_perform_operation(operand);
+      }
+#endif
+    return implementation().perform_operation_impl(operand);
+    }
+
   template <typename T, typename U>
-  decltype(auto) perform_operation(const T& lhs, const U& rhs) const
+  constexpr decltype(auto) perform_operation(const T& lhs, const U& rhs) const
+    {
+#if defined(MATRIX_PROCESSING_INSTRUMENTATION)
+    if (!ConstantEvaluation::is_constant_evaluated())
+      {
+      return counted_perform_operation(lhs, rhs);
+      }
+#endif
+    return implementation().perform_operation_impl(lhs, rhs);
+    }
+
+  // e.g. alpha * A * B + beta * C of MultiplyAddMatrix
+  template <typename T, typename U, typename V>
+  constexpr decltype(auto) perform_operation(const T& first, const U& second, const V& third) const
+    {
+#if defined(MATRIX_PROCESSING_INSTRUMENTATION)
+    if (!ConstantEvaluation::is_constant_evaluated())
+      {
+      return counted_perform_operation(first, second, third);
+      }
+#endif
+    return implementation().perform_operation_impl(first, second, third);
+    }
+
+  /// <summary>
+  /// Writes the result into existing matrix of the right shape and element type instead of allocating a new one.
+  /// out may also be a temporary view of a bigger matrix.
+  /// </summary>
+  template <typename T, typename O>
+  constexpr void perform_operation_into(const T& operand, O&& out) const
+    {
+#if defined(MATRIX_PROCESSING_INSTRUMENTATION)
+    if (!ConstantEvaluation::is_constant_evaluated())
+      {
+      counted_perform_operation_into(out, operand);
+      return;
+      }
+#endif
+    implementation().perform_operation_into_impl(operand, out);
+    }
+
+  template <typename T, typename U, typename O>
+  constexpr void perform_operation_into(const T& lhs, const U& rhs, O&& out) const
+    {
+#if defined(MATRIX_PROCESSING_INSTRUMENTATION)
+    if (!ConstantEvaluation::is_constant_evaluated())
+      {
+      counted_perform_operation_into(out, lhs, rhs);
+      return;
+      }
+#endif
+    implementation().perform_operation_into_impl(lhs, rhs, out);
+    }
+
+  private:
+
+  constexpr const Implementation& implementation() const
+    {
+    return *static_cast<const Implementation*>(this);
+    }
+
+#if defined(MATRIX_PROCESSING_INSTRUMENTATION)
+  // kept out of the forwarders, constexpr functions can't define a ScopedCall
+  template <typename... X>
+  auto counted_perform_operation(const X&... operands) const
+    {
+    Instrumentation::ScopedCall<Implementation> call(operands...);
+    auto result = implementation().perform_operation_impl(operands...);
+    call.add_result(result);
+    return result;
+    }
+
+  template <typename O, typename... X>
+  void counted_perform_operation_into(O& out, const X&... operands) const
     {
-    return (static_cast<const Implementation*>(this))->perform_operation(lhs, rhs);
+    Instrumentation::ScopedCall<Implementation> call(operands...);
+    implementation().perform_operation_into_impl(operands..., out);
     }
+#endif
 
   };
  
\ No newline at end of file
@@ -8,82 +8,153 @@ This class represents array-based Matrix
 
 #include <iostream>
 #include <vector>
+#include <cassert>
 #include <exception>
 #include <type_traits>
 #include "IMatrixProcessor.h"
+#include "MatrixStorage.h"
+#include "StridedIterator.h"
+#include "AlignedAllocator.h"
 
+namespace MatrixExpressions {
+  template <typename E>
+  class Expression;
+  }
 
-template <typename T, size_t R, size_t C>
+template <typename T, size_t R, size_t C, typename A = AlignedAllocator<T>>
 class Matrix
   {
+  public:
+
+  using allocator_type = A;
+  using storage_type = MatrixStorage<T, R * C, A>;
+
   protected:
 
-  std::vector<T> m_data;
-  size_t m_rows = R;
-  size_t m_cols = C;
+  storage_type m_data;
 
 
   public:
 
-  Matrix();
-  Matrix(const std::vector<T>& vec);
-  Matrix(std::vector<T>&& vec);
-  Matrix(std::initializer_list<T>&& init_list);
+  constexpr Matrix();
+  template <typename VA = std::allocator<T>>
+  Matrix(const std::vector<T, VA>& vec);
+
+  /// <summary>
+  /// Takes over the buffer of vec when it is already the storage type, i.e. std::vector<T, A> of a matrix
+  /// too big for inline storage. Any other vector, including plain std::vector<T> when A is the default
+  /// AlignedAllocator, is copied element by element into aligned storage.
+  /// </summary>
+  template <typename VA = std::allocator<T>>
+  Matrix(std::vector<T, VA>&& vec);
+
+  constexpr Matrix(std::initializer_list<T>&& init_list);
+
+  /// <summary>
+  /// Evaluates a lazy expression. Its element type must be T, nothing is silently narrowed.
+  /// </summary>
+  template <typename E>
+  explicit Matrix(const MatrixExpressions::Expression<E>& expr);
 
-  Matrix(const Matrix<T,R,C>&) = default;
-  Matrix(Matrix<T, R, C>&&) = default;
-  virtual ~Matrix() = default;
+  Matrix(const Matrix<T, R, C, A>&) = default;
+  Matrix(Matrix<T, R, C, A>&&) = default;
+  // not virtual, so a matrix with inline storage is a literal type and can be constexpr
+  ~Matrix() = default;
 
   Matrix& operator=(const Matrix&) = default;
   Matrix& operator=(Matrix&&) = default;
 
-  const std::vector<T>& get_data() const;
-  const size_t get_n_rows() const;
-  const size_t get_n_cols() const;
+  template <typename E>
+  Matrix& operator=(const MatrixExpressions::Expression<E>& expr);
+
+  constexpr const storage_type& get_data() const;
+  std::vector<T, A> release_data() &&;
+  constexpr T* data();
+  constexpr const T* data() const;
+  static constexpr size_t get_n_rows() { return R; }
+  static constexpr size_t get_n_cols() { return C; }
+
+  constexpr const T& at(size_t row, size_t col) const;
+  constexpr T& at(size_t row, size_t col);
+
+  /// <summary>
+  /// Same element as at(), indices start from 1, but they are checked only by assert in debug builds.
+  /// </summary>
+  constexpr const T& operator()(size_t row, size_t col) const;
+  constexpr T& operator()(size_t row, size_t col);
+
+  using iterator = T*;
+  using const_iterator = const T*;
+  using col_iterator = StridedIterator<T>;
+  using const_col_iterator = StridedIterator<const T>;
+
+  // all elements in row-major order, one row or one column, indices start from 1 and are not checked
+  constexpr iterator begin() { return data(); }
+  constexpr iterator end() { return data() + R * C; }
+  constexpr const_iterator begin() const { return data(); }
+  constexpr const_iterator end() const { return data() + R * C; }
+
+  constexpr iterator row_begin(size_t row) { return data() + (row - 1) * C; }
+  constexpr iterator row_end(size_t row) { return data() + row * C; }
+  constexpr const_iterator row_begin(size_t row) const { return data() + (row - 1) * C; }
+  constexpr const_iterator row_end(size_t row) const { return data() + row * C; }
 
-  const T& at(size_t row, size_t col) const;
-  T& at(size_t row, size_t col);
+  constexpr col_iterator col_begin(size_t col) { return col_iterator(data() + col - 1, C); }
+  constexpr col_iterator col_end(size_t col) { return col_iterator(data() + col - 1, C, R); }
+  constexpr const_col_iterator col_begin(size_t col) const { return const_col_iterator(data() + col - 1, C); }
+  constexpr const_col_iterator col_end(size_t col) const { return const_col_iterator(data() + col - 1, C, R); }
 
-  template <typename U, size_t V, size_t X>
-  friend std::ostream& operator<< (std::ostream& o, const Matrix<U, V, X>& mat);
+  template <typename U, size_t V, size_t X, typename B>
+  friend std::ostream& operator<< (std::ostream& o, const Matrix<U, V, X, B>& mat);
 
-  template <typename U, size_t V, size_t X>
-  friend bool operator== (const Matrix<U, V, X>& mat1, const Matrix<U, V, X>& mat2);
+  template <typename U, size_t V, size_t X, typename B>
+  friend constexpr bool operator== (const Matrix<U, V, X, B>& mat1, const Matrix<U, V, X, B>& mat2);
 
-  template <typename U, size_t V, size_t X>
-  friend bool operator!= (const Matrix<U, V, X>& mat1, const Matrix<U, V, X>& mat2);
+  template <typename U, size_t V, size_t X, typename B>
+  friend constexpr bool operator!= (const Matrix<U, V, X, B>& mat1, const Matrix<U, V, X, B>& mat2);
+
+  template <typename P>
+  constexpr auto UnaryOperation(const IMatrixProcessor<P>& imp) const;
 
   template <typename P, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
-  auto UnaryOperation(const IMatrixProcessor<P>& imp, const U& scal) const; 
+  constexpr auto UnaryOperation(const IMatrixProcessor<P>& imp, const U& scal) const; 
 
-  template <typename P, typename U, size_t V, size_t X>
-  auto BinaryOperation(const IMatrixProcessor<P>& imp, const Matrix<U, V, X>& mat) const;
+  template <typename P, typename U, size_t V, size_t X, typename B>
+  constexpr auto BinaryOperation(const IMatrixProcessor<P>& imp, const Matrix<U, V, X, B>& mat) const;
 
   };
 
 
-template <typename T, size_t R, size_t C>
-Matrix<T, R, C>::Matrix()
-  : m_data(R*C, 0)
+template <typename T, size_t R, size_t C, typename A>
+constexpr Matrix<T, R, C, A>::Matrix()
+  : m_data(R*C, T())
   {
   static_assert(R*C > 0);
   }
 
 
-template <typename T, size_t R, size_t C>
-Matrix<T, R, C>::Matrix(const std::vector<T>& vec)
+template <typename T, size_t R, size_t C, typename A>
+template <typename VA>
+Matrix<T, R, C, A>::Matrix(const std::vector<T, VA>& vec)
   {
   static_assert(R * C > 0);
   if (vec.size() != R * C)
     {
     throw std::length_error("Length of the provided vector doesn`t match matrix size");
     }
-  m_data = vec;
+  if constexpr (std::is_same_v<storage_type, std::vector<T, VA>>)
+    {
+    m_data = vec;
+    }
+  else
+    {
+    m_data.assign(vec.begin(), vec.end());
+    }
   }
 
 
-template <typename T, size_t R, size_t C>
-Matrix<T, R, C>::Matrix(std::initializer_list<T>&& init_list)
+template <typename T, size_t R, size_t C, typename A>
+constexpr Matrix<T, R, C, A>::Matrix(std::initializer_list<T>&& init_list)
   {
   static_assert(R * C > 0);
   if (init_list.size() != R * C)
@@ -94,108 +165,177 @@ Matrix<T, R, C>::Matrix(std::initializer_list<T>&& init_list)
   }
 
 
-template <typename T, size_t R, size_t C>
-Matrix<T, R, C>::Matrix(std::vector<T>&& vec)
+template <typename T, size_t R, size_t C, typename A>
+template <typename VA>
+Matrix<T, R, C, A>::Matrix(std::vector<T, VA>&& vec)
   {
   static_assert(R * C > 0);
   if (vec.size() != R * C)
     {
     throw std::length_error("Length of vector doesn`t match matrix size");
     }
-  m_data = std::move(vec);
+  if constexpr (std::is_same_v<storage_type, std::vector<T, VA>>)
+    {
+    m_data = std::move(vec);
+    }
+  else
+    {
+    m_data.assign(vec.begin(), vec.end());
+    }
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+template <typename E>
+Matrix<T, R, C, A>::Matrix(const MatrixExpressions::Expression<E>& expr)
+  : m_data(R * C)
+  {
+  static_assert(std::is_same_v<T, typename E::value_type>, "Element type of the matrix doesn`t match type of the expression");
+  *this = expr;
   }
 
 
-template <typename T, size_t R, size_t C>
-const std::vector<T>& Matrix<T, R, C>::get_data() const
+template <typename T, size_t R, size_t C, typename A>
+template <typename E>
+Matrix<T, R, C, A>& Matrix<T, R, C, A>::operator=(const MatrixExpressions::Expression<E>& expr)
+  {
+  static_assert(E::rows == R && E::cols == C, "Shape of the expression doesn`t match matrix size");
+  static_assert(std::is_same_v<T, typename E::value_type>, "Element type of the matrix doesn`t match type of the expression");
+  expr.evaluate_into(m_data.data(), ExecutionPolicy());
+  return *this;
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+constexpr const typename Matrix<T, R, C, A>::storage_type& Matrix<T, R, C, A>::get_data() const
   {
   return m_data;
   }
 
 
-template <typename T, size_t R, size_t C>
-const size_t Matrix<T, R, C>::get_n_rows() const
+template <typename T, size_t R, size_t C, typename A>
+std::vector<T, A> Matrix<T, R, C, A>::release_data() &&
   {
-  return m_rows;
+  // heap buffer is handed over as is, the matrix is left empty
+  if constexpr (std::is_same_v<storage_type, std::vector<T, A>>)
+    {
+    return std::move(m_data);
+    }
+  else
+    {
+    return std::vector<T, A>(m_data.begin(), m_data.end());
+    }
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+constexpr T* Matrix<T, R, C, A>::data()
+  {
+  return m_data.data();
   }
 
 
-template <typename T, size_t R, size_t C>
-const size_t Matrix<T, R, C>::get_n_cols() const
+template <typename T, size_t R, size_t C, typename A>
+constexpr const T* Matrix<T, R, C, A>::data() const
   {
-  return m_cols;
+  return m_data.data();
   }
 
 
-template <typename T, size_t R, size_t C>
-const T& Matrix<T, R, C>::at(size_t row, size_t col) const
+template <typename T, size_t R, size_t C, typename A>
+constexpr const T& Matrix<T, R, C, A>::at(size_t row, size_t col) const
   {
   return m_data.at(row*C+col-C-1);
   }
 
 
-template <typename T, size_t R, size_t C>
-T& Matrix<T, R, C>::at(size_t row, size_t col)
+template <typename T, size_t R, size_t C, typename A>
+constexpr T& Matrix<T, R, C, A>::at(size_t row, size_t col)
   {
   return m_data.at(row * C + col - C - 1);
   }
 
 
-template <typename U, size_t V, size_t X>
-std::ostream& operator<< (std::ostream& ostr, const Matrix<U, V, X>& mat)
+template <typename T, size_t R, size_t C, typename A>
+constexpr const T& Matrix<T, R, C, A>::operator()(size_t row, size_t col) const
+  {
+  assert(row >= 1 && row <= R && col >= 1 && col <= C);
+  return m_data[(row - 1) * C + col - 1];
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+constexpr T& Matrix<T, R, C, A>::operator()(size_t row, size_t col)
+  {
+  assert(row >= 1 && row <= R && col >= 1 && col <= C);
+  return m_data[(row - 1) * C + col - 1];
+  }
+
+
+template <typename U, size_t V, size_t X, typename B>
+std::ostream& operator<< (std::ostream& ostr, const Matrix<U, V, X, B>& mat)
   {
   size_t col_counter = 0;
   size_t row_counter = 0;
 
-  std::cout << "| ";
+  ostr << "| ";
   for (const U& elem : mat.m_data)
     {
-    std::cout << elem;
+    ostr << elem;
     ++col_counter;
-    if (col_counter == mat.m_cols)
+    if (col_counter == X)
       {
-      std::cout << " |" << std::endl;
+      ostr << " |\n";
       col_counter = 0;
       ++row_counter;
-      if (row_counter < mat.m_rows)
+      if (row_counter < V)
           {
-          std::cout << "| ";
+          ostr << "| ";
           }
       continue;
       }
-    std::cout << "\t";
+    ostr << "\t";
     }
 
   return ostr;
   }
 
 
-template <typename U, size_t V, size_t X>
-bool operator==(const Matrix<U, V, X>& mat1, const Matrix<U, V, X>& mat2)
+template <typename U, size_t V, size_t X, typename B>
+constexpr bool operator==(const Matrix<U, V, X, B>& mat1, const Matrix<U, V, X, B>& mat2)
   {
-  return mat1.m_rows == mat2.m_rows && mat1.m_cols == mat2.m_cols && mat1.m_data == mat2.m_data;
+  return mat1.m_data == mat2.m_data;
   }
 
 
-template <typename U, size_t V, size_t X>
-bool operator!=(const Matrix<U, V, X>& mat1, const Matrix<U, V, X>& mat2)
+template <typename U, size_t V, size_t X, typename B>
+constexpr bool operator!=(const Matrix<U, V, X, B>& mat1, const Matrix<U, V, X, B>& mat2)
   {
   return !(mat1 == mat2);
   }
 
 
-template <typename T, size_t R, size_t C >
+template <typename T, size_t R, size_t C, typename A>
+template <typename P>
+constexpr auto Matrix<T, R, C, A>::UnaryOperation(const IMatrixProcessor<P>& imp) const
+  {
+  auto result = imp.perform_operation(*this);
+  return result;
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
 template <typename P, typename U, std::enable_if_t<std::is_arithmetic_v<U>>*>
-auto Matrix<T, R, C>::UnaryOperation(const IMatrixProcessor<P>& imp, const U& scal) const
+constexpr auto Matrix<T, R, C, A>::UnaryOperation(const IMatrixProcessor<P>& imp, const U& scal) const
   {
   auto result = imp.perform_operation(*this, scal);
   return result;
   }
 
 
-template <typename T, size_t R, size_t C >
-template <typename P, typename U, size_t V, size_t X>
-auto Matrix<T, R, C>::BinaryOperation(const IMatrixProcessor<P>& imp, const Matrix<U, V, X>& mat) const
+template <typename T, size_t R, size_t C, typename A>
+template <typename P, typename U, size_t V, size_t X, typename B>
+constexpr auto Matrix<T, R, C, A>::BinaryOperation(const IMatrixProcessor<P>& imp, const Matrix<U, V, X, B>& mat) const
   {
   auto result = imp.perform_operation(*this, mat);
   return result;
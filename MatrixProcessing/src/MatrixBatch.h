@@ -0,0 +1,252 @@
+/*
+
+This class represents batch of independent Matrices of the same shape stored element by element
+
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include "IMatrixProcessor.h"
+#include "AlignedAllocator.h"
+#include "Matrix.h"
+
+
+/// <summary>
+/// Structure-of-arrays storage: element (row, col) of every matrix in the batch lies in one
+/// contiguous lane, so element e of matrix b is at data()[e * size + b]. Processors then work
+/// on whole lanes and vectorize across the batch however small R and C are.
+/// </summary>
+template <typename T, size_t R, size_t C, typename A = AlignedAllocator<T>>
+class MatrixBatch
+  {
+  public:
+
+  using allocator_type = A;
+  using storage_type = std::vector<T, A>;
+  using matrix_type = Matrix<T, R, C, A>;
+
+  protected:
+
+  storage_type m_data;
+  size_t m_size = 0;
+
+
+  public:
+
+  MatrixBatch() = default;
+  explicit MatrixBatch(size_t size);
+
+  template <typename B>
+  MatrixBatch(const std::vector<Matrix<T, R, C, B>>& mats);
+
+  MatrixBatch(const MatrixBatch<T, R, C, A>&) = default;
+  MatrixBatch(MatrixBatch<T, R, C, A>&&) = default;
+  ~MatrixBatch() = default;
+
+  MatrixBatch& operator=(const MatrixBatch&) = default;
+  MatrixBatch& operator=(MatrixBatch&&) = default;
+
+  const storage_type& get_data() const;
+  T* data();
+  const T* data() const;
+  size_t get_batch_size() const;
+  static constexpr size_t get_n_rows() { return R; }
+  static constexpr size_t get_n_cols() { return C; }
+
+  /// <summary>
+  /// Element (row, col) of every matrix of the batch, get_batch_size() values. Indices start from 1 as in Matrix::at.
+  /// </summary>
+  T* lane(size_t row, size_t col);
+  const T* lane(size_t row, size_t col) const;
+
+  matrix_type get(size_t index) const;
+
+  template <typename B>
+  void set(size_t index, const Matrix<T, R, C, B>& mat);
+
+  const T& at(size_t index, size_t row, size_t col) const;
+  T& at(size_t index, size_t row, size_t col);
+
+  template <typename U, size_t V, size_t X, typename B>
+  friend std::ostream& operator<< (std::ostream& o, const MatrixBatch<U, V, X, B>& batch);
+
+  template <typename U, size_t V, size_t X, typename B>
+  friend bool operator== (const MatrixBatch<U, V, X, B>& batch1, const MatrixBatch<U, V, X, B>& batch2);
+
+  template <typename U, size_t V, size_t X, typename B>
+  friend bool operator!= (const MatrixBatch<U, V, X, B>& batch1, const MatrixBatch<U, V, X, B>& batch2);
+
+  template <typename P, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+  auto UnaryOperation(const IMatrixProcessor<P>& imp, const U& scal) const;
+
+  template <typename P, typename U, size_t V, size_t X, typename B>
+  auto BinaryOperation(const IMatrixProcessor<P>& imp, const MatrixBatch<U, V, X, B>& batch) const;
+
+  private:
+
+  void check_index(size_t index, size_t row, size_t col) const;
+  };
+
+
+template <typename T, size_t R, size_t C, typename A>
+MatrixBatch<T, R, C, A>::MatrixBatch(size_t size)
+  : m_data(R * C * size, T()), m_size(size)
+  {
+  static_assert(R * C > 0);
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+template <typename B>
+MatrixBatch<T, R, C, A>::MatrixBatch(const std::vector<Matrix<T, R, C, B>>& mats)
+  : MatrixBatch(mats.size())
+  {
+  for (size_t index = 0; index < m_size; ++index)
+    {
+    set(index, mats[index]);
+    }
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+const typename MatrixBatch<T, R, C, A>::storage_type& MatrixBatch<T, R, C, A>::get_data() const
+  {
+  return m_data;
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+T* MatrixBatch<T, R, C, A>::data()
+  {
+  return m_data.data();
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+const T* MatrixBatch<T, R, C, A>::data() const
+  {
+  return m_data.data();
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+size_t MatrixBatch<T, R, C, A>::get_batch_size() const
+  {
+  return m_size;
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+T* MatrixBatch<T, R, C, A>::lane(size_t row, size_t col)
+  {
+  return m_data.data() + ((row - 1) * C + col - 1) * m_size;
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+const T* MatrixBatch<T, R, C, A>::lane(size_t row, size_t col) const
+  {
+  return m_data.data() + ((row - 1) * C + col - 1) * m_size;
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+typename MatrixBatch<T, R, C, A>::matrix_type MatrixBatch<T, R, C, A>::get(size_t index) const
+  {
+  check_index(index, 1, 1);
+  matrix_type mat;
+  T* mat_data = mat.data();
+  for (size_t e = 0; e < R * C; ++e)
+    {
+    mat_data[e] = m_data[e * m_size + index];
+    }
+  return mat;
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+template <typename B>
+void MatrixBatch<T, R, C, A>::set(size_t index, const Matrix<T, R, C, B>& mat)
+  {
+  check_index(index, 1, 1);
+  const T* mat_data = mat.data();
+  for (size_t e = 0; e < R * C; ++e)
+    {
+    m_data[e * m_size + index] = mat_data[e];
+    }
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+const T& MatrixBatch<T, R, C, A>::at(size_t index, size_t row, size_t col) const
+  {
+  check_index(index, row, col);
+  return lane(row, col)[index];
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+T& MatrixBatch<T, R, C, A>::at(size_t index, size_t row, size_t col)
+  {
+  check_index(index, row, col);
+  return lane(row, col)[index];
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+void MatrixBatch<T, R, C, A>::check_index(size_t index, size_t row, size_t col) const
+  {
+  if (index >= m_size || row == 0 || row > R || col == 0 || col > C)
+    {
+    throw std::out_of_range("Index is out of batch bounds");
+    }
+  }
+
+
+template <typename U, size_t V, size_t X, typename B>
+std::ostream& operator<< (std::ostream& ostr, const MatrixBatch<U, V, X, B>& batch)
+  {
+  for (size_t index = 0; index < batch.m_size; ++index)
+    {
+    ostr << "[" << index << "]\n" << batch.get(index);
+    }
+
+  return ostr;
+  }
+
+
+template <typename U, size_t V, size_t X, typename B>
+bool operator==(const MatrixBatch<U, V, X, B>& batch1, const MatrixBatch<U, V, X, B>& batch2)
+  {
+  return batch1.m_size == batch2.m_size && batch1.m_data == batch2.m_data;
+  }
+
+
+template <typename U, size_t V, size_t X, typename B>
+bool operator!=(const MatrixBatch<U, V, X, B>& batch1, const MatrixBatch<U, V, X, B>& batch2)
+  {
+  return !(batch1 == batch2);
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+template <typename P, typename U, std::enable_if_t<std::is_arithmetic_v<U>>*>
+auto MatrixBatch<T, R, C, A>::UnaryOperation(const IMatrixProcessor<P>& imp, const U& scal) const
+  {
+  auto result = imp.perform_operation(*this, scal);
+  return result;
+  }
+
+
+template <typename T, size_t R, size_t C, typename A>
+template <typename P, typename U, size_t V, size_t X, typename B>
+auto MatrixBatch<T, R, C, A>::BinaryOperation(const IMatrixProcessor<P>& imp, const MatrixBatch<U, V, X, B>& batch) const
+  {
+  auto result = imp.perform_operation(*this, batch);
+  return result;
+  }
@@ -0,0 +1,275 @@
+/*
+
+This file contains lazy elementwise expressions built from Matrix Processors
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include "Matrix.h"
+#include "MatrixProcessors.h"
+
+/// <summary>
+/// This namespace contains expression nodes that fuse chained elementwise operations.
+/// Nothing is computed until the expression is assigned to a Matrix, then every element
+/// of the result is produced by a single pass over the operands.
+/// </summary>
+namespace MatrixExpressions {
+
+  /// <summary>
+  /// Elements are evaluated in blocks of this size into a local buffer and then copied to the result.
+  /// The buffer can`t alias the operands, so the compiler vectorizes the evaluation loop without overlap checks.
+  /// </summary>
+  constexpr size_t evaluation_block = 256;
+
+  namespace Detail {
+
+    template <typename E, typename T>
+    void evaluate_range(const E& node, T* out, size_t begin, size_t end)
+      {
+      T block[evaluation_block];
+      size_t i = begin;
+      for (; i + evaluation_block <= end; i += evaluation_block)
+        {
+        for (size_t j = 0; j < evaluation_block; ++j)
+          {
+          block[j] = node.eval(i + j);
+          }
+        std::copy(block, block + evaluation_block, out + i);
+        }
+      for (; i < end; ++i)
+        {
+        out[i] = node.eval(i);
+        }
+      }
+
+#if defined(MATRIX_PROCESSING_X86)
+
+    // Same loop compiled for AVX2, eval() of the nodes is inlined here and vectorized with 256-bit registers
+    template <typename E, typename T>
+    MATRIX_PROCESSING_TARGET("avx2") void evaluate_range_avx2(const E& node, T* out, size_t begin, size_t end)
+      {
+      T block[evaluation_block];
+      size_t i = begin;
+      for (; i + evaluation_block <= end; i += evaluation_block)
+        {
+        for (size_t j = 0; j < evaluation_block; ++j)
+          {
+          block[j] = node.eval(i + j);
+          }
+        std::copy(block, block + evaluation_block, out + i);
+        }
+      for (; i < end; ++i)
+        {
+        out[i] = node.eval(i);
+        }
+      }
+
+#endif
+
+  }
+
+  template <typename P, typename = void>
+  struct is_elementwise_processor : std::false_type {};
+
+  template <typename P>
+  struct is_elementwise_processor<P, std::void_t<typename P::element_operation>> : std::true_type {};
+
+
+  template <typename Op, typename L, typename S>
+  class ScalarNode;
+
+  template <typename Op, typename L, typename R>
+  class BinaryNode;
+
+  template <typename T, size_t R, size_t C>
+  class Operand;
+
+
+  /// <summary>
+  /// Base of every expression node. E provides value_type, rows, cols and eval(i).
+  /// </summary>
+  template <typename E>
+  class Expression
+    {
+    public:
+
+    const E& derived() const
+      {
+      return static_cast<const E&>(*this);
+      }
+
+    /// <summary>
+    /// Computes the expression into a new matrix on the threads allowed by the policy.
+    /// </summary>
+    auto evaluate(const ExecutionPolicy& policy = ExecutionPolicy()) const
+      {
+      Matrix<typename E::value_type, E::rows, E::cols> result;
+      evaluate_into(result.data(), policy);
+      return result;
+      }
+
+    /// <summary>
+    /// Writes every element of the expression to out, rows * cols elements of its value_type.
+    /// Chunks go to different threads as in elementwise processors. out may be one of the operands,
+    /// every element is read and written at the same index.
+    /// </summary>
+    template <typename T>
+    void evaluate_into(T* out, const ExecutionPolicy& policy) const
+      {
+      const E& node = derived();
+      parallel_for(policy, E::rows * E::cols, MatrixProcessors::elementwise_parallel_grain, [&node, out](size_t begin, size_t end)
+        {
+#if defined(MATRIX_PROCESSING_X86)
+        if (MatrixProcessors::Simd::active_instruction_set() >= MatrixProcessors::Simd::InstructionSet::AVX2)
+          {
+          Detail::evaluate_range_avx2(node, out, begin, end);
+          return;
+          }
+#endif
+        Detail::evaluate_range(node, out, begin, end);
+        });
+      }
+
+    template <typename P, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+    auto UnaryOperation(const IMatrixProcessor<P>&, const U& scal) const
+      {
+      static_assert(is_elementwise_processor<P>::value, "Only elementwise processors can be fused");
+      return ScalarNode<typename P::element_operation, E, U>(derived(), scal);
+      }
+
+    template <typename P, typename E2>
+    auto BinaryOperation(const IMatrixProcessor<P>&, const Expression<E2>& expr) const
+      {
+      static_assert(is_elementwise_processor<P>::value, "Only elementwise processors can be fused");
+      static_assert(E::rows == E2::rows && E::cols == E2::cols, "Shapes of fused operands differ");
+      return BinaryNode<typename P::element_operation, E, E2>(derived(), expr.derived());
+      }
+
+    template <typename P, typename U, size_t V, size_t X, typename B>
+    auto BinaryOperation(const IMatrixProcessor<P>& imp, const Matrix<U, V, X, B>& mat) const
+      {
+      return BinaryOperation(imp, Operand<U, V, X>(mat));
+      }
+    };
+
+
+  /// <summary>
+  /// Leaf node referring to the data of existing Matrix.
+  /// </summary>
+  template <typename T, size_t R, size_t C>
+  class Operand : public Expression<Operand<T, R, C>>
+    {
+    const T* m_data;
+
+    public:
+
+    using value_type = T;
+    static constexpr size_t rows = R;
+    static constexpr size_t cols = C;
+
+    template <typename A>
+    explicit Operand(const Matrix<T, R, C, A>& mat) : m_data(mat.get_data().data()) {}
+
+    const T& eval(size_t i) const
+      {
+      return m_data[i];
+      }
+    };
+
+
+  /// <summary>
+  /// Node applying Op to every element of L and the scalar.
+  /// </summary>
+  template <typename Op, typename L, typename S>
+  class ScalarNode : public Expression<ScalarNode<Op, L, S>>
+    {
+    L m_lhs;
+    S m_scal;
+
+    public:
+
+    using value_type = decltype(Op::apply(std::declval<typename L::value_type>(), std::declval<S>()));
+    static constexpr size_t rows = L::rows;
+    static constexpr size_t cols = L::cols;
+
+    ScalarNode(const L& lhs, const S& scal) : m_lhs(lhs), m_scal(scal) {}
+
+    value_type eval(size_t i) const
+      {
+      return Op::apply(m_lhs.eval(i), m_scal);
+      }
+    };
+
+
+  /// <summary>
+  /// Node applying Op to the elements of L and R with the same index.
+  /// </summary>
+  template <typename Op, typename L, typename R>
+  class BinaryNode : public Expression<BinaryNode<Op, L, R>>
+    {
+    L m_lhs;
+    R m_rhs;
+
+    public:
+
+    using value_type = decltype(Op::apply(std::declval<typename L::value_type>(), std::declval<typename R::value_type>()));
+    static constexpr size_t rows = L::rows;
+    static constexpr size_t cols = L::cols;
+
+    BinaryNode(const L& lhs, const R& rhs) : m_lhs(lhs), m_rhs(rhs) {}
+
+    value_type eval(size_t i) const
+      {
+      return Op::apply(m_lhs.eval(i), m_rhs.eval(i));
+      }
+    };
+
+
+  /// <summary>
+  /// Starts a lazy expression on the matrix. The matrix must outlive the expression.
+  /// </summary>
+  template <typename T, size_t R, size_t C, typename A>
+  Operand<T, R, C> lazy(const Matrix<T, R, C, A>& mat)
+    {
+    return Operand<T, R, C>(mat);
+    }
+
+  template <typename T, size_t R, size_t C, typename A>
+  Operand<T, R, C> lazy(const Matrix<T, R, C, A>&& mat) = delete;
+
+
+  template <typename E, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+  auto operator+(const Expression<E>& expr, const U& scal)
+    {
+    return expr.UnaryOperation(MatrixProcessors::AddScalar{}, scal);
+    }
+
+  template <typename E, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+  auto operator-(const Expression<E>& expr, const U& scal)
+    {
+    return expr.UnaryOperation(MatrixProcessors::SubtractScalar{}, scal);
+    }
+
+  template <typename E, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+  auto operator*(const Expression<E>& expr, const U& scal)
+    {
+    return expr.UnaryOperation(MatrixProcessors::MultiplyScalar{}, scal);
+    }
+
+  template <typename E1, typename E2>
+  auto operator+(const Expression<E1>& lhs, const Expression<E2>& rhs)
+    {
+    return lhs.BinaryOperation(MatrixProcessors::AddMatrix{}, rhs);
+    }
+
+  template <typename E, typename U, size_t V, size_t X, typename B>
+  auto operator+(const Expression<E>& lhs, const Matrix<U, V, X, B>& rhs)
+    {
+    return lhs.BinaryOperation(MatrixProcessors::AddMatrix{}, rhs);
+    }
+
+  }
@@ -0,0 +1,469 @@
+/*
+
+This file contains binary on-disk format of Matrix with writer and memory-mapped reader
+
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+#include "Matrix.h"
+#include "DynamicMatrix.h"
+#include "MatrixView.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/// <summary>
+/// This namespace contains binary Matrix files.
+///
+/// File is 64-byte MatrixFileHeader followed by rows * cols elements in row-major order and
+/// native byte order. data_offset is a multiple of the alignment, so data of a mapped file is as
+/// aligned as AlignedAllocator storage and can be handed to the processors as is.
+/// </summary>
+namespace MatrixIO {
+
+  enum class ElementType : uint32_t { Int32 = 1, Int64 = 2, Float32 = 3, Float64 = 4 };
+
+  constexpr char file_magic[8] = { 'M', 'A', 'T', 'R', 'I', 'X', 'B', '\0' };
+  constexpr uint32_t file_version = 1;
+  constexpr uint32_t file_byte_order_mark = 0x01020304;
+  constexpr uint32_t file_data_alignment = 64;
+
+
+  struct MatrixFileHeader
+    {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t element_type;
+    uint32_t element_size;
+    uint32_t alignment;
+    uint32_t reserved0;
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t data_offset;
+    uint64_t reserved1;
+    };
+
+  static_assert(sizeof(MatrixFileHeader) == file_data_alignment, "Header must keep data aligned");
+
+
+  template <typename T>
+  constexpr ElementType element_type_of()
+    {
+    if constexpr (std::is_same_v<T, int32_t>) { return ElementType::Int32; }
+    else if constexpr (std::is_same_v<T, int64_t>) { return ElementType::Int64; }
+    else if constexpr (std::is_same_v<T, float>) { return ElementType::Float32; }
+    else
+      {
+      static_assert(std::is_same_v<T, double>, "Only int32, int64, float and double matrices can be stored");
+      return ElementType::Float64;
+      }
+    }
+
+
+  namespace Detail {
+
+    template <typename T>
+    MatrixFileHeader make_header(size_t rows, size_t cols)
+      {
+      MatrixFileHeader header {};
+      std::memcpy(header.magic, file_magic, sizeof(file_magic));
+      header.version = file_version;
+      header.byte_order_mark = file_byte_order_mark;
+      header.element_type = static_cast<uint32_t>(element_type_of<T>());
+      header.element_size = sizeof(T);
+      header.alignment = file_data_alignment;
+      header.rows = rows;
+      header.cols = cols;
+      header.data_offset = sizeof(MatrixFileHeader);
+      return header;
+      }
+
+
+    template <typename T>
+    void write_binary(const std::string& path, size_t rows, size_t cols, const T* data, size_t row_stride)
+      {
+      const MatrixFileHeader header = make_header<T>(rows, cols);
+
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      if (!file)
+        {
+        throw std::runtime_error("Can`t open file " + path + " for writing");
+        }
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      for (size_t row = 0; row < rows; ++row)
+        {
+        file.write(reinterpret_cast<const char*>(data + row * row_stride), static_cast<std::streamsize>(cols * sizeof(T)));
+        }
+      if (!file)
+        {
+        throw std::runtime_error("Can`t write file " + path);
+        }
+      }
+
+
+    inline void check_header(const MatrixFileHeader& header, uint64_t file_size, ElementType type, uint32_t element_size, const std::string& path)
+      {
+      if (file_size < sizeof(MatrixFileHeader) || std::memcmp(header.magic, file_magic, sizeof(file_magic)) != 0)
+        {
+        throw std::runtime_error("File " + path + " is not a matrix file");
+        }
+      if (header.version != file_version || header.byte_order_mark != file_byte_order_mark)
+        {
+        throw std::runtime_error("Matrix file " + path + " has unsupported version or byte order");
+        }
+      if (header.element_type != static_cast<uint32_t>(type) || header.element_size != element_size)
+        {
+        throw std::runtime_error("Element type of matrix file " + path + " doesn`t match requested type");
+        }
+      if (header.data_offset % file_data_alignment != 0 || header.data_offset > file_size
+        || (header.cols != 0 && header.rows > (file_size - header.data_offset) / element_size / header.cols))
+        {
+        throw std::runtime_error("Matrix file " + path + " is truncated");
+        }
+      }
+
+  }
+
+
+  template <typename T, size_t R, size_t C, typename A>
+  void write_binary(const std::string& path, const Matrix<T, R, C, A>& mat)
+    {
+    Detail::write_binary(path, R, C, mat.data(), C);
+    }
+
+  template <typename T, typename A>
+  void write_binary(const std::string& path, const DynamicMatrix<T, A>& mat)
+    {
+    Detail::write_binary(path, mat.get_n_rows(), mat.get_n_cols(), mat.data(), mat.get_n_cols());
+    }
+
+  template <typename T, size_t R, size_t C>
+  void write_binary(const std::string& path, const MatrixView<T, R, C>& view)
+    {
+    Detail::write_binary(path, R, C, view.data(), view.get_row_stride());
+    }
+
+
+  /// <summary>
+  /// Read-only matrix backed by the pages of a mapped file. Opening costs the same for any size,
+  /// pages are read by the OS when elements on them are touched for the first time.
+  /// </summary>
+  template <typename T>
+  class MappedMatrix
+    {
+    const void* m_mapping = nullptr;
+    size_t m_mapping_size = 0;
+    const T* m_data = nullptr;
+    size_t m_rows = 0;
+    size_t m_cols = 0;
+
+    public:
+
+    explicit MappedMatrix(const std::string& path)
+      {
+      map(path);
+      }
+
+    MappedMatrix(const MappedMatrix&) = delete;
+    MappedMatrix& operator=(const MappedMatrix&) = delete;
+
+    MappedMatrix(MappedMatrix&& other) noexcept
+      {
+      swap(other);
+      }
+
+    MappedMatrix& operator=(MappedMatrix&& other) noexcept
+      {
+      MappedMatrix(std::move(other)).swap(*this);
+      return *this;
+      }
+
+    ~MappedMatrix()
+      {
+      unmap();
+      }
+
+    const T* data() const { return m_data; }
+    size_t get_n_rows() const { return m_rows; }
+    size_t get_n_cols() const { return m_cols; }
+
+    const T& at(size_t row, size_t col) const
+      {
+      if (row == 0 || row > m_rows || col == 0 || col > m_cols)
+        {
+        throw std::out_of_range("Index is out of matrix bounds");
+        }
+      return m_data[(row - 1) * m_cols + col - 1];
+      }
+
+    /// <summary>
+    /// View with compile-time shape over the whole mapped matrix, valid while this object lives.
+    /// </summary>
+    template <size_t R, size_t C>
+    MatrixView<const T, R, C> view() const
+      {
+      if (m_rows != R || m_cols != C)
+        {
+        throw std::length_error("Shape of the mapped matrix doesn`t match requested matrix size");
+        }
+      return MatrixView<const T, R, C>(m_data, C);
+      }
+
+    /// <summary>
+    /// Copies the whole matrix into memory.
+    /// </summary>
+    DynamicMatrix<T> to_dynamic() const
+      {
+      DynamicMatrix<T> result(m_rows, m_cols);
+      std::copy(m_data, m_data + m_rows * m_cols, result.data());
+      return result;
+      }
+
+    private:
+
+    void swap(MappedMatrix& other) noexcept
+      {
+      std::swap(m_mapping, other.m_mapping);
+      std::swap(m_mapping_size, other.m_mapping_size);
+      std::swap(m_data, other.m_data);
+      std::swap(m_rows, other.m_rows);
+      std::swap(m_cols, other.m_cols);
+      }
+
+    void map(const std::string& path)
+      {
+#if defined(_WIN32)
+      HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+        {
+        throw std::runtime_error("Can`t open file " + path);
+        }
+      LARGE_INTEGER size;
+      GetFileSizeEx(file, &size);
+      HANDLE mapping = size.QuadPart > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+      CloseHandle(file);
+      if (mapping == nullptr)
+        {
+        throw std::runtime_error("Can`t map file " + path);
+        }
+      m_mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      CloseHandle(mapping);
+      if (m_mapping == nullptr)
+        {
+        throw std::runtime_error("Can`t map file " + path);
+        }
+      m_mapping_size = static_cast<size_t>(size.QuadPart);
+#else
+      const int file = ::open(path.c_str(), O_RDONLY);
+      if (file < 0)
+        {
+        throw std::runtime_error("Can`t open file " + path);
+        }
+      struct stat info;
+      if (::fstat(file, &info) != 0 || info.st_size <= 0)
+        {
+        ::close(file);
+        throw std::runtime_error("Can`t map file " + path);
+        }
+      void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+      ::close(file);
+      if (mapping == MAP_FAILED)
+        {
+        throw std::runtime_error("Can`t map file " + path);
+        }
+      m_mapping = mapping;
+      m_mapping_size = static_cast<size_t>(info.st_size);
+#endif
+
+      try
+        {
+        MatrixFileHeader header;
+        std::memcpy(&header, m_mapping, std::min(sizeof(header), m_mapping_size));
+        Detail::check_header(header, m_mapping_size, element_type_of<T>(), sizeof(T), path);
+        m_data = reinterpret_cast<const T*>(static_cast<const char*>(m_mapping) + header.data_offset);
+        m_rows = static_cast<size_t>(header.rows);
+        m_cols = static_cast<size_t>(header.cols);
+        }
+      catch (...)
+        {
+        unmap();
+        throw;
+        }
+      }
+
+    void unmap() noexcept
+      {
+      if (m_mapping == nullptr)
+        {
+        return;
+        }
+#if defined(_WIN32)
+      UnmapViewOfFile(m_mapping);
+#else
+      ::munmap(const_cast<void*>(m_mapping), m_mapping_size);
+#endif
+      m_mapping = nullptr;
+      m_data = nullptr;
+      }
+    };
+
+
+  /// <summary>
+  /// Matrix stored in a file that is read and written block by block through streams, for matrices
+  /// that don`t fit into memory. Only path and shape are kept, every user opens its own stream,
+  /// so different threads may work with the same file at once.
+  /// </summary>
+  template <typename T>
+  class MatrixFile
+    {
+    std::string m_path;
+    size_t m_rows = 0;
+    size_t m_cols = 0;
+    uint64_t m_data_offset = 0;
+
+    public:
+
+    /// <summary>
+    /// Opens existing file written by write_binary or create.
+    /// </summary>
+    explicit MatrixFile(const std::string& path) : m_path(path)
+      {
+      std::ifstream file(path, std::ios::binary | std::ios::ate);
+      if (!file)
+        {
+        throw std::runtime_error("Can`t open file " + path);
+        }
+      const uint64_t file_size = static_cast<uint64_t>(file.tellg());
+      MatrixFileHeader header {};
+      file.seekg(0);
+      file.read(reinterpret_cast<char*>(&header), static_cast<std::streamsize>(std::min<uint64_t>(sizeof(header), file_size)));
+      Detail::check_header(header, file_size, element_type_of<T>(), sizeof(T), path);
+      m_rows = static_cast<size_t>(header.rows);
+      m_cols = static_cast<size_t>(header.cols);
+      m_data_offset = header.data_offset;
+      }
+
+    /// <summary>
+    /// Creates rows x cols file filled with zeros, replacing existing one.
+    /// </summary>
+    static MatrixFile create(const std::string& path, size_t rows, size_t cols)
+      {
+      const MatrixFileHeader header = Detail::make_header<T>(rows, cols);
+        {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+          {
+          throw std::runtime_error("Can`t open file " + path + " for writing");
+          }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+      std::filesystem::resize_file(path, header.data_offset + uint64_t(rows) * cols * sizeof(T));
+      return MatrixFile(path);
+      }
+
+    const std::string& get_path() const { return m_path; }
+    size_t get_n_rows() const { return m_rows; }
+    size_t get_n_cols() const { return m_cols; }
+
+    std::ifstream open_for_reading() const
+      {
+      std::ifstream stream(m_path, std::ios::binary);
+      if (!stream)
+        {
+        throw std::runtime_error("Can`t open file " + m_path);
+        }
+      return stream;
+      }
+
+    std::fstream open_for_writing() const
+      {
+      std::fstream stream(m_path, std::ios::binary | std::ios::in | std::ios::out);
+      if (!stream)
+        {
+        throw std::runtime_error("Can`t open file " + m_path + " for writing");
+        }
+      return stream;
+      }
+
+    /// <summary>
+    /// Reads n_rows x n_cols block starting at (row, col) into contiguous row-major dst.
+    /// Indices start from 1 as in Matrix::at.
+    /// </summary>
+    void read_block(std::istream& stream, size_t row, size_t col, size_t n_rows, size_t n_cols, T* dst) const
+      {
+      ::Detail::check_block(row, col, n_rows, n_cols, m_rows, m_cols);
+      // full-width blocks are one contiguous range of the file
+      const size_t n_runs = n_cols == m_cols ? 1 : n_rows;
+      const size_t run_length = n_cols == m_cols ? n_rows * n_cols : n_cols;
+      for (size_t run = 0; run < n_runs; ++run)
+        {
+        stream.seekg(static_cast<std::streamoff>(offset(row + run, col)));
+        stream.read(reinterpret_cast<char*>(dst + run * run_length), static_cast<std::streamsize>(run_length * sizeof(T)));
+        }
+      if (!stream)
+        {
+        throw std::runtime_error("Can`t read file " + m_path);
+        }
+      }
+
+    /// <summary>
+    /// Writes contiguous row-major n_rows x n_cols block src at (row, col).
+    /// </summary>
+    void write_block(std::ostream& stream, size_t row, size_t col, size_t n_rows, size_t n_cols, const T* src) const
+      {
+      ::Detail::check_block(row, col, n_rows, n_cols, m_rows, m_cols);
+      const size_t n_runs = n_cols == m_cols ? 1 : n_rows;
+      const size_t run_length = n_cols == m_cols ? n_rows * n_cols : n_cols;
+      for (size_t run = 0; run < n_runs; ++run)
+        {
+        stream.seekp(static_cast<std::streamoff>(offset(row + run, col)));
+        stream.write(reinterpret_cast<const char*>(src + run * run_length), static_cast<std::streamsize>(run_length * sizeof(T)));
+        }
+      if (!stream)
+        {
+        throw std::runtime_error("Can`t write file " + m_path);
+        }
+      }
+
+    private:
+
+    uint64_t offset(size_t row, size_t col) const
+      {
+      return m_data_offset + (uint64_t(row - 1) * m_cols + col - 1) * sizeof(T);
+      }
+    };
+
+
+  /// <summary>
+  /// Reads the whole file into a DynamicMatrix.
+  /// </summary>
+  template <typename T>
+  DynamicMatrix<T> read_binary(const std::string& path)
+    {
+    return MappedMatrix<T>(path).to_dynamic();
+    }
+
+  }
@@ -1,208 +1,2135 @@
 #pragma once
 
+#include <cmath>
 #include <vector>
 #include <cassert>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
 #include "IMatrixProcessor.h"
+#include "DynamicMatrix.h"
+#include "MatrixBatch.h"
+#include "TransposedView.h"
+#include "MatrixView.h"
+#include "SparseMatrix.h"
+#include "Gemm.h"
+#include "FixedKernels.h"
+#include "Strassen.h"
+#include "OutOfCore.h"
+#include "Simd.h"
+#include "HalfFloat.h"
+#include "Quantization.h"
+#include "ThreadPool.h"
+#include "ConstantEvaluation.h"
 
 /// <summary>
-/// This namespace contains implementations of IMatrixProcessor
+/// This namespace contains implementations of IMatrixProcessor.
+/// Scalar, elementwise, transpose and product processors are constexpr on Matrix with inline storage,
+/// so chains of them over constant operands are computed by the compiler.
 /// </summary>
 namespace MatrixProcessors {
 
+  /// <summary>
+  /// Elementwise passes are split between threads in chunks of at least this many elements.
+  /// </summary>
+  constexpr size_t elementwise_parallel_grain = 1 << 15;
+
+  /// <summary>
+  /// Batched products walk the batch in blocks of this many matrices, so the lanes they touch stay in cache.
+  /// </summary>
+  constexpr size_t batch_lane_block = 512;
+
+  /// <summary>
+  /// Batched products are split between threads in chunks of at least this many matrices.
+  /// </summary>
+  constexpr size_t batch_parallel_grain = 8 * batch_lane_block;
+
+  /// <summary>
+  /// Transpose splits blocks until they have at most this many elements, so source rows and destination columns of a block stay in L1.
+  /// </summary>
+  constexpr size_t transpose_block_elements = 32 * 32;
+
+  namespace Detail {
+
+    // During constant evaluation the passes below run in the calling thread, threads can't be started there
+    template <typename Op, typename R, typename A, typename B>
+    constexpr void transform(const ExecutionPolicy& policy, const A* a, const B* b, R* out, size_t n)
+      {
+      if (ConstantEvaluation::is_constant_evaluated())
+        {
+        Simd::transform<Op>(a, b, out, n);
+        return;
+        }
+      parallel_for(policy, n, elementwise_parallel_grain, [=](size_t begin, size_t end)
+        {
+        Simd::transform<Op>(a + begin, b + begin, out + begin, end - begin);
+        });
+      }
+
+    template <typename Op, typename R, typename A, typename B>
+    constexpr void transform_scalar(const ExecutionPolicy& policy, const A* a, const B& b, R* out, size_t n)
+      {
+      if (ConstantEvaluation::is_constant_evaluated())
+        {
+        Simd::transform_scalar<Op>(a, b, out, n);
+        return;
+        }
+      parallel_for(policy, n, elementwise_parallel_grain, [=, &b](size_t begin, size_t end)
+        {
+        Simd::transform_scalar<Op>(a + begin, b, out + begin, end - begin);
+        });
+      }
+
+    /// <summary>
+    /// Throws when the n_out bytes written to out overlap one of the operands.
+    /// Used by processors whose output can not alias their input.
+    /// </summary>
+    constexpr void check_not_aliased(const void* out, size_t n_out, const void* in, size_t n_in)
+      {
+      // addresses of different objects can't be ordered at compile time, but there operands are whole matrices,
+      // which overlap only when they are the same object
+      if (ConstantEvaluation::is_constant_evaluated())
+        {
+        if (out == in)
+          {
+          throw std::invalid_argument("Output matrix overlaps an operand of the operation");
+          }
+        return;
+        }
+      const std::uintptr_t out_begin = reinterpret_cast<std::uintptr_t>(out);
+      const std::uintptr_t in_begin = reinterpret_cast<std::uintptr_t>(in);
+      if (out_begin < in_begin + n_in && in_begin < out_begin + n_out)
+        {
+        throw std::invalid_argument("Output matrix overlaps an operand of the operation");
+        }
+      }
+
+
+    /// <summary>
+    /// dst[j * ldd + i] = src[i * lds + j] for rows x cols block of src.
+    /// Cache-oblivious: the longer side is halved until the block is small enough for a plain loop.
+    /// </summary>
+    template <typename T, typename V>
+    constexpr void transpose(size_t rows, size_t cols, const T* src, size_t lds, V* dst, size_t ldd)
+      {
+      if (rows * cols <= transpose_block_elements)
+        {
+        for (size_t i = 0; i < rows; ++i)
+          {
+          for (size_t j = 0; j < cols; ++j)
+            {
+            dst[j * ldd + i] = src[i * lds + j];
+            }
+          }
+        }
+      else if (rows >= cols)
+        {
+        const size_t half = rows / 2;
+        transpose(half, cols, src, lds, dst, ldd);
+        transpose(rows - half, cols, src + half * lds, lds, dst + half, ldd);
+        }
+      else
+        {
+        const size_t half = cols / 2;
+        transpose(rows, half, src, lds, dst, ldd);
+        transpose(rows, cols - half, src + half, lds, dst + half * ldd, ldd);
+        }
+      }
+
+    /// <summary>
+    /// Transposes rows x cols row-major matrix, rows are split between threads allowed by the policy.
+    /// </summary>
+    template <typename T, typename V>
+    constexpr void transpose(const ExecutionPolicy& policy, size_t rows, size_t cols, const T* src, V* dst)
+      {
+      if (ConstantEvaluation::is_constant_evaluated())
+        {
+        transpose(rows, cols, src, cols, dst, rows);
+        return;
+        }
+      const size_t grain = std::max<size_t>(1, elementwise_parallel_grain / std::max<size_t>(cols, 1));
+      parallel_for(policy, rows, grain, [=](size_t begin, size_t end)
+        {
+        transpose(end - begin, cols, src + begin * cols, cols, dst + begin, rows);
+        });
+      }
+
+    /// <summary>
+    /// out = A * B for operands addressed through row and column strides, out is m x n with row stride rso.
+    /// </summary>
+    template <typename T, typename U, typename W>
+    void multiply_strided(const ExecutionPolicy& policy, size_t m, size_t n, size_t k,
+                          const T* a, size_t rsa, size_t csa, const U* b, size_t rsb, size_t csb, W* out, size_t rso)
+      {
+      if (m * n * k > Gemm::small_product_threshold)
+        {
+        Gemm::multiply(m, n, k, a, rsa, csa, b, rsb, csb, out, rso, policy);
+        }
+      else
+        {
+        for (size_t i = 0; i < m; ++i)
+          {
+          std::fill(out + i * rso, out + i * rso + n, W(0));
+          }
+        Gemm::multiply_small(m, n, k, a, rsa, csa, b, rsb, csb, out, rso);
+        }
+      }
+
+    /// <summary>
+    /// y = A * x for row-major m x k A. Every element of A is read once, so the product is bound by memory
+    /// bandwidth and packing A for Gemm would only add traffic. Simd::dot_rows takes rows four at a time,
+    /// threads take ranges of such groups, so results don`t depend on the policy.
+    /// </summary>
+    template <typename T, typename U, typename W>
+    void multiply_matrix_vector(const ExecutionPolicy& policy, size_t m, size_t k, const T* a, const U* x, W* y)
+      {
+      const size_t n_groups = (m + 3) / 4;
+      parallel_for(policy, n_groups, std::max<size_t>(1, elementwise_parallel_grain / std::max<size_t>(1, 4 * k)), [=](size_t begin, size_t end)
+        {
+        const size_t first_row = begin * 4;
+        Simd::dot_rows(a + first_row * k, k, std::min(m, end * 4) - first_row, x, y + first_row, k);
+        });
+      }
+
+    /// <summary>
+    /// y = x * A for vector x of m elements and row-major m x n A: rows of A scaled by elements of x are added to y,
+    /// so A is streamed once in memory order and every element of y is summed in order of the inner index as by
+    /// the plain loop. Threads take ranges of columns, which are walked in blocks small enough to keep their part of y in L1.
+    /// </summary>
+    template <typename T, typename U, typename W>
+    void multiply_vector_matrix(const ExecutionPolicy& policy, size_t m, size_t n, const T* x, const U* a, W* y)
+      {
+      constexpr size_t block = 2048;
+      parallel_for(policy, n, std::max<size_t>(1, elementwise_parallel_grain / std::max<size_t>(1, m)), [=](size_t begin, size_t end)
+        {
+        for (size_t jb = begin; jb < end; jb += block)
+          {
+          const size_t width = std::min(block, end - jb);
+          std::fill(y + jb, y + jb + width, W(0));
+          for (size_t p = 0; p < m; ++p)
+            {
+            Simd::multiply_accumulate_scalar(x[p], a + p * n + jb, y + jb, width);
+            }
+          }
+        });
+      }
+
+    /// <summary>
+    /// c = alpha * x * y^T + beta * c for vectors x of m and y of n elements, the product with inner dimension 1.
+    /// Row i of the product is x[i] times y, so every row of c takes one SIMD pass over y and c is streamed once.
+    /// alpha = 1 with beta = 0 is the outer product, with beta = 1 the rank-1 update c += x * y^T.
+    /// Threads take ranges of rows.
+    /// </summary>
+    template <typename T, typename U, typename W>
+    void rank_one_update(const ExecutionPolicy& policy, size_t m, size_t n, W alpha, const T* x, const U* y, W beta, W* c)
+      {
+      parallel_for(policy, m, std::max<size_t>(1, elementwise_parallel_grain / std::max<size_t>(1, n)), [=](size_t begin, size_t end)
+        {
+        for (size_t i = begin; i < end; ++i)
+          {
+          W* c_row = c + i * n;
+          const T x_i = x[i];
+          if (alpha == W(1) && beta == W(0))
+            {
+            Simd::transform_scalar<Simd::Multiply>(y, x_i, c_row, n);
+            }
+          else if (alpha == W(1) && beta == W(1))
+            {
+            Simd::multiply_accumulate_scalar(x_i, y, c_row, n);
+            }
+          else if (beta == W(0))
+            {
+            for (size_t j = 0; j < n; ++j)
+              {
+              c_row[j] = alpha * W(x_i * y[j]);
+              }
+            }
+          else
+            {
+            for (size_t j = 0; j < n; ++j)
+              {
+              c_row[j] = alpha * W(x_i * y[j]) + beta * c_row[j];
+              }
+            }
+          }
+        });
+      }
+
+    /// <summary>
+    /// c = alpha * A * B + beta * c for contiguous row-major m x k A, k x n B and m x n c.
+    /// </summary>
+    template <typename T, typename U, typename W>
+    void multiply_add(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, W alpha, const T* a, const U* b, W beta, W* c)
+      {
+      if (k == 1)
+        {
+        rank_one_update(policy, m, n, alpha, a, b, beta, c);
+        }
+      else if (m * n * k > Gemm::small_product_threshold)
+        {
+        Gemm::multiply_add(m, n, k, alpha, a, k, 1, b, n, 1, beta, c, n, policy);
+        }
+      else
+        {
+        Gemm::multiply_add_small(m, n, k, alpha, a, k, 1, b, n, 1, beta, c, n);
+        }
+      }
+
+
+    /// <summary>
+    /// out = A * B for sparse R x C matrix A, dense row-major C x n matrix B and R x n matrix out.
+    /// Rows of CSR matrix are independent, so threads take ranges of rows. Every column of CSC matrix
+    /// adds to many rows of out, so there threads take ranges of columns of B and out instead.
+    /// Rows of B are added to rows of out as whole vectors, which is what SIMD is used for.
+    /// </summary>
+    template <typename T, size_t R, size_t C, SparseLayout L, typename U, typename W>
+    void multiply_sparse(const ExecutionPolicy& policy, const SparseMatrix<T, R, C, L>& a, const U* b, size_t n, W* out)
+      {
+      const T* values = a.get_values().data();
+      const auto* indices = a.get_indices().data();
+      const size_t* offsets = a.get_offsets().data();
+
+      if constexpr (L == SparseLayout::CSR)
+        {
+        const size_t work_per_row = std::max<size_t>(1, a.get_n_nonzeros() / R) * n;
+        parallel_for(policy, R, std::max<size_t>(1, elementwise_parallel_grain / work_per_row), [=](size_t begin, size_t end)
+          {
+          for (size_t row = begin; row < end; ++row)
+            {
+            W* out_row = out + row * n;
+            if (n == 1)
+              {
+              W sum = 0;
+              for (size_t i = offsets[row]; i < offsets[row + 1]; ++i)
+                {
+                sum += values[i] * b[indices[i]];
+                }
+              out_row[0] = sum;
+              }
+            else
+              {
+              std::fill(out_row, out_row + n, W(0));
+              for (size_t i = offsets[row]; i < offsets[row + 1]; ++i)
+                {
+                Simd::multiply_accumulate_scalar(values[i], b + indices[i] * n, out_row, n);
+                }
+              }
+            }
+          });
+        }
+      else
+        {
+        const size_t work_per_col = std::max<size_t>(1, a.get_n_nonzeros());
+        parallel_for(policy, n, std::max<size_t>(1, elementwise_parallel_grain / work_per_col), [=](size_t begin, size_t end)
+          {
+          const size_t width = end - begin;
+          for (size_t row = 0; row < R; ++row)
+            {
+            std::fill(out + row * n + begin, out + row * n + end, W(0));
+            }
+          for (size_t col = 0; col < C; ++col)
+            {
+            const U* b_row = b + col * n + begin;
+            if (n == 1)
+              {
+              for (size_t i = offsets[col]; i < offsets[col + 1]; ++i)
+                {
+                out[indices[i]] += values[i] * b_row[0];
+                }
+              continue;
+              }
+            for (size_t i = offsets[col]; i < offsets[col + 1]; ++i)
+              {
+              Simd::multiply_accumulate_scalar(values[i], b_row, out + indices[i] * n + begin, width);
+              }
+            }
+          });
+        }
+      }
+
+
+    /// <summary>
+    /// Fixed-shape operand seen as data pointer and strides: element (i, j), counted from 0,
+    /// is data[i * row_stride + j * col_stride]. T is const for operands that can only be read.
+    /// </summary>
+    template <typename T>
+    struct Strided
+      {
+      T* data;
+      size_t row_stride;
+      size_t col_stride;
+      };
+
+    template <typename T, size_t R, size_t C, typename A>
+    Strided<T> strided(Matrix<T, R, C, A>& mat) { return { mat.data(), C, 1 }; }
+
+    template <typename T, size_t R, size_t C, typename A>
+    Strided<const T> strided(const Matrix<T, R, C, A>& mat) { return { mat.data(), C, 1 }; }
+
+    template <typename T, size_t R, size_t C>
+    Strided<T> strided(const MatrixView<T, R, C>& view) { return { view.data(), view.get_row_stride(), 1 }; }
+
+    template <typename T, size_t R, size_t C>
+    Strided<const T> strided(const TransposedView<T, R, C>& view) { return { view.data(), view.get_row_stride(), view.get_col_stride() }; }
+
+
+    template <typename X, typename = void>
+    struct is_strided_operand : std::false_type {};
+
+    template <typename X>
+    struct is_strided_operand<X, std::void_t<decltype(strided(std::declval<X&>()))>> : std::true_type {};
+
+    template <typename X>
+    struct is_matrix_view : std::false_type {};
+
+    template <typename T, size_t R, size_t C>
+    struct is_matrix_view<MatrixView<T, R, C>> : std::true_type {};
+
+    // Generic overloads taking any fixed-shape operand are enabled only when a MatrixView takes part,
+    // calls with Matrix and TransposedView operands keep using their own overloads
+    template <typename... X>
+    constexpr bool accepts_views = (is_strided_operand<std::remove_reference_t<X>>::value && ...)
+                                && (is_matrix_view<std::remove_cv_t<std::remove_reference_t<X>>>::value || ...);
+
+    template <typename X>
+    using element_t = std::remove_const_t<std::remove_pointer_t<decltype(strided(std::declval<X&>()).data)>>;
+
+    template <typename X>
+    constexpr bool is_writable = !std::is_const_v<std::remove_pointer_t<decltype(strided(std::declval<X&>()).data)>>;
+
+
+    /// <summary>
+    /// Number of bytes from the first to one past the last element of rows x cols strided operand.
+    /// </summary>
+    template <typename T>
+    size_t extent_bytes(const Strided<T>& s, size_t rows, size_t cols)
+      {
+      return ((rows - 1) * s.row_stride + (cols - 1) * s.col_stride + 1) * sizeof(T);
+      }
+
+
+    /// <summary>
+    /// Throws when rows x cols strided output overlaps the operand other than exactly, i.e. starting
+    /// at the same element with the same strides. Elementwise passes read and write each element
+    /// at the same index, so only the exact case is safe.
+    /// </summary>
+    template <typename R, typename T>
+    void check_elementwise_aliasing(const Strided<R>& out, const Strided<T>& in, size_t rows, size_t cols)
+      {
+      if (static_cast<const void*>(out.data) == static_cast<const void*>(in.data) && out.row_stride == in.row_stride && out.col_stride == in.col_stride)
+        {
+        return;
+        }
+      check_not_aliased(out.data, extent_bytes(out, rows, cols), in.data, extent_bytes(in, rows, cols));
+      }
+
+
+    /// <summary>
+    /// Elementwise pass over rows x cols strided operands, row by row with SIMD when rows are contiguous.
+    /// out is always contiguous along rows.
+    /// </summary>
+    template <typename Op, typename A, typename B, typename R>
+    void transform(const ExecutionPolicy& policy, size_t rows, size_t cols, const Strided<A>& a, const Strided<B>& b, const Strided<R>& out)
+      {
+      const size_t grain = std::max<size_t>(1, elementwise_parallel_grain / cols);
+      parallel_for(policy, rows, grain, [=](size_t begin, size_t end)
+        {
+        for (size_t i = begin; i < end; ++i)
+          {
+          if (a.col_stride == 1 && b.col_stride == 1)
+            {
+            Simd::transform<Op>(a.data + i * a.row_stride, b.data + i * b.row_stride, out.data + i * out.row_stride, cols);
+            continue;
+            }
+          for (size_t j = 0; j < cols; ++j)
+            {
+            out.data[i * out.row_stride + j] = Op::apply(a.data[i * a.row_stride + j * a.col_stride], b.data[i * b.row_stride + j * b.col_stride]);
+            }
+          }
+        });
+      }
+
+    template <typename Op, typename A, typename B, typename R>
+    void transform_scalar(const ExecutionPolicy& policy, size_t rows, size_t cols, const Strided<A>& a, const B& b, const Strided<R>& out)
+      {
+      const size_t grain = std::max<size_t>(1, elementwise_parallel_grain / cols);
+      parallel_for(policy, rows, grain, [=, &b](size_t begin, size_t end)
+        {
+        for (size_t i = begin; i < end; ++i)
+          {
+          if (a.col_stride == 1)
+            {
+            Simd::transform_scalar<Op>(a.data + i * a.row_stride, b, out.data + i * out.row_stride, cols);
+            continue;
+            }
+          for (size_t j = 0; j < cols; ++j)
+            {
+            out.data[i * out.row_stride + j] = Op::apply(a.data[i * a.row_stride + j * a.col_stride], b);
+            }
+          }
+        });
+      }
+
+
+
+    /// <summary>
+    /// out[i] = static_cast<To>(in[i]), float and 16-bit floats convert through the bulk routines of HalfFloat.h.
+    /// </summary>
+    template <typename To, typename From>
+    void convert(const ExecutionPolicy& policy, const From* in, To* out, size_t n)
+      {
+      parallel_for(policy, n, elementwise_parallel_grain, [=](size_t begin, size_t end)
+        {
+        if constexpr (std::is_same_v<From, float> && (std::is_same_v<To, Float16> || std::is_same_v<To, BFloat16>))
+          {
+          To::convert(in + begin, out + begin, end - begin);
+          }
+        else if constexpr ((std::is_same_v<From, Float16> || std::is_same_v<From, BFloat16>) && std::is_same_v<To, float>)
+          {
+          From::convert(in + begin, out + begin, end - begin);
+          }
+        else
+          {
+          for (size_t i = begin; i < end; ++i)
+            {
+            out[i] = static_cast<To>(in[i]);
+            }
+          }
+        });
+      }
+
+
+    /// <summary>
+    /// c = A * B for contiguous row-major operands with every product and sum computed in Acc.
+    /// Large products take the GEMM engine, which packs operands converted to Acc,
+    /// or its pair engine for 8-bit operands accumulated in int32.
+    /// </summary>
+    template <typename Acc, typename T, typename U>
+    void multiply_accumulate(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, const T* a, const U* b, Acc* c)
+      {
+      if (m * n * k > Gemm::small_product_threshold)
+        {
+#if defined(MATRIX_PROCESSING_GEMM_PAIRS)
+        if constexpr (Gemm::has_pair_kernel<T, U, Acc>)
+          {
+          Gemm::multiply_pairs(m, n, k, a, k, 1, b, n, 1, c, n, policy);
+          return;
+          }
+#endif
+        Gemm::multiply(m, n, k, a, k, 1, b, n, 1, c, n, policy);
+        return;
+        }
+      std::fill(c, c + m * n, Acc(0));
+      for (size_t i = 0; i < m; ++i)
+        {
+        for (size_t p = 0; p < k; ++p)
+          {
+          const Acc a_ip = static_cast<Acc>(a[i * k + p]);
+          for (size_t j = 0; j < n; ++j)
+            {
+            c[i * n + j] += a_ip * static_cast<Acc>(b[p * n + j]);
+            }
+          }
+        }
+      }
+
+    /// <summary>
+    /// Same as above with the result converted to W, through a temporary of Acc when W is another type.
+    /// </summary>
+    template <typename Acc, typename T, typename U, typename W>
+    void multiply_wide(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, const T* a, const U* b, W* c)
+      {
+      if constexpr (std::is_same_v<Acc, W>)
+        {
+        multiply_accumulate<Acc>(policy, m, n, k, a, b, c);
+        }
+      else
+        {
+        std::vector<Acc, AlignedAllocator<Acc>> acc(m * n);
+        multiply_accumulate<Acc>(policy, m, n, k, a, b, acc.data());
+        convert(policy, acc.data(), c, m * n);
+        }
+      }
+
+    /// <summary>
+    /// c = (A - za) * (B - zb) in Acc for integral W of type Acc, scale times that for floating-point W.
+    /// </summary>
+    template <typename Acc, typename T, typename U, typename W>
+    void multiply_quantized(const ExecutionPolicy& policy, size_t m, size_t n, size_t k, const T* a, const U* b, W* c,
+                            const Quantization::Params& a_params, const Quantization::Params& b_params)
+      {
+      static_assert(std::is_integral_v<T> && std::is_integral_v<U>, "Quantized operands must be of integral types");
+      static_assert(std::is_same_v<W, Acc> || std::is_floating_point_v<W>, "Output of quantized product must be of the accumulator or a floating-point type");
+
+      if constexpr (std::is_same_v<W, Acc>)
+        {
+        multiply_accumulate<Acc>(policy, m, n, k, a, b, c);
+        Quantization::Detail::subtract_zero_points(m, n, k, a, b, c, a_params.zero_point, b_params.zero_point);
+        }
+      else
+        {
+        std::vector<Acc, AlignedAllocator<Acc>> acc(m * n);
+        multiply_accumulate<Acc>(policy, m, n, k, a, b, acc.data());
+        Quantization::Detail::subtract_zero_points(m, n, k, a, b, acc.data(), a_params.zero_point, b_params.zero_point);
+        const W scale = W(a_params.scale) * W(b_params.scale);
+        const Acc* acc_data = acc.data();
+        parallel_for(policy, m * n, elementwise_parallel_grain, [=](size_t begin, size_t end)
+          {
+          for (size_t i = begin; i < end; ++i)
+            {
+            c[i] = scale * static_cast<W>(acc_data[i]);
+            }
+          });
+        }
+      }
+  }
+
   /// <summary>
   /// Adds scalar to every element of the matrix.
   /// </summary>
-  class AddScalar : public IMatrixProcessor<AddScalar>
+  class AddScalar : public IMatrixProcessor<AddScalar>
+    {
+      public:
+
+      using element_operation = Simd::Add;
+
+      AddScalar() = default;
+      constexpr explicit AddScalar(const ExecutionPolicy& policy) : IMatrixProcessor<AddScalar>(policy) {}
+      ~AddScalar() = default;
+
+      template <typename U, typename V, size_t R, size_t C, typename A>
+      constexpr auto perform_operation_impl(const Matrix<U, R, C, A>& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() + rhs);
+
+        Matrix<result_type, R, C, rebind_allocator_t<A, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      // Output may be lhs itself
+      template <typename U, typename V, size_t R, size_t C, typename A, typename W, typename B>
+      constexpr void perform_operation_into_impl(const Matrix<U, R, C, A>& lhs, const V& rhs, Matrix<W, R, C, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() + rhs)>, "Element type of the output doesn`t match type of the result");
+
+        Detail::transform_scalar<Simd::Add>(m_policy, lhs.data(), rhs, out.data(), R * C);
+        }
+
+
+      template <typename U, typename V, typename A>
+      auto perform_operation_impl(const DynamicMatrix<U, A>& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() + rhs);
+
+        DynamicMatrix<result_type, rebind_allocator_t<A, result_type>> result(lhs.get_n_rows(), lhs.get_n_cols());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename U, typename V, typename A, typename W, typename B>
+      void perform_operation_into_impl(const DynamicMatrix<U, A>& lhs, const V& rhs, DynamicMatrix<W, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() + rhs)>, "Element type of the output doesn`t match type of the result");
+
+        if (out.get_n_rows() != lhs.get_n_rows() || out.get_n_cols() != lhs.get_n_cols())
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
+          }
+
+        Detail::transform_scalar<Simd::Add>(m_policy, lhs.data(), rhs, out.data(), out.get_data().size());
+        }
+
+
+      template <typename U, typename V, size_t R, size_t C, typename A>
+      auto perform_operation_impl(const MatrixBatch<U, R, C, A>& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() + rhs);
+
+        MatrixBatch<result_type, R, C, rebind_allocator_t<A, result_type>> result(lhs.get_batch_size());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename U, typename V, size_t R, size_t C, typename A, typename W, typename B>
+      void perform_operation_into_impl(const MatrixBatch<U, R, C, A>& lhs, const V& rhs, MatrixBatch<W, R, C, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() + rhs)>, "Element type of the output doesn`t match type of the result");
+
+        if (out.get_batch_size() != lhs.get_batch_size())
+          {
+          throw std::length_error("Size of the output batch doesn`t match size of the result");
+          }
+
+        Detail::transform_scalar<Simd::Add>(m_policy, lhs.data(), rhs, out.data(), out.get_data().size());
+        }
+
+
+      // Realization for views, output may be any fixed-shape writable operand including the viewed lhs itself, other overlaps throw
+      template <typename L, typename V, std::enable_if_t<Detail::accepts_views<L>>* = nullptr>
+      auto perform_operation_impl(const L& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<Detail::element_t<const L>>() + rhs);
+
+        Matrix<result_type, L::get_n_rows(), L::get_n_cols()> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename L, typename V, typename O, std::enable_if_t<Detail::accepts_views<L, O>>* = nullptr>
+      void perform_operation_into_impl(const L& lhs, const V& rhs, O&& out) const
+        {
+        using Out = std::remove_reference_t<O>;
+        static_assert(Detail::is_writable<Out>, "Output view is read-only");
+        static_assert(std::is_same_v<Detail::element_t<Out>, decltype(std::declval<Detail::element_t<const L>>() + rhs)>, "Element type of the output doesn`t match type of the result");
+        static_assert(L::get_n_rows() == Out::get_n_rows() && L::get_n_cols() == Out::get_n_cols(), "Shape of the output matrix doesn`t match shape of the result");
+
+        const auto a = Detail::strided(lhs);
+        const auto c = Detail::strided(out);
+        Detail::check_elementwise_aliasing(c, a, L::get_n_rows(), L::get_n_cols());
+
+        Detail::transform_scalar<Simd::Add>(m_policy, L::get_n_rows(), L::get_n_cols(), a, rhs, c);
+        }
+    };
+
+
+  /// <summary>
+  /// Subtracts scalar from every element of the matrix.
+  /// </summary>
+  class SubtractScalar : public IMatrixProcessor<SubtractScalar>
+    {
+      public:
+
+      using element_operation = Simd::Subtract;
+
+      SubtractScalar() = default;
+      constexpr explicit SubtractScalar(const ExecutionPolicy& policy) : IMatrixProcessor<SubtractScalar>(policy) {}
+      ~SubtractScalar() = default;
+
+      template <typename U, typename V, size_t R, size_t C, typename A>
+      constexpr auto perform_operation_impl(const Matrix<U, R, C, A>& lhs, const V& rhs)  const
+        {
+        using result_type = decltype(std::declval<U>() - rhs);
+
+        Matrix<result_type, R, C, rebind_allocator_t<A, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      // Output may be lhs itself
+      template <typename U, typename V, size_t R, size_t C, typename A, typename W, typename B>
+      constexpr void perform_operation_into_impl(const Matrix<U, R, C, A>& lhs, const V& rhs, Matrix<W, R, C, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() - rhs)>, "Element type of the output doesn`t match type of the result");
+
+        Detail::transform_scalar<Simd::Subtract>(m_policy, lhs.data(), rhs, out.data(), R * C);
+        }
+
+
+      template <typename U, typename V, typename A>
+      auto perform_operation_impl(const DynamicMatrix<U, A>& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() - rhs);
+
+        DynamicMatrix<result_type, rebind_allocator_t<A, result_type>> result(lhs.get_n_rows(), lhs.get_n_cols());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename U, typename V, typename A, typename W, typename B>
+      void perform_operation_into_impl(const DynamicMatrix<U, A>& lhs, const V& rhs, DynamicMatrix<W, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() - rhs)>, "Element type of the output doesn`t match type of the result");
+
+        if (out.get_n_rows() != lhs.get_n_rows() || out.get_n_cols() != lhs.get_n_cols())
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
+          }
+
+        Detail::transform_scalar<Simd::Subtract>(m_policy, lhs.data(), rhs, out.data(), out.get_data().size());
+        }
+
+
+      template <typename U, typename V, size_t R, size_t C, typename A>
+      auto perform_operation_impl(const MatrixBatch<U, R, C, A>& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() - rhs);
+
+        MatrixBatch<result_type, R, C, rebind_allocator_t<A, result_type>> result(lhs.get_batch_size());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename U, typename V, size_t R, size_t C, typename A, typename W, typename B>
+      void perform_operation_into_impl(const MatrixBatch<U, R, C, A>& lhs, const V& rhs, MatrixBatch<W, R, C, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() - rhs)>, "Element type of the output doesn`t match type of the result");
+
+        if (out.get_batch_size() != lhs.get_batch_size())
+          {
+          throw std::length_error("Size of the output batch doesn`t match size of the result");
+          }
+
+        Detail::transform_scalar<Simd::Subtract>(m_policy, lhs.data(), rhs, out.data(), out.get_data().size());
+        }
+
+
+      // Realization for views, output may be any fixed-shape writable operand including the viewed lhs itself, other overlaps throw
+      template <typename L, typename V, std::enable_if_t<Detail::accepts_views<L>>* = nullptr>
+      auto perform_operation_impl(const L& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<Detail::element_t<const L>>() - rhs);
+
+        Matrix<result_type, L::get_n_rows(), L::get_n_cols()> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename L, typename V, typename O, std::enable_if_t<Detail::accepts_views<L, O>>* = nullptr>
+      void perform_operation_into_impl(const L& lhs, const V& rhs, O&& out) const
+        {
+        using Out = std::remove_reference_t<O>;
+        static_assert(Detail::is_writable<Out>, "Output view is read-only");
+        static_assert(std::is_same_v<Detail::element_t<Out>, decltype(std::declval<Detail::element_t<const L>>() - rhs)>, "Element type of the output doesn`t match type of the result");
+        static_assert(L::get_n_rows() == Out::get_n_rows() && L::get_n_cols() == Out::get_n_cols(), "Shape of the output matrix doesn`t match shape of the result");
+
+        const auto a = Detail::strided(lhs);
+        const auto c = Detail::strided(out);
+        Detail::check_elementwise_aliasing(c, a, L::get_n_rows(), L::get_n_cols());
+
+        Detail::transform_scalar<Simd::Subtract>(m_policy, L::get_n_rows(), L::get_n_cols(), a, rhs, c);
+        }
+    };
+
+
+  /// <summary>
+  /// Multiply every element of the matrix on scalar.
+  /// </summary>
+  class MultiplyScalar : public IMatrixProcessor<MultiplyScalar>
+    {
+      public:
+
+      using element_operation = Simd::Multiply;
+
+      MultiplyScalar() = default;
+      constexpr explicit MultiplyScalar(const ExecutionPolicy& policy) : IMatrixProcessor<MultiplyScalar>(policy) {}
+      ~MultiplyScalar() = default;
+
+      template <typename U, typename V, size_t R, size_t C, typename A>
+      constexpr auto perform_operation_impl(const Matrix<U, R, C, A>& lhs, const V& rhs)  const
+        {
+        using result_type = decltype(std::declval<U>() * rhs);
+
+        Matrix<result_type, R, C, rebind_allocator_t<A, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      // Output may be lhs itself
+      template <typename U, typename V, size_t R, size_t C, typename A, typename W, typename B>
+      constexpr void perform_operation_into_impl(const Matrix<U, R, C, A>& lhs, const V& rhs, Matrix<W, R, C, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() * rhs)>, "Element type of the output doesn`t match type of the result");
+
+        Detail::transform_scalar<Simd::Multiply>(m_policy, lhs.data(), rhs, out.data(), R * C);
+        }
+
+
+      template <typename U, typename V, typename A>
+      auto perform_operation_impl(const DynamicMatrix<U, A>& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() * rhs);
+
+        DynamicMatrix<result_type, rebind_allocator_t<A, result_type>> result(lhs.get_n_rows(), lhs.get_n_cols());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename U, typename V, typename A, typename W, typename B>
+      void perform_operation_into_impl(const DynamicMatrix<U, A>& lhs, const V& rhs, DynamicMatrix<W, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() * rhs)>, "Element type of the output doesn`t match type of the result");
+
+        if (out.get_n_rows() != lhs.get_n_rows() || out.get_n_cols() != lhs.get_n_cols())
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
+          }
+
+        Detail::transform_scalar<Simd::Multiply>(m_policy, lhs.data(), rhs, out.data(), out.get_data().size());
+        }
+
+
+      template <typename U, typename V, size_t R, size_t C, typename A>
+      auto perform_operation_impl(const MatrixBatch<U, R, C, A>& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() * rhs);
+
+        MatrixBatch<result_type, R, C, rebind_allocator_t<A, result_type>> result(lhs.get_batch_size());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename U, typename V, size_t R, size_t C, typename A, typename W, typename B>
+      void perform_operation_into_impl(const MatrixBatch<U, R, C, A>& lhs, const V& rhs, MatrixBatch<W, R, C, B>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() * rhs)>, "Element type of the output doesn`t match type of the result");
+
+        if (out.get_batch_size() != lhs.get_batch_size())
+          {
+          throw std::length_error("Size of the output batch doesn`t match size of the result");
+          }
+
+        Detail::transform_scalar<Simd::Multiply>(m_policy, lhs.data(), rhs, out.data(), out.get_data().size());
+        }
+
+
+      // Realization for views, output may be any fixed-shape writable operand including the viewed lhs itself, other overlaps throw
+      template <typename L, typename V, std::enable_if_t<Detail::accepts_views<L>>* = nullptr>
+      auto perform_operation_impl(const L& lhs, const V& rhs) const
+        {
+        using result_type = decltype(std::declval<Detail::element_t<const L>>() * rhs);
+
+        Matrix<result_type, L::get_n_rows(), L::get_n_cols()> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename L, typename V, typename O, std::enable_if_t<Detail::accepts_views<L, O>>* = nullptr>
+      void perform_operation_into_impl(const L& lhs, const V& rhs, O&& out) const
+        {
+        using Out = std::remove_reference_t<O>;
+        static_assert(Detail::is_writable<Out>, "Output view is read-only");
+        static_assert(std::is_same_v<Detail::element_t<Out>, decltype(std::declval<Detail::element_t<const L>>() * rhs)>, "Element type of the output doesn`t match type of the result");
+        static_assert(L::get_n_rows() == Out::get_n_rows() && L::get_n_cols() == Out::get_n_cols(), "Shape of the output matrix doesn`t match shape of the result");
+
+        const auto a = Detail::strided(lhs);
+        const auto c = Detail::strided(out);
+        Detail::check_elementwise_aliasing(c, a, L::get_n_rows(), L::get_n_cols());
+
+        Detail::transform_scalar<Simd::Multiply>(m_policy, L::get_n_rows(), L::get_n_cols(), a, rhs, c);
+        }
+    };
+
+
+  /// <summary>
+  /// Adds every element of the first matrix to every element of the second.
+  /// </summary>
+  class AddMatrix : public IMatrixProcessor<AddMatrix>
+    {
+      public:
+
+      using element_operation = Simd::Add;
+
+      AddMatrix() = default;
+      constexpr explicit AddMatrix(const ExecutionPolicy& policy) : IMatrixProcessor<AddMatrix>(policy) {}
+      ~AddMatrix() = default;
+
+      template <typename U, typename V, size_t R, size_t C, typename A, typename B>
+      constexpr auto perform_operation_impl(const Matrix<U, R, C, A>& lhs, const Matrix<V, R, C, B>& rhs)  const
+        {
+        using result_type = decltype(std::declval<U>() + std::declval<V>());
+
+        Matrix<result_type, R, C, rebind_allocator_t<A, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      // Output may be lhs or rhs itself
+      template <typename U, typename V, size_t R, size_t C, typename A, typename B, typename W, typename D>
+      constexpr void perform_operation_into_impl(const Matrix<U, R, C, A>& lhs, const Matrix<V, R, C, B>& rhs, Matrix<W, R, C, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() + std::declval<V>())>, "Element type of the output doesn`t match type of the result");
+
+        Detail::transform<Simd::Add>(m_policy, lhs.data(), rhs.data(), out.data(), R * C);
+        }
+
+
+      template <typename U, typename V, typename A, typename B>
+      auto perform_operation_impl(const DynamicMatrix<U, A>& lhs, const DynamicMatrix<V, B>& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() + std::declval<V>());
+
+        DynamicMatrix<result_type, rebind_allocator_t<A, result_type>> result(lhs.get_n_rows(), lhs.get_n_cols());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename U, typename V, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const DynamicMatrix<U, A>& lhs, const DynamicMatrix<V, B>& rhs, DynamicMatrix<W, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() + std::declval<V>())>, "Element type of the output doesn`t match type of the result");
+
+        if (lhs.get_n_rows() != rhs.get_n_rows() || lhs.get_n_cols() != rhs.get_n_cols())
+          {
+          throw std::length_error("Shapes of the added matrices don`t match");
+          }
+
+        if (out.get_n_rows() != lhs.get_n_rows() || out.get_n_cols() != lhs.get_n_cols())
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
+          }
+
+        Detail::transform<Simd::Add>(m_policy, lhs.data(), rhs.data(), out.data(), out.get_data().size());
+        }
+
+
+      template <typename U, typename V, size_t R, size_t C, typename A, typename B>
+      auto perform_operation_impl(const MatrixBatch<U, R, C, A>& lhs, const MatrixBatch<V, R, C, B>& rhs) const
+        {
+        using result_type = decltype(std::declval<U>() + std::declval<V>());
+
+        MatrixBatch<result_type, R, C, rebind_allocator_t<A, result_type>> result(lhs.get_batch_size());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename U, typename V, size_t R, size_t C, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const MatrixBatch<U, R, C, A>& lhs, const MatrixBatch<V, R, C, B>& rhs, MatrixBatch<W, R, C, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<U>() + std::declval<V>())>, "Element type of the output doesn`t match type of the result");
+
+        if (lhs.get_batch_size() != rhs.get_batch_size())
+          {
+          throw std::length_error("Sizes of the added batches don`t match");
+          }
+
+        if (out.get_batch_size() != lhs.get_batch_size())
+          {
+          throw std::length_error("Size of the output batch doesn`t match size of the result");
+          }
+
+        Detail::transform<Simd::Add>(m_policy, lhs.data(), rhs.data(), out.data(), out.get_data().size());
+        }
+
+
+      // Realization for views, output may be any fixed-shape writable operand including the viewed lhs or rhs itself, other overlaps throw
+      template <typename L, typename Rhs, std::enable_if_t<Detail::accepts_views<L, Rhs>>* = nullptr>
+      auto perform_operation_impl(const L& lhs, const Rhs& rhs) const
+        {
+        using result_type = decltype(std::declval<Detail::element_t<const L>>() + std::declval<Detail::element_t<const Rhs>>());
+
+        Matrix<result_type, L::get_n_rows(), L::get_n_cols()> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename L, typename Rhs, typename O, std::enable_if_t<Detail::accepts_views<L, Rhs, O>>* = nullptr>
+      void perform_operation_into_impl(const L& lhs, const Rhs& rhs, O&& out) const
+        {
+        using Out = std::remove_reference_t<O>;
+        static_assert(Detail::is_writable<Out>, "Output view is read-only");
+        static_assert(std::is_same_v<Detail::element_t<Out>, decltype(std::declval<Detail::element_t<const L>>() + std::declval<Detail::element_t<const Rhs>>())>, "Element type of the output doesn`t match type of the result");
+        static_assert(L::get_n_rows() == Rhs::get_n_rows() && L::get_n_cols() == Rhs::get_n_cols(), "Shapes of the added matrices don`t match");
+        static_assert(L::get_n_rows() == Out::get_n_rows() && L::get_n_cols() == Out::get_n_cols(), "Shape of the output matrix doesn`t match shape of the result");
+
+        const auto a = Detail::strided(lhs);
+        const auto b = Detail::strided(rhs);
+        const auto c = Detail::strided(out);
+        Detail::check_elementwise_aliasing(c, a, L::get_n_rows(), L::get_n_cols());
+        Detail::check_elementwise_aliasing(c, b, L::get_n_rows(), L::get_n_cols());
+
+        Detail::transform<Simd::Add>(m_policy, L::get_n_rows(), L::get_n_cols(), a, b, c);
+        }
+    };
+
+
+  /// <summary>
+  /// Multiplies two matrices.
+  /// Products of 2x2, 3x3 and 4x4 matrices and of those matrices by vectors take unrolled kernels,
+  /// other products of matrix and column or of row and matrix take matrix-vector kernels,
+  /// products of column and row take the outer-product kernel,
+  /// small products take the plain loop and all others take the GEMM engine.
+  /// </summary>
+  class MultiplyMatrix : public IMatrixProcessor<MultiplyMatrix>
+    {
+      public:
+
+      MultiplyMatrix() = default;
+      constexpr explicit MultiplyMatrix(const ExecutionPolicy& policy) : IMatrixProcessor<MultiplyMatrix>(policy) {}
+      ~MultiplyMatrix() = default;
+
+      // General realization
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B>
+      constexpr auto perform_operation_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs)  const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        Matrix<result_type, R1, C2, rebind_allocator_t<A, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      // Output is read while the product is accumulated, so it must not overlap lhs or rhs
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B, typename W, typename D>
+      constexpr void perform_operation_into_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs, Matrix<W, R1, C2, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        W* out_data = out.data();
+
+        Detail::check_not_aliased(out_data, R1 * C2 * sizeof(W), lhs.data(), R1 * C1_R2 * sizeof(T));
+        Detail::check_not_aliased(out_data, R1 * C2 * sizeof(W), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        if constexpr (FixedKernels::is_unrolled<R1, C1_R2, C2>)
+          {
+          FixedKernels::multiply<R1, C1_R2, C2>(lhs.data(), rhs.data(), out_data);
+          return;
+          }
+        else if constexpr (C2 == 1 || R1 == 1)
+          {
+          if (!ConstantEvaluation::is_constant_evaluated())
+            {
+            if constexpr (C2 == 1)
+              {
+              Detail::multiply_matrix_vector(m_policy, R1, C1_R2, lhs.data(), rhs.data(), out_data);
+              }
+            else
+              {
+              Detail::multiply_vector_matrix(m_policy, C1_R2, C2, lhs.data(), rhs.data(), out_data);
+              }
+            return;
+            }
+          }
+        else if constexpr (C1_R2 == 1)
+          {
+          if (!ConstantEvaluation::is_constant_evaluated())
+            {
+            Detail::rank_one_update(m_policy, R1, C2, W(1), lhs.data(), rhs.data(), W(0), out_data);
+            return;
+            }
+          }
+        else if constexpr (R1 * C1_R2 * C2 > Gemm::small_product_threshold)
+          {
+          if (!ConstantEvaluation::is_constant_evaluated())
+            {
+            Gemm::multiply(R1, C2, C1_R2,
+                           lhs.data(), C1_R2, 1,
+                           rhs.data(), C2, 1,
+                           out_data, C2, m_policy);
+            return;
+            }
+          }
+
+        for (size_t i = 0; i < R1 * C2; ++i)
+          {
+          out_data[i] = W(0);
+          }
+        Gemm::multiply_small(R1, C2, C1_R2, lhs.data(), rhs.data(), out_data);
+        }
+
+
+      // Specialized realization for vector-row x vector-col case
+      template <typename T, typename U, size_t C1_R2, typename A, typename B>
+      constexpr auto perform_operation_impl(const Matrix<T, 1, C1_R2, A>& lhs, const Matrix<U, C1_R2, 1, B>& rhs)  const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        Matrix<result_type, 1, 1, rebind_allocator_t<A, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename T, typename U, size_t C1_R2, typename A, typename B, typename W, typename D>
+      constexpr void perform_operation_into_impl(const Matrix<T, 1, C1_R2, A>& lhs, const Matrix<U, C1_R2, 1, B>& rhs, Matrix<W, 1, 1, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        const T* lhs_data = lhs.data();
+        const U* rhs_data = rhs.data();
+
+        if (!ConstantEvaluation::is_constant_evaluated())
+          {
+          // summed the same way as rows of matrix times vector
+          W dot = 0;
+          Simd::dot_rows(lhs_data, C1_R2, 1, rhs_data, &dot, C1_R2);
+          out.data()[0] = dot;
+          return;
+          }
+
+        // the sum is kept in a local, so writing it over an operand is harmless
+        W inner_product = 0;
+
+        for (size_t i = 0; i < C1_R2; ++i)
+          {
+          inner_product += lhs_data[i] * rhs_data[i];
+          }
+
+        out.data()[0] = inner_product;
+        }
+
+
+      // Realizations for transposed views, the viewed data is read through strides and never copied
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename B>
+      auto perform_operation_impl(const TransposedView<T, R1, C1_R2>& lhs, const Matrix<U, C1_R2, C2, B>& rhs)  const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        Matrix<result_type, R1, C2, rebind_allocator_t<B, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename B, typename W, typename D>
+      void perform_operation_into_impl(const TransposedView<T, R1, C1_R2>& lhs, const Matrix<U, C1_R2, C2, B>& rhs, Matrix<W, R1, C2, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), lhs.data(), R1 * C1_R2 * sizeof(T));
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        Detail::multiply_strided(m_policy, R1, C2, C1_R2,
+                                 lhs.data(), lhs.get_row_stride(), lhs.get_col_stride(),
+                                 rhs.data(), C2, 1,
+                                 out.data(), C2);
+        }
+
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A>
+      auto perform_operation_impl(const Matrix<T, R1, C1_R2, A>& lhs, const TransposedView<U, C1_R2, C2>& rhs)  const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        Matrix<result_type, R1, C2, rebind_allocator_t<A, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename W, typename D>
+      void perform_operation_into_impl(const Matrix<T, R1, C1_R2, A>& lhs, const TransposedView<U, C1_R2, C2>& rhs, Matrix<W, R1, C2, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), lhs.data(), R1 * C1_R2 * sizeof(T));
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        Detail::multiply_strided(m_policy, R1, C2, C1_R2,
+                                 lhs.data(), C1_R2, 1,
+                                 rhs.data(), rhs.get_row_stride(), rhs.get_col_stride(),
+                                 out.data(), C2);
+        }
+
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2>
+      auto perform_operation_impl(const TransposedView<T, R1, C1_R2>& lhs, const TransposedView<U, C1_R2, C2>& rhs)  const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        Matrix<result_type, R1, C2> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename W, typename D>
+      void perform_operation_into_impl(const TransposedView<T, R1, C1_R2>& lhs, const TransposedView<U, C1_R2, C2>& rhs, Matrix<W, R1, C2, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), lhs.data(), R1 * C1_R2 * sizeof(T));
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        Detail::multiply_strided(m_policy, R1, C2, C1_R2,
+                                 lhs.data(), lhs.get_row_stride(), lhs.get_col_stride(),
+                                 rhs.data(), rhs.get_row_stride(), rhs.get_col_stride(),
+                                 out.data(), C2);
+        }
+
+
+      // Realization for views, operands are read through their strides and never copied.
+      // Overlap with operands is checked over the whole address range spanned by each view.
+      template <typename L, typename Rhs, std::enable_if_t<Detail::accepts_views<L, Rhs>>* = nullptr>
+      auto perform_operation_impl(const L& lhs, const Rhs& rhs) const
+        {
+        using result_type = decltype(std::declval<Detail::element_t<const L>>() + std::declval<Detail::element_t<const Rhs>>());
+
+        Matrix<result_type, L::get_n_rows(), Rhs::get_n_cols()> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename L, typename Rhs, typename O, std::enable_if_t<Detail::accepts_views<L, Rhs, O>>* = nullptr>
+      void perform_operation_into_impl(const L& lhs, const Rhs& rhs, O&& out) const
+        {
+        using Out = std::remove_reference_t<O>;
+        static_assert(Detail::is_writable<Out>, "Output view is read-only");
+        static_assert(std::is_same_v<Detail::element_t<Out>, decltype(std::declval<Detail::element_t<const L>>() + std::declval<Detail::element_t<const Rhs>>())>, "Element type of the output doesn`t match type of the result");
+        static_assert(L::get_n_cols() == Rhs::get_n_rows(), "Number of columns of the first matrix doesn`t match number of rows of the second");
+        static_assert(L::get_n_rows() == Out::get_n_rows() && Rhs::get_n_cols() == Out::get_n_cols(), "Shape of the output matrix doesn`t match shape of the result");
+
+        constexpr size_t m = L::get_n_rows();
+        constexpr size_t n = Rhs::get_n_cols();
+        constexpr size_t k = L::get_n_cols();
+
+        const auto a = Detail::strided(lhs);
+        const auto b = Detail::strided(rhs);
+        const auto c = Detail::strided(out);
+
+        Detail::check_not_aliased(c.data, Detail::extent_bytes(c, m, n), a.data, Detail::extent_bytes(a, m, k));
+        Detail::check_not_aliased(c.data, Detail::extent_bytes(c, m, n), b.data, Detail::extent_bytes(b, k, n));
+
+        Detail::multiply_strided(m_policy, m, n, k, a.data, a.row_stride, a.col_stride, b.data, b.row_stride, b.col_stride, c.data, c.row_stride);
+        }
+
+
+      // Realization for matrices with runtime dimensions
+      template <typename T, typename U, typename A, typename B>
+      auto perform_operation_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs)  const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        DynamicMatrix<result_type, rebind_allocator_t<A, result_type>> result(lhs.get_n_rows(), rhs.get_n_cols());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename T, typename U, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs, DynamicMatrix<W, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        if (lhs.get_n_cols() != rhs.get_n_rows())
+          {
+          throw std::length_error("Number of columns of the first matrix doesn`t match number of rows of the second");
+          }
+
+        const size_t m = lhs.get_n_rows();
+        const size_t n = rhs.get_n_cols();
+        const size_t k = lhs.get_n_cols();
+
+        if (out.get_n_rows() != m || out.get_n_cols() != n)
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
+          }
+
+        W* out_data = out.data();
+
+        Detail::check_not_aliased(out_data, m * n * sizeof(W), lhs.data(), m * k * sizeof(T));
+        Detail::check_not_aliased(out_data, m * n * sizeof(W), rhs.data(), k * n * sizeof(U));
+
+        if (n == 1)
+          {
+          Detail::multiply_matrix_vector(m_policy, m, k, lhs.data(), rhs.data(), out_data);
+          }
+        else if (m == 1)
+          {
+          Detail::multiply_vector_matrix(m_policy, k, n, lhs.data(), rhs.data(), out_data);
+          }
+        else if (k == 1)
+          {
+          Detail::rank_one_update(m_policy, m, n, W(1), lhs.data(), rhs.data(), W(0), out_data);
+          }
+        else if (m * n * k > Gemm::small_product_threshold)
+          {
+          Gemm::multiply(m, n, k, lhs.data(), k, 1, rhs.data(), n, 1, out_data, n, m_policy);
+          }
+        else
+          {
+          std::fill(out_data, out_data + m * n, W(0));
+          Gemm::multiply_small(m, n, k, lhs.data(), rhs.data(), out_data);
+          }
+        }
+
+
+      // Realization for batches, products of all matrices are computed together lane by lane
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B>
+      auto perform_operation_impl(const MatrixBatch<T, R1, C1_R2, A>& lhs, const MatrixBatch<U, C1_R2, C2, B>& rhs) const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        MatrixBatch<result_type, R1, C2, rebind_allocator_t<A, result_type>> result(lhs.get_batch_size());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const MatrixBatch<T, R1, C1_R2, A>& lhs, const MatrixBatch<U, C1_R2, C2, B>& rhs, MatrixBatch<W, R1, C2, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        const size_t size = lhs.get_batch_size();
+
+        if (rhs.get_batch_size() != size)
+          {
+          throw std::length_error("Sizes of the multiplied batches don`t match");
+          }
+
+        if (out.get_batch_size() != size)
+          {
+          throw std::length_error("Size of the output batch doesn`t match size of the result");
+          }
+
+        Detail::check_not_aliased(out.data(), out.get_data().size() * sizeof(W), lhs.data(), lhs.get_data().size() * sizeof(T));
+        Detail::check_not_aliased(out.data(), out.get_data().size() * sizeof(W), rhs.data(), rhs.get_data().size() * sizeof(U));
+
+        parallel_for(m_policy, size, batch_parallel_grain, [&](size_t begin, size_t end)
+          {
+          for (size_t first = begin; first < end; first += batch_lane_block)
+            {
+            const size_t count = std::min(batch_lane_block, end - first);
+            for (size_t i = 1; i <= R1; ++i)
+              {
+              for (size_t j = 1; j <= C2; ++j)
+                {
+                W* acc = out.lane(i, j) + first;
+                std::fill(acc, acc + count, W(0));
+                for (size_t p = 1; p <= C1_R2; ++p)
+                  {
+                  Simd::multiply_accumulate(lhs.lane(i, p) + first, rhs.lane(p, j) + first, acc, count);
+                  }
+                }
+              }
+            }
+          });
+        }
+
+
+      // Sparse x dense realization, MatrixVectCol is the sparse x vector case
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, SparseLayout L, typename B>
+      auto perform_operation_impl(const SparseMatrix<T, R1, C1_R2, L>& lhs, const Matrix<U, C1_R2, C2, B>& rhs)  const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        Matrix<result_type, R1, C2, rebind_allocator_t<B, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, SparseLayout L, typename B, typename W, typename D>
+      void perform_operation_into_impl(const SparseMatrix<T, R1, C1_R2, L>& lhs, const Matrix<U, C1_R2, C2, B>& rhs, Matrix<W, R1, C2, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        Detail::multiply_sparse(m_policy, lhs, rhs.data(), C2, out.data());
+        }
+
+    };
+
+
+  /// <summary>
+  /// GEMM: alpha * A * B + beta * C computed in one pass over the output, scaling and the addition of C
+  /// happen where the product is written back. perform_operation(A, B, C) returns the result as a new matrix,
+  /// perform_operation_into(A, B, C) accumulates into C in place. Chaining MultiplyMatrix, MultiplyScalar
+  /// and AddMatrix for the same result allocates three temporaries and passes over them three more times.
+  /// alpha and beta are converted to the element type of the result; for integral results they must be whole
+  /// numbers, otherwise std::invalid_argument is thrown. beta = 0 ignores previous contents of C.
+  /// With a column and a row, i.e. inner dimension 1, perform_operation_into(x, y, A) is the rank-1 update
+  /// A += alpha * x * y^T done in one pass over A.
+  /// </summary>
+  class MultiplyAddMatrix : public IMatrixProcessor<MultiplyAddMatrix>
     {
+      double m_alpha = 1.0;
+      double m_beta = 1.0;
+
+      // Integral results would truncate alpha = 0.5 to 0 without notice
+      template <typename W>
+      static W to_element(double scalar)
+        {
+        if constexpr (std::is_integral_v<W>)
+          {
+          if (!std::isfinite(scalar) || scalar != std::trunc(scalar))
+            {
+            throw std::invalid_argument("alpha and beta must be whole numbers when elements of the result are integral");
+            }
+          }
+        return W(scalar);
+        }
+
       public:
 
-      AddScalar() = default;
-      ~AddScalar() = default;
+      MultiplyAddMatrix() = default;
+      MultiplyAddMatrix(double alpha, double beta) : m_alpha(alpha), m_beta(beta) {}
+      explicit MultiplyAddMatrix(const ExecutionPolicy& policy, double alpha = 1.0, double beta = 1.0)
+        : IMatrixProcessor<MultiplyAddMatrix>(policy), m_alpha(alpha), m_beta(beta) {}
+      ~MultiplyAddMatrix() = default;
+
+      double get_alpha() const
+        {
+        return m_alpha;
+        }
+
+      double get_beta() const
+        {
+        return m_beta;
+        }
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B, typename W, typename D>
+      auto perform_operation_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs, const Matrix<W, R1, C2, D>& addend) const
+        {
+        Matrix<W, R1, C2, D> result(addend);
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      // out is both C and the result, so it must not overlap lhs or rhs
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs, Matrix<W, R1, C2, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        const W alpha = to_element<W>(m_alpha);
+        const W beta = to_element<W>(m_beta);
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), lhs.data(), R1 * C1_R2 * sizeof(T));
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        Detail::multiply_add(m_policy, R1, C2, C1_R2, alpha, lhs.data(), rhs.data(), beta, out.data());
+        }
 
-      template <typename U, typename V, size_t R, size_t C >
-      auto perform_operation(const Matrix<U, R, C>& lhs, const V& rhs) const
+
+      template <typename T, typename U, typename A, typename B, typename W, typename D>
+      auto perform_operation_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs, const DynamicMatrix<W, D>& addend) const
         {
+        DynamicMatrix<W, D> result(addend);
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
 
-        const std::vector<U>& lhs_data = lhs.get_data();
 
-        auto type_val = lhs_data[0] + rhs;
+      template <typename T, typename U, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs, DynamicMatrix<W, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
 
-        std::vector<decltype(type_val)> result_data(R * C);
-        for (size_t i = 0; i < result_data.size(); ++i)
+        if (lhs.get_n_cols() != rhs.get_n_rows())
           {
-          result_data[i] = lhs_data[i] + rhs;
+          throw std::length_error("Number of columns of the first matrix doesn`t match number of rows of the second");
           }
 
-        Matrix<decltype(type_val), R, C> result(std::move(result_data));
+        const size_t m = lhs.get_n_rows();
+        const size_t n = rhs.get_n_cols();
+        const size_t k = lhs.get_n_cols();
 
-        return result;
+        if (out.get_n_rows() != m || out.get_n_cols() != n)
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
+          }
+
+        const W alpha = to_element<W>(m_alpha);
+        const W beta = to_element<W>(m_beta);
+        Detail::check_not_aliased(out.data(), m * n * sizeof(W), lhs.data(), m * k * sizeof(T));
+        Detail::check_not_aliased(out.data(), m * n * sizeof(W), rhs.data(), k * n * sizeof(U));
+
+        Detail::multiply_add(m_policy, m, n, k, alpha, lhs.data(), rhs.data(), beta, out.data());
         }
     };
 
 
   /// <summary>
-  /// Subtracts scalar from every element of the matrix.
+  /// Transposes matrix. Use transposed() instead when the transpose is only read once.
   /// </summary>
-  class SubtractScalar : public IMatrixProcessor<SubtractScalar>
+  class Transpose : public IMatrixProcessor<Transpose>
     {
       public:
 
-      SubtractScalar() = default;
-      ~SubtractScalar() = default;
+      Transpose() = default;
+      constexpr explicit Transpose(const ExecutionPolicy& policy) : IMatrixProcessor<Transpose>(policy) {}
+      ~Transpose() = default;
+
+      template <typename U, size_t R, size_t C, typename A>
+      constexpr auto perform_operation_impl(const Matrix<U, R, C, A>& mat) const
+        {
+        Matrix<U, C, R, A> result;
+        perform_operation_into_impl(mat, result);
 
-      template <typename U, typename V, size_t R, size_t C >
-      auto perform_operation(const Matrix<U, R, C>& lhs, const V& rhs)  const
+        return result;
+        }
+
+
+      // Output must not overlap the operand, even for square matrices
+      template <typename U, size_t R, size_t C, typename A, typename W, typename B>
+      constexpr void perform_operation_into_impl(const Matrix<U, R, C, A>& mat, Matrix<W, C, R, B>& out) const
+        {
+        static_assert(std::is_same_v<W, U>, "Element type of the output doesn`t match type of the result");
+
+        Detail::check_not_aliased(out.data(), R * C * sizeof(W), mat.data(), R * C * sizeof(U));
+
+        Detail::transpose(m_policy, R, C, mat.data(), out.data());
+        }
+
+
+      template <typename U, typename A>
+      auto perform_operation_impl(const DynamicMatrix<U, A>& mat) const
         {
+        DynamicMatrix<U, A> result(mat.get_n_cols(), mat.get_n_rows());
+        perform_operation_into_impl(mat, result);
+
+        return result;
+        }
+
 
-        const std::vector<U>& lhs_data = lhs.get_data();
+      template <typename U, typename A, typename W, typename B>
+      void perform_operation_into_impl(const DynamicMatrix<U, A>& mat, DynamicMatrix<W, B>& out) const
+        {
+        static_assert(std::is_same_v<W, U>, "Element type of the output doesn`t match type of the result");
 
-        auto type_val = lhs_data[0] - rhs;
+        const size_t rows = mat.get_n_rows();
+        const size_t cols = mat.get_n_cols();
 
-        std::vector<decltype(type_val)> result_data(R * C);
-        for (size_t i = 0; i < result_data.size(); ++i)
+        if (out.get_n_rows() != cols || out.get_n_cols() != rows)
           {
-          result_data[i] = lhs_data[i] - rhs;
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
           }
 
-        Matrix<decltype(type_val), R, C> result(std::move(result_data));
+        Detail::check_not_aliased(out.data(), rows * cols * sizeof(W), mat.data(), rows * cols * sizeof(U));
+
+        Detail::transpose(m_policy, rows, cols, mat.data(), out.data());
+        }
+
+
+      template <typename M, std::enable_if_t<Detail::accepts_views<M>>* = nullptr>
+      auto perform_operation_impl(const M& mat) const
+        {
+        Matrix<Detail::element_t<const M>, M::get_n_cols(), M::get_n_rows()> result;
+        perform_operation_into_impl(mat, result);
 
         return result;
         }
+
+
+      template <typename M, typename O, std::enable_if_t<Detail::accepts_views<M, O>>* = nullptr>
+      void perform_operation_into_impl(const M& mat, O&& out) const
+        {
+        using Out = std::remove_reference_t<O>;
+        static_assert(Detail::is_writable<Out>, "Output view is read-only");
+        static_assert(std::is_same_v<Detail::element_t<Out>, Detail::element_t<const M>>, "Element type of the output doesn`t match type of the result");
+        static_assert(M::get_n_rows() == Out::get_n_cols() && M::get_n_cols() == Out::get_n_rows(), "Shape of the output matrix doesn`t match shape of the result");
+
+        const auto src = Detail::strided(mat);
+        const auto dst = Detail::strided(out);
+
+        Detail::check_not_aliased(dst.data, Detail::extent_bytes(dst, M::get_n_cols(), M::get_n_rows()), src.data, Detail::extent_bytes(src, M::get_n_rows(), M::get_n_cols()));
+
+        Detail::transpose(M::get_n_rows(), M::get_n_cols(), src.data, src.row_stride, dst.data, dst.row_stride);
+        }
     };
 
 
   /// <summary>
-  /// Multiply every element of the matrix on scalar.
+  /// Multiplies two matrices by recursive Strassen-Winograd algorithm.
+  /// Meant for large square products, accuracy is traded for speed, see Strassen.h.
   /// </summary>
-  class MultiplyScalar : public IMatrixProcessor<MultiplyScalar>
+  class StrassenMultiplyMatrix : public IMatrixProcessor<StrassenMultiplyMatrix>
     {
+      size_t m_cutoff = Strassen::default_cutoff;
+
       public:
 
-      MultiplyScalar() = default;
-      ~MultiplyScalar() = default;
+      StrassenMultiplyMatrix() = default;
+      explicit StrassenMultiplyMatrix(size_t cutoff) : m_cutoff(cutoff) {}
+      explicit StrassenMultiplyMatrix(const ExecutionPolicy& policy, size_t cutoff = Strassen::default_cutoff)
+        : IMatrixProcessor<StrassenMultiplyMatrix>(policy), m_cutoff(cutoff) {}
+      ~StrassenMultiplyMatrix() = default;
+
+      size_t get_cutoff() const
+        {
+        return m_cutoff;
+        }
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B>
+      auto perform_operation_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs)  const
+        {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
+
+        Matrix<result_type, R1, C2, rebind_allocator_t<A, result_type>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      // Output must not overlap lhs or rhs
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs, Matrix<W, R1, C2, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), lhs.data(), R1 * C1_R2 * sizeof(T));
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        Strassen::multiply(R1, C2, C1_R2, lhs.data(), rhs.data(), out.data(), m_cutoff, m_policy);
+        }
+
 
-      template <typename U, typename V, size_t R, size_t C >
-      auto perform_operation(const Matrix<U, R, C>& lhs, const V& rhs)  const
+      template <typename T, typename U, typename A, typename B>
+      auto perform_operation_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs)  const
         {
+        using result_type = decltype(std::declval<T>() + std::declval<U>());
 
-        const std::vector<U>& lhs_data = lhs.get_data();
+        DynamicMatrix<result_type, rebind_allocator_t<A, result_type>> result(lhs.get_n_rows(), rhs.get_n_cols());
+        perform_operation_into_impl(lhs, rhs, result);
 
-        auto type_val = lhs_data[0] * rhs;
+        return result;
+        }
+
+
+      template <typename T, typename U, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs, DynamicMatrix<W, D>& out) const
+        {
+        static_assert(std::is_same_v<W, decltype(std::declval<T>() + std::declval<U>())>, "Element type of the output doesn`t match type of the result");
+
+        if (lhs.get_n_cols() != rhs.get_n_rows())
+          {
+          throw std::length_error("Number of columns of the first matrix doesn`t match number of rows of the second");
+          }
 
-        std::vector<decltype(type_val)> result_data(R * C);
-        for (size_t i = 0; i < result_data.size(); ++i)
+        const size_t m = lhs.get_n_rows();
+        const size_t n = rhs.get_n_cols();
+        const size_t k = lhs.get_n_cols();
+
+        if (out.get_n_rows() != m || out.get_n_cols() != n)
           {
-          result_data[i] = lhs_data[i] * rhs;
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
           }
 
-        Matrix<decltype(type_val), R, C> result(std::move(result_data));
+        Detail::check_not_aliased(out.data(), m * n * sizeof(W), lhs.data(), m * k * sizeof(T));
+        Detail::check_not_aliased(out.data(), m * n * sizeof(W), rhs.data(), k * n * sizeof(U));
+
+        Strassen::multiply(m, n, k, lhs.data(), rhs.data(), out.data(), m_cutoff, m_policy);
+        }
+
+
+      template <typename L, typename Rhs, std::enable_if_t<Detail::accepts_views<L, Rhs>>* = nullptr>
+      auto perform_operation_impl(const L& lhs, const Rhs& rhs) const
+        {
+        using result_type = decltype(std::declval<Detail::element_t<const L>>() + std::declval<Detail::element_t<const Rhs>>());
+
+        Matrix<result_type, L::get_n_rows(), Rhs::get_n_cols()> result;
+        perform_operation_into_impl(lhs, rhs, result);
 
         return result;
         }
+
+
+      template <typename L, typename Rhs, typename O, std::enable_if_t<Detail::accepts_views<L, Rhs, O>>* = nullptr>
+      void perform_operation_into_impl(const L& lhs, const Rhs& rhs, O&& out) const
+        {
+        using Out = std::remove_reference_t<O>;
+        static_assert(Detail::is_writable<Out>, "Output view is read-only");
+        static_assert(std::is_same_v<Detail::element_t<Out>, decltype(std::declval<Detail::element_t<const L>>() + std::declval<Detail::element_t<const Rhs>>())>, "Element type of the output doesn`t match type of the result");
+        static_assert(L::get_n_cols() == Rhs::get_n_rows(), "Number of columns of the first matrix doesn`t match number of rows of the second");
+        static_assert(L::get_n_rows() == Out::get_n_rows() && Rhs::get_n_cols() == Out::get_n_cols(), "Shape of the output matrix doesn`t match shape of the result");
+
+        constexpr size_t m = L::get_n_rows();
+        constexpr size_t n = Rhs::get_n_cols();
+        constexpr size_t k = L::get_n_cols();
+
+        const auto a = Detail::strided(lhs);
+        const auto b = Detail::strided(rhs);
+        const auto c = Detail::strided(out);
+
+        Detail::check_not_aliased(c.data, Detail::extent_bytes(c, m, n), a.data, Detail::extent_bytes(a, m, k));
+        Detail::check_not_aliased(c.data, Detail::extent_bytes(c, m, n), b.data, Detail::extent_bytes(b, k, n));
+
+        Strassen::multiply(m, n, k, a.data, a.row_stride, a.col_stride, b.data, b.row_stride, b.col_stride, c.data, c.row_stride, m_cutoff, m_policy);
+        }
     };
 
 
+
   /// <summary>
-  /// Adds every element of the first matrix to every element of the second.
+  /// Multiplies matrices stored in files that don`t have to fit into memory, see OutOfCore.h.
+  /// Only memory_budget bytes are used for data whatever the size of the files.
   /// </summary>
-  class AddMatrix : public IMatrixProcessor<AddMatrix>
+  class OutOfCoreMultiplyMatrix : public IMatrixProcessor<OutOfCoreMultiplyMatrix>
     {
+      size_t m_memory_budget = OutOfCore::default_memory_budget;
+
       public:
 
-      AddMatrix() = default;
-      ~AddMatrix() = default;
+      OutOfCoreMultiplyMatrix() = default;
+      explicit OutOfCoreMultiplyMatrix(size_t memory_budget) : m_memory_budget(memory_budget) {}
+      explicit OutOfCoreMultiplyMatrix(const ExecutionPolicy& policy, size_t memory_budget = OutOfCore::default_memory_budget)
+        : IMatrixProcessor<OutOfCoreMultiplyMatrix>(policy), m_memory_budget(memory_budget) {}
+      ~OutOfCoreMultiplyMatrix() = default;
+
+      size_t get_memory_budget() const
+        {
+        return m_memory_budget;
+        }
 
-      template <typename U, typename V, size_t R, size_t C >
-      auto perform_operation(const Matrix<U, R, C>& lhs, const Matrix<V, R, C>& rhs)  const
+      // Output file is created beforehand by MatrixIO::MatrixFile::create and must not be an operand file
+      template <typename T>
+      void perform_operation_into_impl(const MatrixIO::MatrixFile<T>& lhs, const MatrixIO::MatrixFile<T>& rhs, const MatrixIO::MatrixFile<T>& out) const
         {
+        if (lhs.get_n_cols() != rhs.get_n_rows())
+          {
+          throw std::length_error("Number of columns of the first matrix doesn`t match number of rows of the second");
+          }
+        if (out.get_n_rows() != lhs.get_n_rows() || out.get_n_cols() != rhs.get_n_cols())
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
+          }
+        if (std::filesystem::equivalent(out.get_path(), lhs.get_path()) || std::filesystem::equivalent(out.get_path(), rhs.get_path()))
+          {
+          throw std::invalid_argument("Output matrix overlaps an operand of the operation");
+          }
+
+        OutOfCore::multiply(lhs, rhs, out, m_memory_budget, m_policy);
+        }
+    };
+
+
+
+  /// <summary>
+  /// Converts elements of the matrix to T, e.g. float matrix to Float16 or BFloat16 storage at half the size.
+  /// </summary>
+  template <typename T>
+  class ConvertMatrix : public IMatrixProcessor<ConvertMatrix<T>>
+    {
+      public:
 
-        const std::vector<U>& lhs_data = lhs.get_data();
-        const std::vector<V>& rhs_data = rhs.get_data();
+      ConvertMatrix() = default;
+      explicit ConvertMatrix(const ExecutionPolicy& policy) : IMatrixProcessor<ConvertMatrix<T>>(policy) {}
+      ~ConvertMatrix() = default;
 
-        assert (lhs_data.size() == rhs_data.size());
+      template <typename U, size_t R, size_t C, typename A>
+      auto perform_operation_impl(const Matrix<U, R, C, A>& mat) const
+        {
+        Matrix<T, R, C, rebind_allocator_t<A, T>> result;
+        perform_operation_into_impl(mat, result);
+
+        return result;
+        }
+
+
+      template <typename U, size_t R, size_t C, typename A, typename D>
+      void perform_operation_into_impl(const Matrix<U, R, C, A>& mat, Matrix<T, R, C, D>& out) const
+        {
+        Detail::check_not_aliased(out.data(), R * C * sizeof(T), mat.data(), R * C * sizeof(U));
+
+        Detail::convert(this->m_policy, mat.data(), out.data(), R * C);
+        }
+
+
+      template <typename U, typename A>
+      auto perform_operation_impl(const DynamicMatrix<U, A>& mat) const
+        {
+        DynamicMatrix<T, rebind_allocator_t<A, T>> result(mat.get_n_rows(), mat.get_n_cols());
+        perform_operation_into_impl(mat, result);
 
-        auto type_val = lhs_data[0] + rhs_data[0];
+        return result;
+        }
 
-        std::vector<decltype(type_val)> result_data(R * C);
-        for (size_t i = 0; i < result_data.size(); ++i)
+
+      template <typename U, typename A, typename D>
+      void perform_operation_into_impl(const DynamicMatrix<U, A>& mat, DynamicMatrix<T, D>& out) const
+        {
+        if (out.get_n_rows() != mat.get_n_rows() || out.get_n_cols() != mat.get_n_cols())
           {
-          result_data[i] = lhs_data[i] + rhs_data[i];
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
           }
+        const size_t n = mat.get_n_rows() * mat.get_n_cols();
 
-        Matrix<decltype(type_val), R, C> result(std::move(result_data));
+        Detail::check_not_aliased(out.data(), n * sizeof(T), mat.data(), n * sizeof(U));
 
-        return result;
+        Detail::convert(this->m_policy, mat.data(), out.data(), n);
         }
     };
 
 
   /// <summary>
-  /// Multiplies two matrices
+  /// Multiplies two matrices computing every product and sum in Acc and storing the result as Out,
+  /// e.g. int8 matrices accumulated in int32, or Float16 ones accumulated in float and stored as Float16.
+  /// MultiplyMatrix accumulates in the type of the result, so products of int matrices overflow int;
+  /// WideMultiplyMatrix<int64_t> is the way to multiply them exactly.
   /// </summary>
-  class MultiplyMatrix : public IMatrixProcessor<MultiplyMatrix>
+  template <typename Acc, typename Out = Acc>
+  class WideMultiplyMatrix : public IMatrixProcessor<WideMultiplyMatrix<Acc, Out>>
     {
       public:
 
-      MultiplyMatrix() = default;
-      ~MultiplyMatrix() = default;
-  
-      // General realization
-      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2>
-      auto perform_operation(const Matrix<T, R1, C1_R2>& lhs, const Matrix<U, C1_R2, C2>& rhs)  const
+      WideMultiplyMatrix() = default;
+      explicit WideMultiplyMatrix(const ExecutionPolicy& policy) : IMatrixProcessor<WideMultiplyMatrix<Acc, Out>>(policy) {}
+      ~WideMultiplyMatrix() = default;
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B>
+      auto perform_operation_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs) const
+        {
+        Matrix<Out, R1, C2, rebind_allocator_t<A, Out>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
+
+      // Output must not overlap lhs or rhs
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B, typename D>
+      void perform_operation_into_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs, Matrix<Out, R1, C2, D>& out) const
+        {
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(Out), lhs.data(), R1 * C1_R2 * sizeof(T));
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(Out), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        Detail::multiply_wide<Acc>(this->m_policy, R1, C2, C1_R2, lhs.data(), rhs.data(), out.data());
+        }
+
+
+      template <typename T, typename U, typename A, typename B>
+      auto perform_operation_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs) const
         {
-        const std::vector<T>& lhs_data = lhs.get_data();
-        const std::vector<U>& rhs_data = rhs.get_data();
-  
-        auto type_val = lhs_data[0] + rhs_data[0];
-  
-        std::vector<decltype(type_val)> result_data(R1 * C2);
+        DynamicMatrix<Out, rebind_allocator_t<A, Out>> result(lhs.get_n_rows(), rhs.get_n_cols());
+        perform_operation_into_impl(lhs, rhs, result);
+
+        return result;
+        }
+
 
-        size_t R1_counter = 0;
-        size_t C2_counter = 0;
-        for (size_t i = 0; i < result_data.size(); i++)
+      template <typename T, typename U, typename A, typename B, typename D>
+      void perform_operation_into_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs, DynamicMatrix<Out, D>& out) const
+        {
+        if (lhs.get_n_cols() != rhs.get_n_rows())
           {
-          if (C2_counter >= C2) 
-            { 
-            C2_counter = 0;
-            R1_counter += C1_R2;
-            }
+          throw std::length_error("Number of columns of the first matrix doesn`t match number of rows of the second");
+          }
 
-          for (size_t j = 0; j < C1_R2; j++)
-            {
-            result_data[i] += lhs_data[j + R1_counter] * rhs_data[j*C2 + C2_counter];
-            }
-          
-          ++C2_counter;
+        const size_t m = lhs.get_n_rows();
+        const size_t n = rhs.get_n_cols();
+        const size_t k = lhs.get_n_cols();
+
+        if (out.get_n_rows() != m || out.get_n_cols() != n)
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
           }
 
-        Matrix<decltype(type_val), R1, C2> result(std::move(result_data));
-  
+        Detail::check_not_aliased(out.data(), m * n * sizeof(Out), lhs.data(), m * k * sizeof(T));
+        Detail::check_not_aliased(out.data(), m * n * sizeof(Out), rhs.data(), k * n * sizeof(U));
+
+        Detail::multiply_wide<Acc>(this->m_policy, m, n, k, lhs.data(), rhs.data(), out.data());
+        }
+    };
+
+
+  /// <summary>
+  /// Multiplies matrices quantized with the given parameters, see Quantization.h, accumulating in Acc.
+  /// The result is float matrix of real values. perform_operation_into also takes output of another
+  /// floating-point type, or of type Acc to get the accumulators, i.e. the product of A - za and B - zb.
+  /// int8 products fit int32 for inner dimensions up to 2^17.
+  /// </summary>
+  template <typename Acc = int32_t>
+  class QuantizedMultiplyMatrix : public IMatrixProcessor<QuantizedMultiplyMatrix<Acc>>
+    {
+      Quantization::Params m_lhs_params;
+      Quantization::Params m_rhs_params;
+
+      public:
+
+      QuantizedMultiplyMatrix() = default;
+      QuantizedMultiplyMatrix(const Quantization::Params& lhs_params, const Quantization::Params& rhs_params)
+        : m_lhs_params(lhs_params), m_rhs_params(rhs_params) {}
+      QuantizedMultiplyMatrix(const ExecutionPolicy& policy, const Quantization::Params& lhs_params, const Quantization::Params& rhs_params)
+        : IMatrixProcessor<QuantizedMultiplyMatrix<Acc>>(policy), m_lhs_params(lhs_params), m_rhs_params(rhs_params) {}
+      ~QuantizedMultiplyMatrix() = default;
+
+      const Quantization::Params& get_lhs_params() const
+        {
+        return m_lhs_params;
+        }
+
+      const Quantization::Params& get_rhs_params() const
+        {
+        return m_rhs_params;
+        }
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B>
+      auto perform_operation_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs) const
+        {
+        Matrix<float, R1, C2, rebind_allocator_t<A, float>> result;
+        perform_operation_into_impl(lhs, rhs, result);
+
         return result;
         }
 
-     
-      // Specialized realization for vector-row x vector-col case
-      template <typename T, typename U, size_t C1_R2>
-      auto perform_operation(const Matrix<T, 1, C1_R2>& lhs, const Matrix<U, C1_R2, 1>& rhs)  const
+
+      template <typename T, typename U, size_t R1, size_t C1_R2, size_t C2, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const Matrix<T, R1, C1_R2, A>& lhs, const Matrix<U, C1_R2, C2, B>& rhs, Matrix<W, R1, C2, D>& out) const
+        {
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), lhs.data(), R1 * C1_R2 * sizeof(T));
+        Detail::check_not_aliased(out.data(), R1 * C2 * sizeof(W), rhs.data(), C1_R2 * C2 * sizeof(U));
+
+        Detail::multiply_quantized<Acc>(this->m_policy, R1, C2, C1_R2, lhs.data(), rhs.data(), out.data(), m_lhs_params, m_rhs_params);
+        }
+
+
+      template <typename T, typename U, typename A, typename B>
+      auto perform_operation_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs) const
         {
-        const std::vector<T>& lhs_data = lhs.get_data();
-        const std::vector<U>& rhs_data = rhs.get_data();
+        DynamicMatrix<float, rebind_allocator_t<A, float>> result(lhs.get_n_rows(), rhs.get_n_cols());
+        perform_operation_into_impl(lhs, rhs, result);
 
-        auto type_val = lhs_data[0] + rhs_data[0];
+        return result;
+        }
 
-        decltype(type_val) inner_product = 0;
 
-        for (size_t i = 0; i < lhs_data.size(); ++i)
+      template <typename T, typename U, typename A, typename B, typename W, typename D>
+      void perform_operation_into_impl(const DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs, DynamicMatrix<W, D>& out) const
+        {
+        if (lhs.get_n_cols() != rhs.get_n_rows())
           {
-          inner_product += lhs_data[i] * rhs_data[i];
+          throw std::length_error("Number of columns of the first matrix doesn`t match number of rows of the second");
           }
 
-        Matrix<decltype(type_val), 1, 1> result({ inner_product });
+        const size_t m = lhs.get_n_rows();
+        const size_t n = rhs.get_n_cols();
+        const size_t k = lhs.get_n_cols();
 
-        return result;
-        }
+        if (out.get_n_rows() != m || out.get_n_cols() != n)
+          {
+          throw std::length_error("Shape of the output matrix doesn`t match shape of the result");
+          }
 
+        Detail::check_not_aliased(out.data(), m * n * sizeof(W), lhs.data(), m * k * sizeof(T));
+        Detail::check_not_aliased(out.data(), m * n * sizeof(W), rhs.data(), k * n * sizeof(U));
+
+        Detail::multiply_quantized<Acc>(this->m_policy, m, n, k, lhs.data(), rhs.data(), out.data(), m_lhs_params, m_rhs_params);
+        }
     };
 
 
   }
+
+
+/// <summary>
+/// In-place forms of the elementwise processors. Element type of the matrix must be
+/// the type of the result, e.g. Matrix<float> *= 2.0f, so nothing is silently narrowed.
+/// </summary>
+template <typename T, size_t R, size_t C, typename A, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+Matrix<T, R, C, A>& operator+=(Matrix<T, R, C, A>& mat, const U& scal)
+  {
+  MatrixProcessors::AddScalar().perform_operation_into(mat, scal, mat);
+  return mat;
+  }
+
+template <typename T, size_t R, size_t C, typename A, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+Matrix<T, R, C, A>& operator-=(Matrix<T, R, C, A>& mat, const U& scal)
+  {
+  MatrixProcessors::SubtractScalar().perform_operation_into(mat, scal, mat);
+  return mat;
+  }
+
+template <typename T, size_t R, size_t C, typename A, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+Matrix<T, R, C, A>& operator*=(Matrix<T, R, C, A>& mat, const U& scal)
+  {
+  MatrixProcessors::MultiplyScalar().perform_operation_into(mat, scal, mat);
+  return mat;
+  }
+
+template <typename T, size_t R, size_t C, typename A, typename U, typename B>
+Matrix<T, R, C, A>& operator+=(Matrix<T, R, C, A>& lhs, const Matrix<U, R, C, B>& rhs)
+  {
+  MatrixProcessors::AddMatrix().perform_operation_into(lhs, rhs, lhs);
+  return lhs;
+  }
+
+
+template <typename T, typename A, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+DynamicMatrix<T, A>& operator+=(DynamicMatrix<T, A>& mat, const U& scal)
+  {
+  MatrixProcessors::AddScalar().perform_operation_into(mat, scal, mat);
+  return mat;
+  }
+
+template <typename T, typename A, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+DynamicMatrix<T, A>& operator-=(DynamicMatrix<T, A>& mat, const U& scal)
+  {
+  MatrixProcessors::SubtractScalar().perform_operation_into(mat, scal, mat);
+  return mat;
+  }
+
+template <typename T, typename A, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+DynamicMatrix<T, A>& operator*=(DynamicMatrix<T, A>& mat, const U& scal)
+  {
+  MatrixProcessors::MultiplyScalar().perform_operation_into(mat, scal, mat);
+  return mat;
+  }
+
+template <typename T, typename A, typename U, typename B>
+DynamicMatrix<T, A>& operator+=(DynamicMatrix<T, A>& lhs, const DynamicMatrix<U, B>& rhs)
+  {
+  MatrixProcessors::AddMatrix().perform_operation_into(lhs, rhs, lhs);
+  return lhs;
+  }
+
+
+// views are shallow, so compound assignment writes through temporaries such as row_view(mat, 2) *= 2.0
+template <typename T, size_t R, size_t C, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+const MatrixView<T, R, C>& operator+=(const MatrixView<T, R, C>& view, const U& scal)
+  {
+  MatrixProcessors::AddScalar().perform_operation_into(view, scal, view);
+  return view;
+  }
+
+template <typename T, size_t R, size_t C, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+const MatrixView<T, R, C>& operator-=(const MatrixView<T, R, C>& view, const U& scal)
+  {
+  MatrixProcessors::SubtractScalar().perform_operation_into(view, scal, view);
+  return view;
+  }
+
+template <typename T, size_t R, size_t C, typename U, std::enable_if_t<std::is_arithmetic_v<U>>* = nullptr>
+const MatrixView<T, R, C>& operator*=(const MatrixView<T, R, C>& view, const U& scal)
+  {
+  MatrixProcessors::MultiplyScalar().perform_operation_into(view, scal, view);
+  return view;
+  }
+
+template <typename T, size_t R, size_t C, typename M, std::enable_if_t<MatrixProcessors::Detail::is_strided_operand<const M>::value>* = nullptr>
+const MatrixView<T, R, C>& operator+=(const MatrixView<T, R, C>& view, const M& mat)
+  {
+  MatrixProcessors::AddMatrix().perform_operation_into(view, mat, view);
+  return view;
+  }
+
@@ -0,0 +1,160 @@
+/*
+
+This file contains storage used by Matrix for its elements
+
+*/
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <initializer_list>
+
+
+/// <summary>
+/// Fixed-capacity storage keeping all N elements inside the object.
+/// Mirrors the part of std::vector interface used by Matrix, so both can be used interchangeably.
+/// Everything Matrix needs to be built and read is constexpr, so small matrices can be constants.
+/// </summary>
+template <typename T, size_t N>
+class InlineStorage
+  {
+  std::array<T, N> m_elems {};
+
+  public:
+
+  using value_type = T;
+  using iterator = typename std::array<T, N>::iterator;
+  using const_iterator = typename std::array<T, N>::const_iterator;
+
+  InlineStorage() = default;
+
+  constexpr explicit InlineStorage(size_t size)
+    {
+    check_size(size);
+    }
+
+  constexpr InlineStorage(size_t size, const T& value)
+    {
+    check_size(size);
+    for (size_t i = 0; i < N; ++i)
+      {
+      m_elems[i] = value;
+      }
+    }
+
+  template <typename A>
+  InlineStorage& operator=(const std::vector<T, A>& vec)
+    {
+    check_size(vec.size());
+    std::copy(vec.begin(), vec.end(), m_elems.begin());
+    return *this;
+    }
+
+  constexpr InlineStorage& operator=(std::initializer_list<T> init_list)
+    {
+    check_size(init_list.size());
+    size_t i = 0;
+    for (const T& elem : init_list)
+      {
+      m_elems[i++] = elem;
+      }
+    return *this;
+    }
+
+  template <typename It>
+  void assign(It first, It last)
+    {
+    check_size(static_cast<size_t>(std::distance(first, last)));
+    std::copy(first, last, m_elems.begin());
+    }
+
+  static constexpr size_t size() { return N; }
+
+  constexpr T* data() { return m_elems.data(); }
+  constexpr const T* data() const { return m_elems.data(); }
+
+  constexpr iterator begin() { return m_elems.begin(); }
+  constexpr iterator end() { return m_elems.end(); }
+  constexpr const_iterator begin() const { return m_elems.begin(); }
+  constexpr const_iterator end() const { return m_elems.end(); }
+
+  constexpr T& back() { return m_elems.back(); }
+  constexpr const T& back() const { return m_elems.back(); }
+
+  constexpr T& operator[](size_t i) { return m_elems[i]; }
+  constexpr const T& operator[](size_t i) const { return m_elems[i]; }
+
+  constexpr T& at(size_t i) { return m_elems.at(i); }
+  constexpr const T& at(size_t i) const { return m_elems.at(i); }
+
+  // operator== of std::array is constexpr only since C++20
+  friend constexpr bool operator==(const InlineStorage& lhs, const InlineStorage& rhs)
+    {
+    for (size_t i = 0; i < N; ++i)
+      {
+      if (!(lhs.m_elems[i] == rhs.m_elems[i]))
+        {
+        return false;
+        }
+      }
+    return true;
+    }
+
+  friend constexpr bool operator!=(const InlineStorage& lhs, const InlineStorage& rhs)
+    {
+    return !(lhs == rhs);
+    }
+
+  template <typename A>
+  friend bool operator==(const InlineStorage& lhs, const std::vector<T, A>& rhs)
+    {
+    return rhs.size() == N && std::equal(rhs.begin(), rhs.end(), lhs.m_elems.begin());
+    }
+
+  template <typename A>
+  friend bool operator==(const std::vector<T, A>& lhs, const InlineStorage& rhs)
+    {
+    return rhs == lhs;
+    }
+
+  template <typename A>
+  friend bool operator!=(const InlineStorage& lhs, const std::vector<T, A>& rhs)
+    {
+    return !(lhs == rhs);
+    }
+
+  template <typename A>
+  friend bool operator!=(const std::vector<T, A>& lhs, const InlineStorage& rhs)
+    {
+    return !(rhs == lhs);
+    }
+
+  private:
+
+  static constexpr void check_size(size_t size)
+    {
+    if (size != N)
+      {
+      throw std::length_error("Length of the provided data doesn`t match storage size");
+      }
+    }
+  };
+
+
+/// <summary>
+/// Matrices not bigger than this are stored inline and never touch the allocator.
+/// </summary>
+constexpr size_t inline_storage_max_bytes = 256;
+
+
+/// <summary>
+/// Storage picked for N elements of T: InlineStorage for small matrices, std::vector with allocator A otherwise.
+/// </summary>
+template <typename T, size_t N, typename A = std::allocator<T>>
+using MatrixStorage = std::conditional_t<N * sizeof(T) <= inline_storage_max_bytes, InlineStorage<T, N>, std::vector<T, A>>;
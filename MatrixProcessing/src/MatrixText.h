@@ -0,0 +1,674 @@
+/*
+
+This file contains text Matrix files: CSV, whitespace separated and Matrix Market
+
+*/
+
+#pragma once
+
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "Matrix.h"
+#include "DynamicMatrix.h"
+#include "MatrixView.h"
+#include "SparseMatrix.h"
+#include "ThreadPool.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+namespace MatrixIO {
+
+  /// <summary>
+  /// Csv and Whitespace keep one row per line with values separated by commas or by spaces and tabs.
+  /// MatrixMarket is the NIST exchange format: dense matrices are written as "array" in column-major
+  /// order, sparse ones as "coordinate" entries; both kinds are read, general, symmetric and skew-symmetric.
+  /// </summary>
+  enum class TextFormat { Csv, Whitespace, MatrixMarket };
+
+  /// <summary>
+  /// Output is formatted and written in blocks of about this many bytes.
+  /// </summary>
+  constexpr size_t text_block_size = 1 << 16;
+
+  /// <summary>
+  /// Text is parsed by several threads only when every one of them gets at least this many bytes.
+  /// </summary>
+  constexpr size_t text_parallel_grain = 1 << 20;
+
+
+  namespace Detail {
+
+    /// <summary>
+    /// Destination of formatted text: stream or file descriptor, written without further buffering.
+    /// </summary>
+    class TextSink
+      {
+      std::ostream* m_stream = nullptr;
+      int m_fd = -1;
+
+      public:
+
+      explicit TextSink(std::ostream& stream) : m_stream(&stream) {}
+      explicit TextSink(int fd) : m_fd(fd) {}
+
+      void write(const char* data, size_t size)
+        {
+        if (m_stream != nullptr)
+          {
+          m_stream->write(data, static_cast<std::streamsize>(size));
+          if (!*m_stream)
+            {
+            throw std::runtime_error("Can`t write text matrix to the stream");
+            }
+          return;
+          }
+        while (size > 0)
+          {
+#if defined(_WIN32)
+          const int written = ::_write(m_fd, data, static_cast<unsigned int>(std::min<size_t>(size, 1 << 30)));
+#else
+          const ssize_t written = ::write(m_fd, data, size);
+#endif
+          if (written < 0)
+            {
+            if (errno == EINTR)
+              {
+              continue;
+              }
+            throw std::runtime_error("Can`t write text matrix to file descriptor " + std::to_string(m_fd));
+            }
+          data += written;
+          size -= static_cast<size_t>(written);
+          }
+        }
+      };
+
+
+    // shortest representation that reads back to the same value
+    template <typename T>
+    void append_number(std::string& out, const T& value)
+      {
+      char buffer[64];
+      const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+      out.append(buffer, result.ptr);
+      }
+
+
+    /// <summary>
+    /// Calls format(block, begin, end) for consecutive ranges of lines_per_block of n_lines lines and writes
+    /// the blocks to the sink in order. Blocks of one round are formatted by the threads allowed by the policy.
+    /// </summary>
+    template <typename F>
+    void write_blocks(TextSink& sink, size_t n_lines, size_t lines_per_block, const ExecutionPolicy& policy, F&& format)
+      {
+      lines_per_block = std::max<size_t>(1, lines_per_block);
+      const size_t n_threads = std::max<size_t>(1, ThreadPool::resolve_n_threads(policy));
+      std::vector<std::string> blocks(n_threads);
+      for (size_t first = 0; first < n_lines; first += n_threads * lines_per_block)
+        {
+        const size_t n_blocks = std::min(n_threads, (n_lines - first + lines_per_block - 1) / lines_per_block);
+        parallel_for(policy, n_blocks, 1, [&](size_t begin, size_t end)
+          {
+          for (size_t block = begin; block < end; ++block)
+            {
+            const size_t line = first + block * lines_per_block;
+            blocks[block].clear();
+            format(blocks[block], line, std::min(n_lines, line + lines_per_block));
+            }
+          });
+        for (size_t block = 0; block < n_blocks; ++block)
+          {
+          sink.write(blocks[block].data(), blocks[block].size());
+          }
+        }
+      }
+
+
+    template <typename T>
+    const char* matrix_market_field()
+      {
+      return std::is_integral_v<T> ? "integer" : "real";
+      }
+
+
+    template <typename T>
+    void write_dense(TextSink& sink, size_t rows, size_t cols, const T* data, size_t row_stride, TextFormat format, const ExecutionPolicy& policy)
+      {
+      if (format == TextFormat::MatrixMarket)
+        {
+        std::string header = std::string("%%MatrixMarket matrix array ") + matrix_market_field<T>() + " general\n";
+        header += std::to_string(rows) + " " + std::to_string(cols) + "\n";
+        sink.write(header.data(), header.size());
+        // one value per line, column by column
+        write_blocks(sink, rows * cols, text_block_size / 16, policy, [=](std::string& out, size_t begin, size_t end)
+          {
+          for (size_t k = begin; k < end; ++k)
+            {
+            append_number(out, data[(k % rows) * row_stride + k / rows]);
+            out += '\n';
+            }
+          });
+        return;
+        }
+
+      const char separator = format == TextFormat::Csv ? ',' : ' ';
+      write_blocks(sink, rows, text_block_size / (16 * std::max<size_t>(cols, 1)), policy, [=](std::string& out, size_t begin, size_t end)
+        {
+        for (size_t row = begin; row < end; ++row)
+          {
+          const T* values = data + row * row_stride;
+          for (size_t col = 0; col < cols; ++col)
+            {
+            if (col != 0)
+              {
+              out += separator;
+              }
+            append_number(out, values[col]);
+            }
+          out += '\n';
+          }
+        });
+      }
+
+
+    template <typename T, size_t R, size_t C, SparseLayout L>
+    void write_sparse(TextSink& sink, const SparseMatrix<T, R, C, L>& mat, const ExecutionPolicy& policy)
+      {
+      std::string header = std::string("%%MatrixMarket matrix coordinate ") + matrix_market_field<T>() + " general\n";
+      header += std::to_string(R) + " " + std::to_string(C) + " " + std::to_string(mat.get_n_nonzeros()) + "\n";
+      sink.write(header.data(), header.size());
+
+      const auto& offsets = mat.get_offsets();
+      const auto& indices = mat.get_indices();
+      const auto& values = mat.get_values();
+      write_blocks(sink, mat.get_n_nonzeros(), text_block_size / 32, policy, [&](std::string& out, size_t begin, size_t end)
+        {
+        size_t outer = static_cast<size_t>(std::upper_bound(offsets.begin(), offsets.end(), begin) - offsets.begin()) - 1;
+        for (size_t i = begin; i < end; ++i)
+          {
+          while (offsets[outer + 1] <= i)
+            {
+            ++outer;
+            }
+          const size_t row = (L == SparseLayout::CSR ? outer : indices[i]) + 1;
+          const size_t col = (L == SparseLayout::CSR ? indices[i] : outer) + 1;
+          append_number(out, row);
+          out += ' ';
+          append_number(out, col);
+          out += ' ';
+          append_number(out, values[i]);
+          out += '\n';
+          }
+        });
+      }
+
+
+    template <typename T, size_t R, size_t C, typename A>
+    void write_matrix(TextSink& sink, const Matrix<T, R, C, A>& mat, TextFormat format, const ExecutionPolicy& policy)
+      {
+      write_dense(sink, R, C, mat.data(), C, format, policy);
+      }
+
+    template <typename T, typename A>
+    void write_matrix(TextSink& sink, const DynamicMatrix<T, A>& mat, TextFormat format, const ExecutionPolicy& policy)
+      {
+      write_dense(sink, mat.get_n_rows(), mat.get_n_cols(), mat.data(), mat.get_n_cols(), format, policy);
+      }
+
+    template <typename T, size_t R, size_t C>
+    void write_matrix(TextSink& sink, const MatrixView<T, R, C>& view, TextFormat format, const ExecutionPolicy& policy)
+      {
+      write_dense(sink, R, C, view.data(), view.get_row_stride(), format, policy);
+      }
+
+    template <typename T, size_t R, size_t C, SparseLayout L>
+    void write_matrix(TextSink& sink, const SparseMatrix<T, R, C, L>& mat, TextFormat format, const ExecutionPolicy& policy)
+      {
+      if (format == TextFormat::MatrixMarket)
+        {
+        write_sparse(sink, mat, policy);
+        return;
+        }
+      const Matrix<T, R, C> dense = mat.to_dense();
+      write_dense(sink, R, C, dense.data(), C, format, policy);
+      }
+
+
+    inline const char* skip_blanks(const char* first, const char* last)
+      {
+      while (first != last && (*first == ' ' || *first == '\t' || *first == '\r'))
+        {
+        ++first;
+        }
+      return first;
+      }
+
+    inline const char* line_end(const char* first, const char* last)
+      {
+      const void* found = std::memchr(first, '\n', static_cast<size_t>(last - first));
+      return found != nullptr ? static_cast<const char*>(found) : last;
+      }
+
+    [[noreturn]] inline void throw_parse_error(const char* first, const char* last)
+      {
+      const char* end = std::find(first, std::min(last, first + 32), '\n');
+      throw std::runtime_error("Can`t parse number in text matrix at \"" + std::string(first, end) + "\"");
+      }
+
+    template <typename T>
+    const char* parse_number(const char* first, const char* last, T& value)
+      {
+      // from_chars doesn`t accept leading plus
+      const char* begin = first != last && *first == '+' ? first + 1 : first;
+      const auto result = std::from_chars(begin, last, value);
+      if (result.ec != std::errc())
+        {
+        throw_parse_error(first, last);
+        }
+      return result.ptr;
+      }
+
+
+    /// <summary>
+    /// [first, last) cut into at most n_chunks pieces of whole lines.
+    /// </summary>
+    inline std::vector<const char*> split_lines(const char* first, const char* last, size_t n_chunks)
+      {
+      std::vector<const char*> bounds { first };
+      const size_t size = static_cast<size_t>(last - first);
+      for (size_t chunk = 1; chunk < n_chunks; ++chunk)
+        {
+        const char* bound = std::max(bounds.back(), first + size / n_chunks * chunk);
+        bound = bound == last ? last : std::min(last, line_end(bound, last) + 1);
+        bounds.push_back(bound);
+        }
+      bounds.push_back(last);
+      return bounds;
+      }
+
+    inline size_t text_chunks(size_t size, const ExecutionPolicy& policy)
+      {
+      return std::max<size_t>(1, std::min(ThreadPool::resolve_n_threads(policy), size / text_parallel_grain));
+      }
+
+
+    // values use the storage of DynamicMatrix<T>, so parse_text hands the buffer over without copying
+    template <typename T>
+    struct ParsedRows
+      {
+      typename DynamicMatrix<T>::storage_type values;
+      size_t n_rows = 0;
+      size_t n_cols = 0;
+      };
+
+    // Rows of one chunk, blank lines are skipped. separator is ' ' for any run of spaces and tabs.
+    template <typename T>
+    void parse_rows(const char* first, const char* last, char separator, ParsedRows<T>& out)
+      {
+      out.values.reserve(static_cast<size_t>(last - first) / 4);
+      while (first < last)
+        {
+        const char* end = line_end(first, last);
+        const char* p = skip_blanks(first, end);
+        if (p != end)
+          {
+          size_t n_values = 0;
+          for (;;)
+            {
+            T value;
+            p = skip_blanks(parse_number(p, end, value), end);
+            out.values.push_back(value);
+            ++n_values;
+            if (p == end)
+              {
+              break;
+              }
+            if (separator != ' ')
+              {
+              if (*p != separator)
+                {
+                throw_parse_error(p, end);
+                }
+              p = skip_blanks(p + 1, end);
+              }
+            }
+          if (out.n_rows != 0 && n_values != out.n_cols)
+            {
+            throw std::runtime_error("Rows of the text matrix have different lengths");
+            }
+          out.n_cols = n_values;
+          ++out.n_rows;
+          }
+        first = end + 1;
+        }
+      }
+
+    /// <summary>
+    /// Parses rows of text by chunks on the threads allowed by the policy.
+    /// Returns values of all rows in order, n_rows and n_cols.
+    /// </summary>
+    template <typename T>
+    ParsedRows<T> parse_all_rows(const char* first, const char* last, char separator, const ExecutionPolicy& policy)
+      {
+      const std::vector<const char*> bounds = split_lines(first, last, text_chunks(static_cast<size_t>(last - first), policy));
+      std::vector<ParsedRows<T>> chunks(bounds.size() - 1);
+      parallel_for(policy, chunks.size(), 1, [&](size_t begin, size_t end)
+        {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+          {
+          parse_rows(bounds[chunk], bounds[chunk + 1], separator, chunks[chunk]);
+          }
+        });
+
+      if (chunks.size() == 1)
+        {
+        return std::move(chunks.front());
+        }
+      ParsedRows<T> result;
+      for (const ParsedRows<T>& chunk : chunks)
+        {
+        if (chunk.n_rows != 0 && result.n_rows != 0 && chunk.n_cols != result.n_cols)
+          {
+          throw std::runtime_error("Rows of the text matrix have different lengths");
+          }
+        result.n_cols = chunk.n_rows != 0 ? chunk.n_cols : result.n_cols;
+        result.n_rows += chunk.n_rows;
+        }
+      result.values.resize(result.n_rows * result.n_cols);
+      std::vector<size_t> offsets(chunks.size() + 1, 0);
+      for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+        {
+        offsets[chunk + 1] = offsets[chunk] + chunks[chunk].values.size();
+        }
+      parallel_for(policy, chunks.size(), 1, [&](size_t begin, size_t end)
+        {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+          {
+          std::copy(chunks[chunk].values.begin(), chunks[chunk].values.end(), result.values.begin() + static_cast<std::ptrdiff_t>(offsets[chunk]));
+          }
+        });
+      return result;
+      }
+
+
+    template <typename T>
+    struct ParsedEntries
+      {
+      std::vector<size_t> rows;
+      std::vector<size_t> cols;
+      std::vector<T> values;
+      };
+
+    // "row col value" lines of Matrix Market coordinate section, "row col" for pattern matrices
+    template <typename T>
+    void parse_entries(const char* first, const char* last, bool pattern, ParsedEntries<T>& out)
+      {
+      while (first < last)
+        {
+        const char* end = line_end(first, last);
+        const char* p = skip_blanks(first, end);
+        if (p != end && *p != '%')
+          {
+          size_t row = 0;
+          size_t col = 0;
+          T value = T(1);
+          p = skip_blanks(parse_number(p, end, row), end);
+          p = skip_blanks(parse_number(p, end, col), end);
+          if (!pattern)
+            {
+            p = skip_blanks(parse_number(p, end, value), end);
+            }
+          if (p != end)
+            {
+            throw_parse_error(p, end);
+            }
+          out.rows.push_back(row);
+          out.cols.push_back(col);
+          out.values.push_back(value);
+          }
+        first = end + 1;
+        }
+      }
+
+
+    struct MatrixMarketHeader
+      {
+      bool coordinate = false;
+      bool pattern = false;
+      bool symmetric = false;
+      bool skew = false;
+      size_t rows = 0;
+      size_t cols = 0;
+      size_t n_entries = 0;
+      const char* body = nullptr;
+      };
+
+    inline MatrixMarketHeader parse_matrix_market_header(const char* first, const char* last)
+      {
+      MatrixMarketHeader header;
+      const char* end = line_end(first, last);
+      std::string banner(first, end);
+      std::transform(banner.begin(), banner.end(), banner.begin(), [](char ch) { return static_cast<char>(std::tolower(static_cast<unsigned char>(ch))); });
+      if (banner.compare(0, 14, "%%matrixmarket") != 0 || banner.find(" matrix ") == std::string::npos)
+        {
+        throw std::runtime_error("Text is not a Matrix Market matrix");
+        }
+      header.coordinate = banner.find(" coordinate") != std::string::npos;
+      header.pattern = banner.find(" pattern") != std::string::npos;
+      header.skew = banner.find(" skew-symmetric") != std::string::npos;
+      header.symmetric = !header.skew && banner.find(" symmetric") != std::string::npos;
+      if ((!header.coordinate && banner.find(" array") == std::string::npos) || banner.find(" complex") != std::string::npos
+        || banner.find(" hermitian") != std::string::npos || (header.pattern && !header.coordinate))
+        {
+        throw std::runtime_error("Matrix Market matrix of this kind is not supported: " + banner);
+        }
+
+      // comment lines between the banner and the size line
+      first = end + 1;
+      for (;;)
+        {
+        if (first >= last)
+          {
+          throw std::runtime_error("Matrix Market matrix has no size line");
+          }
+        end = line_end(first, last);
+        const char* p = skip_blanks(first, end);
+        if (p != end && *p != '%')
+          {
+          p = skip_blanks(parse_number(p, end, header.rows), end);
+          p = skip_blanks(parse_number(p, end, header.cols), end);
+          if (header.coordinate)
+            {
+            p = skip_blanks(parse_number(p, end, header.n_entries), end);
+            }
+          if (p != end)
+            {
+            throw_parse_error(p, end);
+            }
+          break;
+          }
+        first = end + 1;
+        }
+      if ((header.symmetric || header.skew) && header.rows != header.cols)
+        {
+        throw std::runtime_error("Symmetric Matrix Market matrix must be square");
+        }
+      header.body = std::min(last, end + 1);
+      return header;
+      }
+
+
+    template <typename T>
+    DynamicMatrix<T> parse_matrix_market(const char* first, const char* last, const ExecutionPolicy& policy)
+      {
+      const MatrixMarketHeader header = parse_matrix_market_header(first, last);
+      DynamicMatrix<T> result(header.rows, header.cols);
+      T* data = result.data();
+      std::fill(data, data + header.rows * header.cols, T(0));
+      auto store = [&](size_t row, size_t col, const T& value)
+        {
+        data[row * header.cols + col] = value;
+        if (row != col && (header.symmetric || header.skew))
+          {
+          data[col * header.cols + row] = header.skew ? T(0) - value : value;
+          }
+        };
+
+      if (!header.coordinate)
+        {
+        // column-major values, only the lower triangle of symmetric matrices, without the diagonal for skew-symmetric ones
+        const ParsedRows<T> parsed = parse_all_rows<T>(header.body, last, ' ', policy);
+        const size_t n = header.rows;
+        const size_t expected = header.symmetric ? n * (n + 1) / 2 : header.skew ? n * (n - 1) / 2 : header.rows * header.cols;
+        if (parsed.values.size() != expected)
+          {
+          throw std::runtime_error("Number of values doesn`t match size of the Matrix Market matrix");
+          }
+        size_t k = 0;
+        for (size_t col = 0; col < header.cols; ++col)
+          {
+          const size_t first_row = header.symmetric ? col : header.skew ? col + 1 : 0;
+          for (size_t row = first_row; row < header.rows; ++row)
+            {
+            store(row, col, parsed.values[k++]);
+            }
+          }
+        return result;
+        }
+
+      const std::vector<const char*> bounds = split_lines(header.body, last, text_chunks(static_cast<size_t>(last - header.body), policy));
+      std::vector<ParsedEntries<T>> chunks(bounds.size() - 1);
+      parallel_for(policy, chunks.size(), 1, [&](size_t begin, size_t end)
+        {
+        for (size_t chunk = begin; chunk < end; ++chunk)
+          {
+          parse_entries(bounds[chunk], bounds[chunk + 1], header.pattern, chunks[chunk]);
+          }
+        });
+      size_t n_entries = 0;
+      for (const ParsedEntries<T>& chunk : chunks)
+        {
+        n_entries += chunk.values.size();
+        }
+      if (n_entries != header.n_entries)
+        {
+        throw std::runtime_error("Number of entries doesn`t match size line of the Matrix Market matrix");
+        }
+      for (const ParsedEntries<T>& chunk : chunks)
+        {
+        for (size_t i = 0; i < chunk.values.size(); ++i)
+          {
+          if (chunk.rows[i] == 0 || chunk.rows[i] > header.rows || chunk.cols[i] == 0 || chunk.cols[i] > header.cols)
+            {
+            throw std::runtime_error("Matrix Market entry is out of matrix bounds");
+            }
+          store(chunk.rows[i] - 1, chunk.cols[i] - 1, chunk.values[i]);
+          }
+        }
+      return result;
+      }
+
+  }
+
+
+  /// <summary>
+  /// Writes Matrix, DynamicMatrix, MatrixView or SparseMatrix as text to the stream. Output is formatted by
+  /// std::to_chars in blocks of about text_block_size bytes, by several threads when the policy allows, and
+  /// goes to the stream block by block. Floating-point values get the shortest form that reads back the same.
+  /// SparseMatrix is written as Matrix Market coordinate entries, with Csv and Whitespace formats as a dense one.
+  /// </summary>
+  template <typename M>
+  void write_text(std::ostream& o, const M& mat, TextFormat format = TextFormat::Csv, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    Detail::TextSink sink(o);
+    Detail::write_matrix(sink, mat, format, policy);
+    }
+
+  /// <summary>
+  /// Writes matrix as text straight to the file descriptor, e.g. 1 for standard output, bypassing iostreams.
+  /// </summary>
+  template <typename M>
+  void write_text(int fd, const M& mat, TextFormat format = TextFormat::Csv, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    Detail::TextSink sink(fd);
+    Detail::write_matrix(sink, mat, format, policy);
+    }
+
+  template <typename M>
+  void write_text(const std::string& path, const M& mat, TextFormat format = TextFormat::Csv, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+      {
+      throw std::runtime_error("Can`t open file " + path + " for writing");
+      }
+    Detail::TextSink sink(file);
+    Detail::write_matrix(sink, mat, format, policy);
+    file.close();
+    if (!file)
+      {
+      throw std::runtime_error("Can`t write file " + path);
+      }
+    }
+
+
+  /// <summary>
+  /// Parses text matrix into DynamicMatrix. The text is cut at line ends into chunks of at least
+  /// text_parallel_grain bytes, which threads allowed by the policy parse with std::from_chars.
+  /// Blank lines are skipped, lines may end with \r\n. Malformed text throws std::runtime_error.
+  /// </summary>
+  template <typename T>
+  DynamicMatrix<T> parse_text(std::string_view text, TextFormat format = TextFormat::Csv, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    if (format == TextFormat::MatrixMarket)
+      {
+      return Detail::parse_matrix_market<T>(first, last, policy);
+      }
+    Detail::ParsedRows<T> parsed = Detail::parse_all_rows<T>(first, last, format == TextFormat::Csv ? ',' : ' ', policy);
+    return DynamicMatrix<T>(parsed.n_rows, parsed.n_cols, std::move(parsed.values));
+    }
+
+  template <typename T>
+  DynamicMatrix<T> read_text(std::istream& in, TextFormat format = TextFormat::Csv, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    const std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return parse_text<T>(text, format, policy);
+    }
+
+  template <typename T>
+  DynamicMatrix<T> read_text(const std::string& path, TextFormat format = TextFormat::Csv, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+      {
+      throw std::runtime_error("Can`t open file " + path);
+      }
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(text.data(), static_cast<std::streamsize>(text.size())))
+      {
+      throw std::runtime_error("Can`t read file " + path);
+      }
+    return parse_text<T>(text, format, policy);
+    }
+
+  }
@@ -8,56 +8,80 @@ This class is a specialization of one-column Matrix
 
 #include "Matrix.h"
 
-template <typename T, size_t R>
-class MatrixVectCol : public Matrix <T, R, 1>
+template <typename T, size_t R, typename A = AlignedAllocator<T>>
+class MatrixVectCol : public Matrix <T, R, 1, A>
   {
   public:
 
-  MatrixVectCol() : Matrix <T, R, 1>() {}
-  MatrixVectCol(const std::vector<T>& vec) : Matrix <T, R, 1>(vec) {}
-  MatrixVectCol(std::vector<T>&& vec) : Matrix <T, R, 1>(vec) {}
-  MatrixVectCol(std::initializer_list<T>&& init_list) : Matrix <T, R, 1>(init_list) {}
+  constexpr MatrixVectCol() : Matrix <T, R, 1, A>() {}
+  template <typename VA = std::allocator<T>>
+  MatrixVectCol(const std::vector<T, VA>& vec) : Matrix <T, R, 1, A>(vec) {}
+  // takes over the buffer of std::vector<T, A>, see Matrix
+  template <typename VA = std::allocator<T>>
+  MatrixVectCol(std::vector<T, VA>&& vec) : Matrix <T, R, 1, A>(std::move(vec)) {}
+  constexpr MatrixVectCol(std::initializer_list<T>&& init_list) : Matrix <T, R, 1, A>(std::move(init_list)) {}
 
-  MatrixVectCol(const MatrixVectCol<T, R>&) = default;
-  MatrixVectCol(MatrixVectCol<T, R>&&) = default;
+  MatrixVectCol(const MatrixVectCol<T, R, A>&) = default;
+  MatrixVectCol(MatrixVectCol<T, R, A>&&) = default;
 
-  MatrixVectCol& operator=(const MatrixVectCol<T, R>&) = default;
-  MatrixVectCol& operator=(MatrixVectCol<T, R>&&) = default;
+  MatrixVectCol& operator=(const MatrixVectCol<T, R, A>&) = default;
+  MatrixVectCol& operator=(MatrixVectCol<T, R, A>&&) = default;
 
-  virtual ~MatrixVectCol() = default;
+  ~MatrixVectCol() = default;
 
-  const T& at(size_t row) const;
-  T& at(size_t row);
+  constexpr const T& at(size_t row) const;
+  constexpr T& at(size_t row);
 
-  template <typename U, size_t V>
-  friend std::ostream& operator<< (std::ostream& o, const MatrixVectCol<U, V>& vec_col);
+  // unchecked at(), the index is asserted in debug builds only
+  constexpr const T& operator()(size_t row) const;
+  constexpr T& operator()(size_t row);
+  using Matrix <T, R, 1, A>::operator();
+
+  template <typename U, size_t V, typename B>
+  friend std::ostream& operator<< (std::ostream& o, const MatrixVectCol<U, V, B>& vec_col);
 
   };
 
 
-template<typename T, size_t R>
-const T& MatrixVectCol<T, R>::at(size_t row) const
+template<typename T, size_t R, typename A>
+constexpr const T& MatrixVectCol<T, R, A>::at(size_t row) const
   {
   return this->m_data.at(row-1); // index of vector in math begins with 1 
   }
 
 
-template<typename T, size_t R>
-T& MatrixVectCol<T, R>::at(size_t row)
+template<typename T, size_t R, typename A>
+constexpr T& MatrixVectCol<T, R, A>::at(size_t row)
   {
   return this->m_data.at(row-1); // index of vector in math begins with 1 
   }
 
 
-template <typename U, size_t V>
-std::ostream& operator<< (std::ostream& o, const MatrixVectCol<U, V>& vec_col)
+template<typename T, size_t R, typename A>
+constexpr const T& MatrixVectCol<T, R, A>::operator()(size_t row) const
+  {
+  assert(row >= 1 && row <= R);
+  return this->m_data[row - 1];
+  }
+
+
+template<typename T, size_t R, typename A>
+constexpr T& MatrixVectCol<T, R, A>::operator()(size_t row)
+  {
+  assert(row >= 1 && row <= R);
+  return this->m_data[row - 1];
+  }
+
+
+template <typename U, size_t V, typename B>
+std::ostream& operator<< (std::ostream& o, const MatrixVectCol<U, V, B>& vec_col)
   {
   
   for (const U& elem : vec_col.m_data)
     {
-    std::cout << "| ";
-    std::cout << elem;
-    std::cout << " |\n";
+    o << "| ";
+    o << elem;
+    o << " |\n";
     }
 
   return o;
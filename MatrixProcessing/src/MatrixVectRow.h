@@ -8,59 +8,83 @@ This class is a specialization of one-row Matrix
 
 #include "Matrix.h"
 
-template <typename T, size_t C>
-class MatrixVectRow : public Matrix <T, 1, C>
+template <typename T, size_t C, typename A = AlignedAllocator<T>>
+class MatrixVectRow : public Matrix <T, 1, C, A>
   {
   public:
 
-  MatrixVectRow() : Matrix <T, 1, C>() {}
-  MatrixVectRow(const std::vector<T>& vec) : Matrix <T, 1, C>(vec) {}
-  MatrixVectRow(std::vector<T>&& vec) : Matrix <T, 1, C>(vec) {}
-  MatrixVectRow(std::initializer_list<T>&& init_list) : Matrix <T, 1, C>(init_list) {}
+  constexpr MatrixVectRow() : Matrix <T, 1, C, A>() {}
+  template <typename VA = std::allocator<T>>
+  MatrixVectRow(const std::vector<T, VA>& vec) : Matrix <T, 1, C, A>(vec) {}
+  // takes over the buffer of std::vector<T, A>, see Matrix
+  template <typename VA = std::allocator<T>>
+  MatrixVectRow(std::vector<T, VA>&& vec) : Matrix <T, 1, C, A>(std::move(vec)) {}
+  constexpr MatrixVectRow(std::initializer_list<T>&& init_list) : Matrix <T, 1, C, A>(std::move(init_list)) {}
 
-  MatrixVectRow(const MatrixVectRow<T, C>&) = default;
-  MatrixVectRow(MatrixVectRow<T, C>&&) = default;
+  MatrixVectRow(const MatrixVectRow<T, C, A>&) = default;
+  MatrixVectRow(MatrixVectRow<T, C, A>&&) = default;
    
-  MatrixVectRow& operator=(const MatrixVectRow<T, C>&) = default;
-  MatrixVectRow& operator=(MatrixVectRow<T, C>&&) = default;
+  MatrixVectRow& operator=(const MatrixVectRow<T, C, A>&) = default;
+  MatrixVectRow& operator=(MatrixVectRow<T, C, A>&&) = default;
 
-  virtual ~MatrixVectRow() = default;
+  ~MatrixVectRow() = default;
 
-  const T& at(size_t col) const;
-  T& at(size_t col);
+  constexpr const T& at(size_t col) const;
+  constexpr T& at(size_t col);
 
-  template <typename U, size_t V>
-  friend std::ostream& operator<< (std::ostream& o, const MatrixVectRow<U, V>& vec_row);
+  // unchecked at(), the index is asserted in debug builds only
+  constexpr const T& operator()(size_t col) const;
+  constexpr T& operator()(size_t col);
+  using Matrix <T, 1, C, A>::operator();
+
+  template <typename U, size_t V, typename B>
+  friend std::ostream& operator<< (std::ostream& o, const MatrixVectRow<U, V, B>& vec_row);
   };
 
 
-template<typename T, size_t C>
-const T& MatrixVectRow<T, C>::at(size_t col) const
+template<typename T, size_t C, typename A>
+constexpr const T& MatrixVectRow<T, C, A>::at(size_t col) const
   {
   return this->m_data.at(col-1); // indexing of vector in math begins with 1 
   }
 
 
-template<typename T, size_t C>
-T& MatrixVectRow<T, C>::at(size_t col)
+template<typename T, size_t C, typename A>
+constexpr T& MatrixVectRow<T, C, A>::at(size_t col)
   {
   return this->m_data.at(col-1); // indexing of vector in math begins with 1 
   }
 
 
-template <typename U, size_t V>
-std::ostream& operator<< (std::ostream& o, const MatrixVectRow<U, V>& vec_row)
+template<typename T, size_t C, typename A>
+constexpr const T& MatrixVectRow<T, C, A>::operator()(size_t col) const
+  {
+  assert(col >= 1 && col <= C);
+  return this->m_data[col - 1];
+  }
+
+
+template<typename T, size_t C, typename A>
+constexpr T& MatrixVectRow<T, C, A>::operator()(size_t col)
+  {
+  assert(col >= 1 && col <= C);
+  return this->m_data[col - 1];
+  }
+
+
+template <typename U, size_t V, typename B>
+std::ostream& operator<< (std::ostream& o, const MatrixVectRow<U, V, B>& vec_row)
   {
-  std::cout << "| ";
+  o << "| ";
   for (const U& elem : vec_row.m_data)
     {
-    std::cout << elem;
+    o << elem;
     if (&elem != &vec_row.m_data.back())
       {
-      std::cout << "\t";
+      o << "\t";
       }
     }
-  std::cout << " |\n";
+  o << " |\n";
 
   return o;
   }
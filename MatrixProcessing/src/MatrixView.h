@@ -0,0 +1,146 @@
+/*
+
+This class represents non-owning view over rectangular block of existing Matrix
+
+*/
+
+#pragma once
+
+#include <stdexcept>
+#include <type_traits>
+#include "Matrix.h"
+
+
+/// <summary>
+/// R x C block of row-major data: element (row, col) is data()[(row - 1) * row stride + col - 1].
+/// T is const for read-only views. Nothing is copied, the viewed matrix must outlive the view.
+/// </summary>
+template <typename T, size_t R, size_t C>
+class MatrixView
+  {
+  T* m_data;
+  size_t m_row_stride;
+
+  public:
+
+  using value_type = std::remove_const_t<T>;
+
+  MatrixView(T* data, size_t row_stride) : m_data(data), m_row_stride(row_stride)
+    {
+    static_assert(R * C > 0);
+    }
+
+  // writable view converts to read-only one
+  template <typename U, std::enable_if_t<std::is_same_v<const U, T>>* = nullptr>
+  MatrixView(const MatrixView<U, R, C>& view) : m_data(view.data()), m_row_stride(view.get_row_stride()) {}
+
+  T* data() const
+    {
+    return m_data;
+    }
+
+  static constexpr size_t get_n_rows() { return R; }
+  static constexpr size_t get_n_cols() { return C; }
+
+  size_t get_row_stride() const
+    {
+    return m_row_stride;
+    }
+
+  T& at(size_t row, size_t col) const
+    {
+    if (row == 0 || row > R || col == 0 || col > C)
+      {
+      throw std::out_of_range("Index is out of matrix bounds");
+      }
+    return m_data[(row - 1) * m_row_stride + col - 1];
+    }
+  };
+
+
+template <typename T, size_t C>
+using RowView = MatrixView<T, 1, C>;
+
+template <typename T, size_t R>
+using ColView = MatrixView<T, R, 1>;
+
+
+namespace Detail {
+
+  inline void check_block(size_t row, size_t col, size_t n_rows, size_t n_cols, size_t rows, size_t cols)
+    {
+    if (row == 0 || col == 0 || row - 1 + n_rows > rows || col - 1 + n_cols > cols)
+      {
+      throw std::out_of_range("Block is out of matrix bounds");
+      }
+    }
+
+  }
+
+
+/// <summary>
+/// R2 x C2 block of the matrix starting at (row, col). Indices start from 1 as in Matrix::at.
+/// </summary>
+template <size_t R2, size_t C2, typename T, size_t R, size_t C, typename A>
+MatrixView<T, R2, C2> submatrix(Matrix<T, R, C, A>& mat, size_t row, size_t col)
+  {
+  static_assert(R2 <= R && C2 <= C, "Block is bigger than the matrix");
+  Detail::check_block(row, col, R2, C2, R, C);
+  return MatrixView<T, R2, C2>(mat.data() + (row - 1) * C + col - 1, C);
+  }
+
+template <size_t R2, size_t C2, typename T, size_t R, size_t C, typename A>
+MatrixView<const T, R2, C2> submatrix(const Matrix<T, R, C, A>& mat, size_t row, size_t col)
+  {
+  static_assert(R2 <= R && C2 <= C, "Block is bigger than the matrix");
+  Detail::check_block(row, col, R2, C2, R, C);
+  return MatrixView<const T, R2, C2>(mat.data() + (row - 1) * C + col - 1, C);
+  }
+
+template <size_t R2, size_t C2, typename T, size_t R, size_t C, typename A>
+MatrixView<const T, R2, C2> submatrix(const Matrix<T, R, C, A>&& mat, size_t row, size_t col) = delete;
+
+template <size_t R2, size_t C2, typename T, size_t R, size_t C>
+MatrixView<T, R2, C2> submatrix(const MatrixView<T, R, C>& view, size_t row, size_t col)
+  {
+  static_assert(R2 <= R && C2 <= C, "Block is bigger than the matrix");
+  Detail::check_block(row, col, R2, C2, R, C);
+  return MatrixView<T, R2, C2>(view.data() + (row - 1) * view.get_row_stride() + col - 1, view.get_row_stride());
+  }
+
+
+/// <summary>
+/// Row of the matrix, index starts from 1.
+/// </summary>
+template <typename M>
+auto row_view(M&& mat, size_t row)
+  {
+  constexpr size_t C = std::decay_t<M>::get_n_cols();
+  return submatrix<1, C>(std::forward<M>(mat), row, 1);
+  }
+
+
+/// <summary>
+/// Column of the matrix, index starts from 1.
+/// </summary>
+template <typename M>
+auto col_view(M&& mat, size_t col)
+  {
+  constexpr size_t R = std::decay_t<M>::get_n_rows();
+  return submatrix<R, 1>(std::forward<M>(mat), 1, col);
+  }
+
+
+/// <summary>
+/// Copies viewed elements into a new Matrix.
+/// </summary>
+template <typename T, size_t R, size_t C>
+Matrix<std::remove_const_t<T>, R, C> to_matrix(const MatrixView<T, R, C>& view)
+  {
+  Matrix<std::remove_const_t<T>, R, C> result;
+  for (size_t row = 0; row < R; ++row)
+    {
+    std::copy(view.data() + row * view.get_row_stride(), view.data() + row * view.get_row_stride() + C, result.data() + row * C);
+    }
+  return result;
+  }
@@ -0,0 +1,151 @@
+/*
+
+This file contains out-of-core multiplication of matrices stored in files
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <future>
+#include <algorithm>
+#include <stdexcept>
+#include "AlignedAllocator.h"
+#include "ExecutionPolicy.h"
+#include "MatrixFile.h"
+#include "Gemm.h"
+
+/// <summary>
+/// This namespace contains streaming multiplication used by OutOfCoreMultiplyMatrix.
+///
+/// C is computed tile by tile. For every tile of C the matching panels of A and B are streamed
+/// along the inner dimension and accumulated into the tile, which is written to disk when done.
+/// There are two buffers for the panels: while one is multiplied, the panels of the next step
+/// are read into the other on a separate thread, so disk reads overlap compute.
+/// Memory used is one tile of C and two pairs of panels, whatever the size of the files.
+/// </summary>
+namespace MatrixProcessors { namespace OutOfCore {
+
+  /// <summary>
+  /// Memory for tiles and panels used when nothing else is given.
+  /// </summary>
+  constexpr size_t default_memory_budget = size_t(256) << 20;
+
+  /// <summary>
+  /// Budgets giving tiles smaller than this are rejected, disk reads of tiny panels cost more than they compute.
+  /// </summary>
+  constexpr size_t min_tile_size = 64;
+
+
+  /// <summary>
+  /// Side of square tiles such that one tile of C and two tiles of both A and B fit into the budget.
+  /// </summary>
+  template <typename T>
+  size_t tile_size(size_t memory_budget)
+    {
+    const size_t side = static_cast<size_t>(std::sqrt(double(memory_budget) / (5.0 * sizeof(T))));
+    if (side < min_tile_size)
+      {
+      throw std::invalid_argument("Memory budget is too small for out-of-core multiplication");
+      }
+    return side;
+    }
+
+
+  /// <summary>
+  /// Computes C = A * B for files of shape m x k, k x n and m x n.
+  /// </summary>
+  template <typename T>
+  void multiply(const MatrixIO::MatrixFile<T>& a, const MatrixIO::MatrixFile<T>& b, const MatrixIO::MatrixFile<T>& c,
+                size_t memory_budget, const ExecutionPolicy& policy)
+    {
+    const size_t m = a.get_n_rows();
+    const size_t k = a.get_n_cols();
+    const size_t n = b.get_n_cols();
+    if (m == 0 || n == 0)
+      {
+      return;
+      }
+
+    const size_t side = tile_size<T>(memory_budget);
+    const size_t mb = std::min(side, m);
+    const size_t nb = std::min(side, n);
+    const size_t kb = std::min(side, std::max<size_t>(k, 1));
+    const size_t n_i = (m + mb - 1) / mb;
+    const size_t n_j = (n + nb - 1) / nb;
+    // with k == 0 every tile still takes one step that writes zeros
+    const size_t n_p = std::max<size_t>((k + kb - 1) / kb, 1);
+
+    struct Panels
+      {
+      std::vector<T, AlignedAllocator<T>> a;
+      std::vector<T, AlignedAllocator<T>> b;
+      };
+    Panels panels[2];
+    for (Panels& buffer : panels)
+      {
+      buffer.a.resize(mb * kb);
+      buffer.b.resize(kb * nb);
+      }
+    std::vector<T, AlignedAllocator<T>> c_tile(mb * nb);
+
+    std::ifstream a_stream = a.open_for_reading();
+    std::ifstream b_stream = b.open_for_reading();
+    std::fstream c_stream = c.open_for_writing();
+
+    // steps go through tiles of C row by row, and through panels of the inner dimension inside every tile
+    const size_t n_steps = n_i * n_j * n_p;
+    auto load = [&](size_t step, Panels& buffer)
+      {
+      const size_t p = step % n_p * kb;
+      const size_t j = step / n_p % n_j * nb;
+      const size_t i = step / n_p / n_j * mb;
+      const size_t depth = std::min(kb, k - std::min(p, k));
+      a.read_block(a_stream, i + 1, p + 1, std::min(mb, m - i), depth, buffer.a.data());
+      b.read_block(b_stream, p + 1, j + 1, depth, std::min(nb, n - j), buffer.b.data());
+      };
+
+    std::future<void> next = std::async(std::launch::async, load, 0, std::ref(panels[0]));
+    for (size_t step = 0; step < n_steps; ++step)
+      {
+      next.get();
+      if (step + 1 < n_steps)
+        {
+        next = std::async(std::launch::async, load, step + 1, std::ref(panels[(step + 1) % 2]));
+        }
+
+      const Panels& current = panels[step % 2];
+      const size_t p = step % n_p * kb;
+      const size_t j = step / n_p % n_j * nb;
+      const size_t i = step / n_p / n_j * mb;
+      const size_t rows = std::min(mb, m - i);
+      const size_t cols = std::min(nb, n - j);
+      const size_t depth = std::min(kb, k - std::min(p, k));
+
+      if (p == 0)
+        {
+        std::fill(c_tile.begin(), c_tile.begin() + rows * cols, T(0));
+        }
+      if (rows * cols * depth > Gemm::small_product_threshold)
+        {
+        Gemm::multiply(rows, cols, depth, current.a.data(), depth, 1, current.b.data(), cols, 1, c_tile.data(), cols, policy, true);
+        }
+      else
+        {
+        Gemm::multiply_small(rows, cols, depth, current.a.data(), depth, 1, current.b.data(), cols, 1, c_tile.data(), cols);
+        }
+
+      if (step % n_p == n_p - 1)
+        {
+        c.write_block(c_stream, i + 1, j + 1, rows, cols, c_tile.data());
+        }
+      }
+    c_stream.flush();
+    if (!c_stream)
+      {
+      throw std::runtime_error("Can`t write file " + c.get_path());
+      }
+    }
+
+  } }
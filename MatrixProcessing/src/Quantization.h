@@ -0,0 +1,202 @@
+/*
+
+This file contains affine quantization of matrices to narrow integer types
+
+*/
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "Matrix.h"
+#include "DynamicMatrix.h"
+#include "AlignedAllocator.h"
+#include "ThreadPool.h"
+
+/// <summary>
+/// This namespace contains quantization used by QuantizedMultiplyMatrix.
+///
+/// Real value x is stored as integer q = round(x / scale) + zero_point clamped to the range of Q,
+/// and read back as scale * (q - zero_point). Zero is always exact, so zero padding stays zero.
+/// int8 storage takes a quarter of float, and the product of two quantized matrices is computed
+/// on integers with a wide accumulator: sum of (a - za) * (b - zb) = sum of a * b - zb * row sums of A
+/// - za * column sums of B + k * za * zb, so the inner loop multiplies raw values only.
+/// </summary>
+namespace MatrixProcessors { namespace Quantization {
+
+  struct Params
+    {
+    float scale = 1.0f;
+    int32_t zero_point = 0;
+    };
+
+
+  /// <summary>
+  /// Parameters mapping [min, max], widened to contain zero, onto the whole range of Q.
+  /// </summary>
+  template <typename Q>
+  Params choose_params(float min, float max)
+    {
+    static_assert(std::is_integral_v<Q> && sizeof(Q) <= 2, "Quantized type must be an integer of at most 16 bits");
+    if (!(min <= max))
+      {
+      throw std::invalid_argument("Quantization range is empty");
+      }
+    min = std::min(min, 0.0f);
+    max = std::max(max, 0.0f);
+    constexpr float q_min = float(std::numeric_limits<Q>::min());
+    constexpr float q_max = float(std::numeric_limits<Q>::max());
+
+    Params params;
+    if (max > min)
+      {
+      params.scale = (max - min) / (q_max - q_min);
+      }
+    params.zero_point = static_cast<int32_t>(std::clamp(std::nearbyint(q_min - min / params.scale), q_min, q_max));
+    return params;
+    }
+
+  /// <summary>
+  /// Parameters covering n values, e.g. all elements of a matrix.
+  /// </summary>
+  template <typename Q, typename T>
+  Params choose_params(const T* data, size_t n)
+    {
+    if (n == 0)
+      {
+      return choose_params<Q>(0.0f, 0.0f);
+      }
+    const auto bounds = std::minmax_element(data, data + n);
+    return choose_params<Q>(float(*bounds.first), float(*bounds.second));
+    }
+
+
+  /// <summary>
+  /// out[i] = quantized in[i], rounded to nearest even and clamped. Elements are split between threads allowed by the policy.
+  /// </summary>
+  template <typename Q, typename T>
+  void quantize(const T* in, Q* out, size_t n, const Params& params, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    constexpr float q_min = float(std::numeric_limits<Q>::min());
+    constexpr float q_max = float(std::numeric_limits<Q>::max());
+    const float inverse_scale = 1.0f / params.scale;
+    const float zero_point = float(params.zero_point);
+    parallel_for(policy, n, 1 << 15, [=](size_t begin, size_t end)
+      {
+      for (size_t i = begin; i < end; ++i)
+        {
+        const float q = std::nearbyint(float(in[i]) * inverse_scale) + zero_point;
+        out[i] = static_cast<Q>(std::clamp(q, q_min, q_max));
+        }
+      });
+    }
+
+  /// <summary>
+  /// out[i] = scale * (in[i] - zero_point).
+  /// </summary>
+  template <typename T, typename Q>
+  void dequantize(const Q* in, T* out, size_t n, const Params& params, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    const float scale = params.scale;
+    const int32_t zero_point = params.zero_point;
+    parallel_for(policy, n, 1 << 15, [=](size_t begin, size_t end)
+      {
+      for (size_t i = begin; i < end; ++i)
+        {
+        out[i] = static_cast<T>(scale * float(int32_t(in[i]) - zero_point));
+        }
+      });
+    }
+
+
+  template <typename Q, typename T, size_t R, size_t C, typename A>
+  Matrix<Q, R, C, rebind_allocator_t<A, Q>> quantize(const Matrix<T, R, C, A>& mat, const Params& params, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    Matrix<Q, R, C, rebind_allocator_t<A, Q>> result;
+    quantize(mat.data(), result.data(), R * C, params, policy);
+    return result;
+    }
+
+  template <typename Q, typename T, typename A>
+  DynamicMatrix<Q, rebind_allocator_t<A, Q>> quantize(const DynamicMatrix<T, A>& mat, const Params& params, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    DynamicMatrix<Q, rebind_allocator_t<A, Q>> result(mat.get_n_rows(), mat.get_n_cols());
+    quantize(mat.data(), result.data(), mat.get_n_rows() * mat.get_n_cols(), params, policy);
+    return result;
+    }
+
+  template <typename T = float, typename Q, size_t R, size_t C, typename A>
+  Matrix<T, R, C, rebind_allocator_t<A, T>> dequantize(const Matrix<Q, R, C, A>& mat, const Params& params, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    Matrix<T, R, C, rebind_allocator_t<A, T>> result;
+    dequantize(mat.data(), result.data(), R * C, params, policy);
+    return result;
+    }
+
+  template <typename T = float, typename Q, typename A>
+  DynamicMatrix<T, rebind_allocator_t<A, T>> dequantize(const DynamicMatrix<Q, A>& mat, const Params& params, const ExecutionPolicy& policy = ExecutionPolicy())
+    {
+    DynamicMatrix<T, rebind_allocator_t<A, T>> result(mat.get_n_rows(), mat.get_n_cols());
+    dequantize(mat.data(), result.data(), mat.get_n_rows() * mat.get_n_cols(), params, policy);
+    return result;
+    }
+
+
+  namespace Detail {
+
+    /// <summary>
+    /// Turns c = A * B of raw m x k A and k x n B into the product of A - za and B - zb.
+    /// </summary>
+    template <typename Acc, typename T, typename U>
+    void subtract_zero_points(size_t m, size_t n, size_t k, const T* a, const U* b, Acc* c, int32_t za, int32_t zb)
+      {
+      if (za == 0 && zb == 0)
+        {
+        return;
+        }
+      std::vector<Acc> row_terms(m, Acc(0));
+      std::vector<Acc> col_terms(n, Acc(0));
+      if (zb != 0)
+        {
+        for (size_t i = 0; i < m; ++i)
+          {
+          Acc sum = 0;
+          for (size_t p = 0; p < k; ++p)
+            {
+            sum += Acc(a[i * k + p]);
+            }
+          row_terms[i] = Acc(zb) * sum;
+          }
+        }
+      if (za != 0)
+        {
+        for (size_t p = 0; p < k; ++p)
+          {
+          for (size_t j = 0; j < n; ++j)
+            {
+            col_terms[j] += Acc(b[p * n + j]);
+            }
+          }
+        for (size_t j = 0; j < n; ++j)
+          {
+          col_terms[j] = Acc(za) * col_terms[j] - Acc(k) * Acc(za) * Acc(zb);
+          }
+        }
+      for (size_t i = 0; i < m; ++i)
+        {
+        for (size_t j = 0; j < n; ++j)
+          {
+          c[i * n + j] -= row_terms[i] + col_terms[j];
+          }
+        }
+      }
+
+    }
+
+  } }
@@ -0,0 +1,737 @@
+/*
+
+This file contains SIMD kernels for elementwise Matrix Processors with runtime CPU dispatch
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "ConstantEvaluation.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MATRIX_PROCESSING_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC accepts any intrinsic in any function, GCC and Clang need per-function target
+#if defined(MATRIX_PROCESSING_X86) && (defined(__GNUC__) || defined(__clang__))
+#define MATRIX_PROCESSING_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MATRIX_PROCESSING_TARGET(isa)
+#endif
+
+
+/// <summary>
+/// This namespace contains vectorized elementwise kernels
+/// </summary>
+namespace MatrixProcessors { namespace Simd {
+
+  enum class InstructionSet { Scalar, SSE2, AVX2, AVX512 };
+
+
+  /// <summary>
+  /// Asks CPUID which instruction set is supported by both processor and OS.
+  /// </summary>
+  inline InstructionSet detect_instruction_set()
+    {
+#if defined(MATRIX_PROCESSING_X86)
+    unsigned int regs1[4] = {};
+    unsigned int regs7[4] = {};
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const unsigned int max_leaf = static_cast<unsigned int>(info[0]);
+    __cpuid(info, 1);
+    for (int i = 0; i < 4; ++i) { regs1[i] = static_cast<unsigned int>(info[i]); }
+    if (max_leaf >= 7)
+      {
+      __cpuidex(info, 7, 0);
+      for (int i = 0; i < 4; ++i) { regs7[i] = static_cast<unsigned int>(info[i]); }
+      }
+#else
+    const unsigned int max_leaf = __get_cpuid_max(0, nullptr);
+    __get_cpuid(1, &regs1[0], &regs1[1], &regs1[2], &regs1[3]);
+    if (max_leaf >= 7)
+      {
+      __get_cpuid_count(7, 0, &regs7[0], &regs7[1], &regs7[2], &regs7[3]);
+      }
+#endif
+
+    const bool sse2 = (regs1[3] >> 26) & 1;
+    const bool osxsave = (regs1[2] >> 27) & 1;
+    const bool avx = (regs1[2] >> 28) & 1;
+    const bool avx2 = (regs7[1] >> 5) & 1;
+    const bool avx512f = (regs7[1] >> 16) & 1;
+
+    // XCR0 tells which register files the OS saves on context switch
+    uint64_t xcr0 = 0;
+    if (osxsave)
+      {
+#if defined(_MSC_VER)
+      xcr0 = _xgetbv(0);
+#else
+      unsigned int eax = 0;
+      unsigned int edx = 0;
+      __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+      xcr0 = (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+      }
+    const bool ymm_enabled = (xcr0 & 0x06) == 0x06;
+    const bool zmm_enabled = (xcr0 & 0xE6) == 0xE6;
+
+    if (avx512f && avx2 && zmm_enabled)
+      {
+      return InstructionSet::AVX512;
+      }
+    if (avx && avx2 && ymm_enabled)
+      {
+      return InstructionSet::AVX2;
+      }
+    if (sse2)
+      {
+      return InstructionSet::SSE2;
+      }
+#endif
+    return InstructionSet::Scalar;
+    }
+
+
+  /// <summary>
+  /// Asks CPUID whether the processor has FMA3. Only meaningful together with AVX2, which already checks the OS.
+  /// </summary>
+  inline bool detect_fma()
+    {
+#if defined(MATRIX_PROCESSING_X86)
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (static_cast<unsigned int>(info[2]) >> 12) & 1;
+#else
+    unsigned int regs1[4] = {};
+    __get_cpuid(1, &regs1[0], &regs1[1], &regs1[2], &regs1[3]);
+    return (regs1[2] >> 12) & 1;
+#endif
+#else
+    return false;
+#endif
+    }
+
+
+  namespace Detail {
+
+    inline const InstructionSet detected_instruction_set = detect_instruction_set();
+    inline const bool detected_fma = detect_fma();
+    inline InstructionSet active_instruction_set = detected_instruction_set;
+
+  }
+
+
+  /// <summary>
+  /// Returns instruction set used by the kernels. It is picked once at program startup.
+  /// </summary>
+  inline InstructionSet active_instruction_set()
+    {
+    return Detail::active_instruction_set;
+    }
+
+
+  /// <summary>
+  /// Tells whether 256-bit FMA kernels may run, i.e. AVX2 is active and the processor has FMA3.
+  /// </summary>
+  inline bool fma_enabled()
+    {
+    return Detail::active_instruction_set >= InstructionSet::AVX2 && Detail::detected_fma;
+    }
+
+
+  /// <summary>
+  /// Restricts kernels to the given instruction set (clamped to what CPU supports).
+  /// Meant for testing and benchmarking, must not race with running kernels.
+  /// </summary>
+  inline void force_instruction_set(InstructionSet isa)
+    {
+    Detail::active_instruction_set = isa < Detail::detected_instruction_set ? isa : Detail::detected_instruction_set;
+    }
+
+
+  /// <summary>
+  /// Elementwise operations. apply() is the scalar definition every SIMD kernel must reproduce.
+  /// </summary>
+  struct Add
+    {
+    template <typename A, typename B>
+    static constexpr auto apply(const A& a, const B& b) { return a + b; }
+    };
+
+  struct Subtract
+    {
+    template <typename A, typename B>
+    static constexpr auto apply(const A& a, const B& b) { return a - b; }
+    };
+
+  struct Multiply
+    {
+    template <typename A, typename B>
+    static constexpr auto apply(const A& a, const B& b) { return a * b; }
+    };
+
+
+  namespace Detail {
+
+    template <typename T>
+    struct Tag {};
+
+    template <typename T>
+    constexpr bool is_kernel_type = std::is_same_v<T, int> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+    // Vector path exists when both operands are int/float/double and result is their usual promotion
+    template <typename R, typename A, typename B>
+    constexpr bool is_vectorizable = is_kernel_type<A> && is_kernel_type<B>
+                                  && std::is_same_v<R, decltype(std::declval<A>() + std::declval<B>())>;
+
+
+#if defined(MATRIX_PROCESSING_X86)
+
+    struct SSE2
+      {
+      template <typename R>
+      static constexpr size_t width = 16 / sizeof(R);
+
+      MATRIX_PROCESSING_TARGET("sse2") static __m128d load(const double* p, Tag<double>) { return _mm_loadu_pd(p); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128d load(const float* p, Tag<double>) { return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)))); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128d load(const int* p, Tag<double>) { return _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128 load(const float* p, Tag<float>) { return _mm_loadu_ps(p); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128 load(const int* p, Tag<float>) { return _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128i load(const int* p, Tag<int>) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+
+      MATRIX_PROCESSING_TARGET("sse2") static __m128d broadcast(double v) { return _mm_set1_pd(v); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128 broadcast(float v) { return _mm_set1_ps(v); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128i broadcast(int v) { return _mm_set1_epi32(v); }
+
+      MATRIX_PROCESSING_TARGET("sse2") static void store(double* p, __m128d v) { _mm_storeu_pd(p, v); }
+      MATRIX_PROCESSING_TARGET("sse2") static void store(float* p, __m128 v) { _mm_storeu_ps(p, v); }
+      MATRIX_PROCESSING_TARGET("sse2") static void store(int* p, __m128i v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+      MATRIX_PROCESSING_TARGET("sse2") static __m128d op(Add, __m128d a, __m128d b) { return _mm_add_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128d op(Subtract, __m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128d op(Multiply, __m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128 op(Add, __m128 a, __m128 b) { return _mm_add_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128 op(Subtract, __m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128 op(Multiply, __m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128i op(Add, __m128i a, __m128i b) { return _mm_add_epi32(a, b); }
+      MATRIX_PROCESSING_TARGET("sse2") static __m128i op(Subtract, __m128i a, __m128i b) { return _mm_sub_epi32(a, b); }
+
+      // SSE2 has no 32-bit mullo, multiply even and odd lanes separately
+      MATRIX_PROCESSING_TARGET("sse2") static __m128i op(Multiply, __m128i a, __m128i b)
+        {
+        const __m128i even = _mm_mul_epu32(a, b);
+        const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        }
+
+      template <typename Op, typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("sse2") static size_t transform(const A* a, const B* b, R* out, size_t n)
+        {
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(out + i, op(Op{}, load(a + i, Tag<R>{}), load(b + i, Tag<R>{})));
+          }
+        return i;
+        }
+
+      template <typename Op, typename R, typename A>
+      MATRIX_PROCESSING_TARGET("sse2") static size_t transform_scalar(const A* a, R b, R* out, size_t n)
+        {
+        const auto vb = broadcast(b);
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(out + i, op(Op{}, load(a + i, Tag<R>{}), vb));
+          }
+        return i;
+        }
+
+      template <typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("sse2") static size_t multiply_accumulate(const A* a, const B* b, R* acc, size_t n)
+        {
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(acc + i, op(Add{}, load(acc + i, Tag<R>{}), op(Multiply{}, load(a + i, Tag<R>{}), load(b + i, Tag<R>{}))));
+          }
+        return i;
+        }
+
+      template <typename R, typename B>
+      MATRIX_PROCESSING_TARGET("sse2") static size_t multiply_accumulate_scalar(R a, const B* b, R* acc, size_t n)
+        {
+        const auto va = broadcast(a);
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(acc + i, op(Add{}, load(acc + i, Tag<R>{}), op(Multiply{}, va, load(b + i, Tag<R>{}))));
+          }
+        return i;
+        }
+
+      // Partial sums of dot products for dot_rows: lane l of row r sums a[r * rsa + i] * x[i] over i equal to l
+      // modulo 2 * width, two registers per row make the eight or four lanes of one AVX2 register
+      template <typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("sse2") static size_t dot_lanes4(const A* a, size_t rsa, const B* x, R* lanes, size_t n)
+        {
+        constexpr size_t w = width<R>;
+        auto s00 = broadcast(R(0)), s01 = s00, s10 = s00, s11 = s00, s20 = s00, s21 = s00, s30 = s00, s31 = s00;
+        size_t i = 0;
+        for (; i + 2 * w <= n; i += 2 * w)
+          {
+          const auto x0 = load(x + i, Tag<R>{});
+          const auto x1 = load(x + i + w, Tag<R>{});
+          s00 = op(Add{}, s00, op(Multiply{}, load(a + i, Tag<R>{}), x0));
+          s01 = op(Add{}, s01, op(Multiply{}, load(a + i + w, Tag<R>{}), x1));
+          s10 = op(Add{}, s10, op(Multiply{}, load(a + rsa + i, Tag<R>{}), x0));
+          s11 = op(Add{}, s11, op(Multiply{}, load(a + rsa + i + w, Tag<R>{}), x1));
+          s20 = op(Add{}, s20, op(Multiply{}, load(a + 2 * rsa + i, Tag<R>{}), x0));
+          s21 = op(Add{}, s21, op(Multiply{}, load(a + 2 * rsa + i + w, Tag<R>{}), x1));
+          s30 = op(Add{}, s30, op(Multiply{}, load(a + 3 * rsa + i, Tag<R>{}), x0));
+          s31 = op(Add{}, s31, op(Multiply{}, load(a + 3 * rsa + i + w, Tag<R>{}), x1));
+          }
+        store(lanes, s00); store(lanes + w, s01);
+        store(lanes + 2 * w, s10); store(lanes + 3 * w, s11);
+        store(lanes + 4 * w, s20); store(lanes + 5 * w, s21);
+        store(lanes + 6 * w, s30); store(lanes + 7 * w, s31);
+        return i;
+        }
+
+      template <typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("sse2") static size_t dot_lanes1(const A* a, const B* x, R* lanes, size_t n)
+        {
+        constexpr size_t w = width<R>;
+        auto s0 = broadcast(R(0)), s1 = s0;
+        size_t i = 0;
+        for (; i + 2 * w <= n; i += 2 * w)
+          {
+          s0 = op(Add{}, s0, op(Multiply{}, load(a + i, Tag<R>{}), load(x + i, Tag<R>{})));
+          s1 = op(Add{}, s1, op(Multiply{}, load(a + i + w, Tag<R>{}), load(x + i + w, Tag<R>{})));
+          }
+        store(lanes, s0); store(lanes + w, s1);
+        return i;
+        }
+      };
+
+
+    struct AVX2
+      {
+      template <typename R>
+      static constexpr size_t width = 32 / sizeof(R);
+
+      MATRIX_PROCESSING_TARGET("avx2") static __m256d load(const double* p, Tag<double>) { return _mm256_loadu_pd(p); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256d load(const float* p, Tag<double>) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256d load(const int* p, Tag<double>) { return _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256 load(const float* p, Tag<float>) { return _mm256_loadu_ps(p); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256 load(const int* p, Tag<float>) { return _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256i load(const int* p, Tag<int>) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+      MATRIX_PROCESSING_TARGET("avx2") static __m256d broadcast(double v) { return _mm256_set1_pd(v); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256 broadcast(float v) { return _mm256_set1_ps(v); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256i broadcast(int v) { return _mm256_set1_epi32(v); }
+
+      MATRIX_PROCESSING_TARGET("avx2") static void store(double* p, __m256d v) { _mm256_storeu_pd(p, v); }
+      MATRIX_PROCESSING_TARGET("avx2") static void store(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+      MATRIX_PROCESSING_TARGET("avx2") static void store(int* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+      MATRIX_PROCESSING_TARGET("avx2") static __m256d op(Add, __m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256d op(Subtract, __m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256d op(Multiply, __m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256 op(Add, __m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256 op(Subtract, __m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256 op(Multiply, __m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256i op(Add, __m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256i op(Subtract, __m256i a, __m256i b) { return _mm256_sub_epi32(a, b); }
+      MATRIX_PROCESSING_TARGET("avx2") static __m256i op(Multiply, __m256i a, __m256i b) { return _mm256_mullo_epi32(a, b); }
+
+      template <typename Op, typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("avx2") static size_t transform(const A* a, const B* b, R* out, size_t n)
+        {
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(out + i, op(Op{}, load(a + i, Tag<R>{}), load(b + i, Tag<R>{})));
+          }
+        return i;
+        }
+
+      template <typename Op, typename R, typename A>
+      MATRIX_PROCESSING_TARGET("avx2") static size_t transform_scalar(const A* a, R b, R* out, size_t n)
+        {
+        const auto vb = broadcast(b);
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(out + i, op(Op{}, load(a + i, Tag<R>{}), vb));
+          }
+        return i;
+        }
+
+      template <typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("avx2") static size_t multiply_accumulate(const A* a, const B* b, R* acc, size_t n)
+        {
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(acc + i, op(Add{}, load(acc + i, Tag<R>{}), op(Multiply{}, load(a + i, Tag<R>{}), load(b + i, Tag<R>{}))));
+          }
+        return i;
+        }
+
+      template <typename R, typename B>
+      MATRIX_PROCESSING_TARGET("avx2") static size_t multiply_accumulate_scalar(R a, const B* b, R* acc, size_t n)
+        {
+        const auto va = broadcast(a);
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(acc + i, op(Add{}, load(acc + i, Tag<R>{}), op(Multiply{}, va, load(b + i, Tag<R>{}))));
+          }
+        return i;
+        }
+
+      // Same as SSE2 dot_lanes4 with one register per row, AVX512 uses these as well
+      template <typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("avx2") static size_t dot_lanes4(const A* a, size_t rsa, const B* x, R* lanes, size_t n)
+        {
+        constexpr size_t w = width<R>;
+        auto s0 = broadcast(R(0)), s1 = s0, s2 = s0, s3 = s0;
+        size_t i = 0;
+        for (; i + w <= n; i += w)
+          {
+          const auto xi = load(x + i, Tag<R>{});
+          s0 = op(Add{}, s0, op(Multiply{}, load(a + i, Tag<R>{}), xi));
+          s1 = op(Add{}, s1, op(Multiply{}, load(a + rsa + i, Tag<R>{}), xi));
+          s2 = op(Add{}, s2, op(Multiply{}, load(a + 2 * rsa + i, Tag<R>{}), xi));
+          s3 = op(Add{}, s3, op(Multiply{}, load(a + 3 * rsa + i, Tag<R>{}), xi));
+          }
+        store(lanes, s0); store(lanes + w, s1); store(lanes + 2 * w, s2); store(lanes + 3 * w, s3);
+        return i;
+        }
+
+      template <typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("avx2") static size_t dot_lanes1(const A* a, const B* x, R* lanes, size_t n)
+        {
+        constexpr size_t w = width<R>;
+        auto s0 = broadcast(R(0));
+        size_t i = 0;
+        for (; i + w <= n; i += w)
+          {
+          s0 = op(Add{}, s0, op(Multiply{}, load(a + i, Tag<R>{}), load(x + i, Tag<R>{})));
+          }
+        store(lanes, s0);
+        return i;
+        }
+      };
+
+
+    struct AVX512
+      {
+      template <typename R>
+      static constexpr size_t width = 64 / sizeof(R);
+
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512d load(const double* p, Tag<double>) { return _mm512_loadu_pd(p); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512d load(const float* p, Tag<double>) { return _mm512_cvtps_pd(_mm256_loadu_ps(p)); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512d load(const int* p, Tag<double>) { return _mm512_cvtepi32_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512 load(const float* p, Tag<float>) { return _mm512_loadu_ps(p); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512 load(const int* p, Tag<float>) { return _mm512_cvtepi32_ps(_mm512_loadu_si512(p)); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512i load(const int* p, Tag<int>) { return _mm512_loadu_si512(p); }
+
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512d broadcast(double v) { return _mm512_set1_pd(v); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512 broadcast(float v) { return _mm512_set1_ps(v); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512i broadcast(int v) { return _mm512_set1_epi32(v); }
+
+      MATRIX_PROCESSING_TARGET("avx512f") static void store(double* p, __m512d v) { _mm512_storeu_pd(p, v); }
+      MATRIX_PROCESSING_TARGET("avx512f") static void store(float* p, __m512 v) { _mm512_storeu_ps(p, v); }
+      MATRIX_PROCESSING_TARGET("avx512f") static void store(int* p, __m512i v) { _mm512_storeu_si512(p, v); }
+
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512d op(Add, __m512d a, __m512d b) { return _mm512_add_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512d op(Subtract, __m512d a, __m512d b) { return _mm512_sub_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512d op(Multiply, __m512d a, __m512d b) { return _mm512_mul_pd(a, b); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512 op(Add, __m512 a, __m512 b) { return _mm512_add_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512 op(Subtract, __m512 a, __m512 b) { return _mm512_sub_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512 op(Multiply, __m512 a, __m512 b) { return _mm512_mul_ps(a, b); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512i op(Add, __m512i a, __m512i b) { return _mm512_add_epi32(a, b); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512i op(Subtract, __m512i a, __m512i b) { return _mm512_sub_epi32(a, b); }
+      MATRIX_PROCESSING_TARGET("avx512f") static __m512i op(Multiply, __m512i a, __m512i b) { return _mm512_mullo_epi32(a, b); }
+
+      template <typename Op, typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("avx512f") static size_t transform(const A* a, const B* b, R* out, size_t n)
+        {
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(out + i, op(Op{}, load(a + i, Tag<R>{}), load(b + i, Tag<R>{})));
+          }
+        return i;
+        }
+
+      template <typename Op, typename R, typename A>
+      MATRIX_PROCESSING_TARGET("avx512f") static size_t transform_scalar(const A* a, R b, R* out, size_t n)
+        {
+        const auto vb = broadcast(b);
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(out + i, op(Op{}, load(a + i, Tag<R>{}), vb));
+          }
+        return i;
+        }
+
+      template <typename R, typename A, typename B>
+      MATRIX_PROCESSING_TARGET("avx512f") static size_t multiply_accumulate(const A* a, const B* b, R* acc, size_t n)
+        {
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(acc + i, op(Add{}, load(acc + i, Tag<R>{}), op(Multiply{}, load(a + i, Tag<R>{}), load(b + i, Tag<R>{}))));
+          }
+        return i;
+        }
+
+      template <typename R, typename B>
+      MATRIX_PROCESSING_TARGET("avx512f") static size_t multiply_accumulate_scalar(R a, const B* b, R* acc, size_t n)
+        {
+        const auto va = broadcast(a);
+        size_t i = 0;
+        for (; i + width<R> <= n; i += width<R>)
+          {
+          store(acc + i, op(Add{}, load(acc + i, Tag<R>{}), op(Multiply{}, va, load(b + i, Tag<R>{}))));
+          }
+        return i;
+        }
+      };
+
+#endif
+
+  }
+
+
+  /// <summary>
+  /// out[i] = Op(a[i], b[i]) for i in [0, n).
+  /// Constant evaluation can't use intrinsics, so there this and transform_scalar run only the scalar loop.
+  /// </summary>
+  template <typename Op, typename R, typename A, typename B>
+  constexpr void transform(const A* a, const B* b, R* out, size_t n)
+    {
+    size_t done = 0;
+#if defined(MATRIX_PROCESSING_X86)
+    if constexpr (Detail::is_vectorizable<R, A, B>)
+      {
+      switch (ConstantEvaluation::is_constant_evaluated() ? InstructionSet::Scalar : active_instruction_set())
+        {
+        case InstructionSet::AVX512: done = Detail::AVX512::transform<Op>(a, b, out, n); break;
+        case InstructionSet::AVX2:   done = Detail::AVX2::transform<Op>(a, b, out, n); break;
+        case InstructionSet::SSE2:   done = Detail::SSE2::transform<Op>(a, b, out, n); break;
+        default: break;
+        }
+      }
+#endif
+    for (size_t i = done; i < n; ++i)
+      {
+      out[i] = Op::apply(a[i], b[i]);
+      }
+    }
+
+
+  /// <summary>
+  /// out[i] = Op(a[i], b) for i in [0, n).
+  /// </summary>
+  template <typename Op, typename R, typename A, typename B>
+  constexpr void transform_scalar(const A* a, const B& b, R* out, size_t n)
+    {
+    size_t done = 0;
+#if defined(MATRIX_PROCESSING_X86)
+    if constexpr (Detail::is_vectorizable<R, A, B>)
+      {
+      const R b_promoted = static_cast<R>(b);
+      switch (ConstantEvaluation::is_constant_evaluated() ? InstructionSet::Scalar : active_instruction_set())
+        {
+        case InstructionSet::AVX512: done = Detail::AVX512::transform_scalar<Op>(a, b_promoted, out, n); break;
+        case InstructionSet::AVX2:   done = Detail::AVX2::transform_scalar<Op>(a, b_promoted, out, n); break;
+        case InstructionSet::SSE2:   done = Detail::SSE2::transform_scalar<Op>(a, b_promoted, out, n); break;
+        default: break;
+        }
+      }
+#endif
+    for (size_t i = done; i < n; ++i)
+      {
+      out[i] = Op::apply(a[i], b);
+      }
+    }
+
+
+  /// <summary>
+  /// acc[i] += a[i] * b[i] for i in [0, n). Multiplication and addition are rounded separately,
+  /// as in the scalar loop, so every instruction set gives the same result.
+  /// </summary>
+  template <typename R, typename A, typename B>
+  void multiply_accumulate(const A* a, const B* b, R* acc, size_t n)
+    {
+    size_t done = 0;
+#if defined(MATRIX_PROCESSING_X86)
+    if constexpr (Detail::is_vectorizable<R, A, B>)
+      {
+      switch (active_instruction_set())
+        {
+        case InstructionSet::AVX512: done = Detail::AVX512::multiply_accumulate(a, b, acc, n); break;
+        case InstructionSet::AVX2:   done = Detail::AVX2::multiply_accumulate(a, b, acc, n); break;
+        case InstructionSet::SSE2:   done = Detail::SSE2::multiply_accumulate(a, b, acc, n); break;
+        default: break;
+        }
+      }
+#endif
+    for (size_t i = done; i < n; ++i)
+      {
+      acc[i] += a[i] * b[i];
+      }
+    }
+
+
+  /// <summary>
+  /// acc[i] += a * b[i] for i in [0, n), rounded the same way as multiply_accumulate.
+  /// </summary>
+  template <typename R, typename A, typename B>
+  void multiply_accumulate_scalar(const A& a, const B* b, R* acc, size_t n)
+    {
+    size_t done = 0;
+#if defined(MATRIX_PROCESSING_X86)
+    if constexpr (Detail::is_vectorizable<R, A, B>)
+      {
+      const R a_promoted = static_cast<R>(a);
+      switch (active_instruction_set())
+        {
+        case InstructionSet::AVX512: done = Detail::AVX512::multiply_accumulate_scalar(a_promoted, b, acc, n); break;
+        case InstructionSet::AVX2:   done = Detail::AVX2::multiply_accumulate_scalar(a_promoted, b, acc, n); break;
+        case InstructionSet::SSE2:   done = Detail::SSE2::multiply_accumulate_scalar(a_promoted, b, acc, n); break;
+        default: break;
+        }
+      }
+#endif
+    for (size_t i = done; i < n; ++i)
+      {
+      acc[i] += a * b[i];
+      }
+    }
+
+
+  /// <summary>
+  /// Dot products are summed in this many interleaved partial sums, the lanes of one 256-bit register of R.
+  /// </summary>
+  template <typename R>
+  constexpr size_t dot_lane_count = sizeof(R) < 32 ? 32 / sizeof(R) : 1;
+
+  namespace Detail {
+
+    // Scalar definition of the partial sums every dot_lanes kernel must reproduce
+    template <typename R, typename A, typename B>
+    size_t dot_lanes_scalar(const A* a, const B* x, R* lanes, size_t n)
+      {
+      constexpr size_t L = dot_lane_count<R>;
+      for (size_t l = 0; l < L; ++l)
+        {
+        lanes[l] = R(0);
+        }
+      size_t i = 0;
+      for (; i + L <= n; i += L)
+        {
+        for (size_t l = 0; l < L; ++l)
+          {
+          lanes[l] += a[i + l] * x[i + l];
+          }
+        }
+      return i;
+      }
+
+    // Partial sums of four rows, or of one when Rows is 1; returns how many elements of each row they cover
+    template <size_t Rows, typename R, typename A, typename B>
+    size_t dot_lanes(const A* a, size_t rsa, const B* x, R* lanes, size_t n)
+      {
+#if defined(MATRIX_PROCESSING_X86)
+      if constexpr (is_vectorizable<R, A, B>)
+        {
+        switch (Simd::active_instruction_set())
+          {
+          case InstructionSet::AVX512:
+          case InstructionSet::AVX2:
+            return Rows == 4 ? AVX2::dot_lanes4(a, rsa, x, lanes, n) : AVX2::dot_lanes1(a, x, lanes, n);
+          case InstructionSet::SSE2:
+            return Rows == 4 ? SSE2::dot_lanes4(a, rsa, x, lanes, n) : SSE2::dot_lanes1(a, x, lanes, n);
+          default: break;
+          }
+        }
+#endif
+      size_t done = 0;
+      for (size_t r = 0; r < Rows; ++r)
+        {
+        done = dot_lanes_scalar(a + r * rsa, x, lanes + r * dot_lane_count<R>, n);
+        }
+      return done;
+      }
+
+    // Lanes are folded in halves, as a register is reduced, then the rest of the row is added in order
+    template <typename R, typename A, typename B>
+    R finish_dot(R* lanes, size_t done, const A* a, const B* x, size_t n)
+      {
+      for (size_t half = dot_lane_count<R> / 2; half > 0; half /= 2)
+        {
+        for (size_t l = 0; l < half; ++l)
+          {
+          lanes[l] += lanes[l + half];
+          }
+        }
+      R sum = lanes[0];
+      for (size_t i = done; i < n; ++i)
+        {
+        sum += a[i] * x[i];
+        }
+      return sum;
+      }
+
+    }
+
+
+  /// <summary>
+  /// out[r] = sum of a[r * rsa + i] * x[i] over i in [0, n) for r in [0, n_rows), i.e. rows of matrix times vector.
+  /// Rows are taken four at a time, so every loaded element of x serves four of them. Each row is summed in
+  /// dot_lane_count<R> interleaved partial sums, which are folded in halves, and the last n % dot_lane_count<R>
+  /// products are added in order. Every instruction set computes exactly that, so results depend neither on the CPU
+  /// nor on how rows are grouped. out must not overlap x or the rows.
+  /// </summary>
+  template <typename R, typename A, typename B>
+  void dot_rows(const A* a, size_t rsa, size_t n_rows, const B* x, R* out, size_t n)
+    {
+    constexpr size_t L = dot_lane_count<R>;
+    R lanes[4 * L];
+    size_t r = 0;
+    for (; r + 4 <= n_rows; r += 4)
+      {
+      const A* rows = a + r * rsa;
+      const size_t done = Detail::dot_lanes<4>(rows, rsa, x, lanes, n);
+      for (size_t q = 0; q < 4; ++q)
+        {
+        out[r + q] = Detail::finish_dot(lanes + q * L, done, rows + q * rsa, x, n);
+        }
+      }
+    for (; r < n_rows; ++r)
+      {
+      const size_t done = Detail::dot_lanes<1>(a + r * rsa, rsa, x, lanes, n);
+      out[r] = Detail::finish_dot(lanes, done, a + r * rsa, x, n);
+      }
+    }
+
+  } }
@@ -0,0 +1,313 @@
+/*
+
+This class represents compressed sparse Matrix stored by rows (CSR) or by columns (CSC)
+
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "IMatrixProcessor.h"
+#include "Matrix.h"
+
+
+enum class SparseLayout { CSR, CSC };
+
+
+/// <summary>
+/// Only nonzero elements are stored. With CSR layout the nonzeros of row i, counted from 0, are
+/// values[offsets[i] .. offsets[i + 1]) and their columns are indices[offsets[i] .. offsets[i + 1]),
+/// sorted in ascending order. CSC is the same with rows and columns swapped.
+/// </summary>
+template <typename T, size_t R, size_t C, SparseLayout L = SparseLayout::CSR>
+class SparseMatrix
+  {
+  public:
+
+  using value_type = T;
+  using index_type = uint32_t;
+
+  static constexpr SparseLayout layout = L;
+
+  // number of compressed rows (CSR) or columns (CSC) and length of each of them
+  static constexpr size_t n_outer = L == SparseLayout::CSR ? R : C;
+  static constexpr size_t n_inner = L == SparseLayout::CSR ? C : R;
+
+  protected:
+
+  std::vector<T> m_values;
+  std::vector<index_type> m_indices;
+  std::vector<size_t> m_offsets;
+
+
+  public:
+
+  SparseMatrix();
+
+  /// <summary>
+  /// Takes compressed arrays as described above, throws std::invalid_argument if they are inconsistent.
+  /// </summary>
+  SparseMatrix(std::vector<size_t> offsets, std::vector<index_type> indices, std::vector<T> values);
+
+  /// <summary>
+  /// Keeps nonzero elements of the dense matrix.
+  /// </summary>
+  template <typename A>
+  explicit SparseMatrix(const Matrix<T, R, C, A>& mat);
+
+  SparseMatrix(const SparseMatrix<T, R, C, L>&) = default;
+  SparseMatrix(SparseMatrix<T, R, C, L>&&) = default;
+  ~SparseMatrix() = default;
+
+  SparseMatrix& operator=(const SparseMatrix&) = default;
+  SparseMatrix& operator=(SparseMatrix&&) = default;
+
+  static constexpr size_t get_n_rows() { return R; }
+  static constexpr size_t get_n_cols() { return C; }
+  size_t get_n_nonzeros() const;
+
+  const std::vector<T>& get_values() const;
+  const std::vector<index_type>& get_indices() const;
+  const std::vector<size_t>& get_offsets() const;
+
+  /// <summary>
+  /// Element (row, col), zero if it is not stored. Indices start from 1 as in Matrix::at.
+  /// </summary>
+  T at(size_t row, size_t col) const;
+
+  Matrix<T, R, C> to_dense() const;
+
+  /// <summary>
+  /// Same matrix compressed the other way, CSR to CSC or CSC to CSR.
+  /// </summary>
+  template <SparseLayout L2>
+  SparseMatrix<T, R, C, L2> to_layout() const;
+
+  template <typename U, size_t V, size_t X, SparseLayout M>
+  friend std::ostream& operator<< (std::ostream& o, const SparseMatrix<U, V, X, M>& mat);
+
+  template <typename U, size_t V, size_t X, SparseLayout M>
+  friend bool operator== (const SparseMatrix<U, V, X, M>& mat1, const SparseMatrix<U, V, X, M>& mat2);
+
+  template <typename U, size_t V, size_t X, SparseLayout M>
+  friend bool operator!= (const SparseMatrix<U, V, X, M>& mat1, const SparseMatrix<U, V, X, M>& mat2);
+
+  template <typename P, typename U, size_t V, size_t X, typename B>
+  auto BinaryOperation(const IMatrixProcessor<P>& imp, const Matrix<U, V, X, B>& mat) const;
+  };
+
+
+template <typename T, size_t R, size_t C>
+using CsrMatrix = SparseMatrix<T, R, C, SparseLayout::CSR>;
+
+template <typename T, size_t R, size_t C>
+using CscMatrix = SparseMatrix<T, R, C, SparseLayout::CSC>;
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+SparseMatrix<T, R, C, L>::SparseMatrix()
+  : m_offsets(n_outer + 1, 0)
+  {
+  static_assert(R * C > 0);
+  static_assert(n_inner <= UINT32_MAX, "Sparse matrix is too big for 32-bit indices");
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+SparseMatrix<T, R, C, L>::SparseMatrix(std::vector<size_t> offsets, std::vector<index_type> indices, std::vector<T> values)
+  : m_values(std::move(values)), m_indices(std::move(indices)), m_offsets(std::move(offsets))
+  {
+  static_assert(R * C > 0);
+  static_assert(n_inner <= UINT32_MAX, "Sparse matrix is too big for 32-bit indices");
+
+  if (m_offsets.size() != n_outer + 1 || m_offsets.front() != 0 || m_offsets.back() != m_values.size() || m_indices.size() != m_values.size())
+    {
+    throw std::invalid_argument("Sizes of compressed arrays don`t match shape of the sparse matrix");
+    }
+  for (size_t outer = 0; outer < n_outer; ++outer)
+    {
+    if (m_offsets[outer] > m_offsets[outer + 1])
+      {
+      throw std::invalid_argument("Offsets of the sparse matrix are not ascending");
+      }
+    for (size_t i = m_offsets[outer]; i < m_offsets[outer + 1]; ++i)
+      {
+      if (m_indices[i] >= n_inner || (i > m_offsets[outer] && m_indices[i] <= m_indices[i - 1]))
+        {
+        throw std::invalid_argument("Indices of the sparse matrix are out of range or not ascending");
+        }
+      }
+    }
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+template <typename A>
+SparseMatrix<T, R, C, L>::SparseMatrix(const Matrix<T, R, C, A>& mat)
+  : SparseMatrix()
+  {
+  const T* data = mat.data();
+  const size_t outer_stride = L == SparseLayout::CSR ? C : 1;
+  const size_t inner_stride = L == SparseLayout::CSR ? 1 : C;
+
+  for (size_t outer = 0; outer < n_outer; ++outer)
+    {
+    for (size_t inner = 0; inner < n_inner; ++inner)
+      {
+      const T& elem = data[outer * outer_stride + inner * inner_stride];
+      if (elem != T(0))
+        {
+        m_values.push_back(elem);
+        m_indices.push_back(static_cast<index_type>(inner));
+        }
+      }
+    m_offsets[outer + 1] = m_values.size();
+    }
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+size_t SparseMatrix<T, R, C, L>::get_n_nonzeros() const
+  {
+  return m_values.size();
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+const std::vector<T>& SparseMatrix<T, R, C, L>::get_values() const
+  {
+  return m_values;
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+const std::vector<typename SparseMatrix<T, R, C, L>::index_type>& SparseMatrix<T, R, C, L>::get_indices() const
+  {
+  return m_indices;
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+const std::vector<size_t>& SparseMatrix<T, R, C, L>::get_offsets() const
+  {
+  return m_offsets;
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+T SparseMatrix<T, R, C, L>::at(size_t row, size_t col) const
+  {
+  if (row == 0 || row > R || col == 0 || col > C)
+    {
+    throw std::out_of_range("Index is out of matrix bounds");
+    }
+  const size_t outer = (L == SparseLayout::CSR ? row : col) - 1;
+  const size_t inner = (L == SparseLayout::CSR ? col : row) - 1;
+
+  const auto first = m_indices.begin() + m_offsets[outer];
+  const auto last = m_indices.begin() + m_offsets[outer + 1];
+  const auto found = std::lower_bound(first, last, inner);
+  return found != last && *found == inner ? m_values[found - m_indices.begin()] : T(0);
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+Matrix<T, R, C> SparseMatrix<T, R, C, L>::to_dense() const
+  {
+  Matrix<T, R, C> result;
+  T* data = result.data();
+  std::fill(data, data + R * C, T(0));
+
+  const size_t outer_stride = L == SparseLayout::CSR ? C : 1;
+  const size_t inner_stride = L == SparseLayout::CSR ? 1 : C;
+  for (size_t outer = 0; outer < n_outer; ++outer)
+    {
+    for (size_t i = m_offsets[outer]; i < m_offsets[outer + 1]; ++i)
+      {
+      data[outer * outer_stride + m_indices[i] * inner_stride] = m_values[i];
+      }
+    }
+  return result;
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+template <SparseLayout L2>
+SparseMatrix<T, R, C, L2> SparseMatrix<T, R, C, L>::to_layout() const
+  {
+  if constexpr (L2 == L)
+    {
+    return *this;
+    }
+  else
+    {
+    // counting sort by inner index, walking outer indices in order keeps every new row/column sorted
+    constexpr size_t n_outer2 = SparseMatrix<T, R, C, L2>::n_outer;
+    std::vector<size_t> offsets(n_outer2 + 1, 0);
+    for (const index_type index : m_indices)
+      {
+      ++offsets[index + 1];
+      }
+    for (size_t outer2 = 0; outer2 < n_outer2; ++outer2)
+      {
+      offsets[outer2 + 1] += offsets[outer2];
+      }
+
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    std::vector<index_type> indices(m_values.size());
+    std::vector<T> values(m_values.size());
+    for (size_t outer = 0; outer < n_outer; ++outer)
+      {
+      for (size_t i = m_offsets[outer]; i < m_offsets[outer + 1]; ++i)
+        {
+        const size_t position = next[m_indices[i]]++;
+        indices[position] = static_cast<index_type>(outer);
+        values[position] = m_values[i];
+        }
+      }
+    return SparseMatrix<T, R, C, L2>(std::move(offsets), std::move(indices), std::move(values));
+    }
+  }
+
+
+template <typename U, size_t V, size_t X, SparseLayout M>
+std::ostream& operator<< (std::ostream& o, const SparseMatrix<U, V, X, M>& mat)
+  {
+  for (size_t row = 1; row <= V; ++row)
+    {
+    o << "| ";
+    for (size_t col = 1; col <= X; ++col)
+      {
+      o << mat.at(row, col) << " ";
+      }
+    o << "|\n";
+    }
+  return o;
+  }
+
+
+template <typename U, size_t V, size_t X, SparseLayout M>
+bool operator== (const SparseMatrix<U, V, X, M>& mat1, const SparseMatrix<U, V, X, M>& mat2)
+  {
+  return mat1.m_offsets == mat2.m_offsets && mat1.m_indices == mat2.m_indices && mat1.m_values == mat2.m_values;
+  }
+
+
+template <typename U, size_t V, size_t X, SparseLayout M>
+bool operator!= (const SparseMatrix<U, V, X, M>& mat1, const SparseMatrix<U, V, X, M>& mat2)
+  {
+  return !(mat1 == mat2);
+  }
+
+
+template <typename T, size_t R, size_t C, SparseLayout L>
+template <typename P, typename U, size_t V, size_t X, typename B>
+auto SparseMatrix<T, R, C, L>::BinaryOperation(const IMatrixProcessor<P>& imp, const Matrix<U, V, X, B>& mat) const
+  {
+  return imp.perform_operation(*this, mat);
+  }
@@ -0,0 +1,71 @@
+/*
+
+This class represents random access iterator over elements lying at constant distance from each other
+
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+
+/// <summary>
+/// Walks every stride-th element starting from the given one, e.g. a column of row-major matrix
+/// with stride equal to the number of columns. T is const for read-only iteration.
+/// Nothing is checked, the iterator is as fast as pointer arithmetic.
+/// </summary>
+template <typename T>
+class StridedIterator
+  {
+  // position is kept as an index, so the end iterator of a column never points past the end of the matrix
+  T* m_first = nullptr;
+  std::ptrdiff_t m_stride = 1;
+  std::ptrdiff_t m_index = 0;
+
+  public:
+
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = std::remove_const_t<T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = T*;
+  using reference = T&;
+
+  constexpr StridedIterator() = default;
+  constexpr StridedIterator(T* first, std::ptrdiff_t stride, std::ptrdiff_t index = 0) : m_first(first), m_stride(stride), m_index(index) {}
+
+  // writable iterator converts to read-only one
+  template <typename U, std::enable_if_t<std::is_same_v<const U, T>>* = nullptr>
+  constexpr StridedIterator(const StridedIterator<U>& it) : m_first(it.first()), m_stride(it.stride()), m_index(it.index()) {}
+
+  constexpr T* first() const { return m_first; }
+  constexpr std::ptrdiff_t stride() const { return m_stride; }
+  constexpr std::ptrdiff_t index() const { return m_index; }
+
+  constexpr T& operator*() const { return m_first[m_index * m_stride]; }
+  constexpr T* operator->() const { return m_first + m_index * m_stride; }
+  constexpr T& operator[](difference_type n) const { return m_first[(m_index + n) * m_stride]; }
+
+  constexpr StridedIterator& operator++() { ++m_index; return *this; }
+  constexpr StridedIterator& operator--() { --m_index; return *this; }
+  constexpr StridedIterator operator++(int) { StridedIterator old = *this; ++m_index; return old; }
+  constexpr StridedIterator operator--(int) { StridedIterator old = *this; --m_index; return old; }
+
+  constexpr StridedIterator& operator+=(difference_type n) { m_index += n; return *this; }
+  constexpr StridedIterator& operator-=(difference_type n) { m_index -= n; return *this; }
+
+  friend constexpr StridedIterator operator+(StridedIterator it, difference_type n) { return it += n; }
+  friend constexpr StridedIterator operator+(difference_type n, StridedIterator it) { return it += n; }
+  friend constexpr StridedIterator operator-(StridedIterator it, difference_type n) { return it -= n; }
+
+  // comparisons are meaningful only for iterators over the same elements
+  friend constexpr difference_type operator-(const StridedIterator& lhs, const StridedIterator& rhs) { return lhs.m_index - rhs.m_index; }
+
+  friend constexpr bool operator==(const StridedIterator& lhs, const StridedIterator& rhs) { return lhs.m_index == rhs.m_index; }
+  friend constexpr bool operator!=(const StridedIterator& lhs, const StridedIterator& rhs) { return lhs.m_index != rhs.m_index; }
+  friend constexpr bool operator<(const StridedIterator& lhs, const StridedIterator& rhs) { return lhs.m_index < rhs.m_index; }
+  friend constexpr bool operator>(const StridedIterator& lhs, const StridedIterator& rhs) { return lhs.m_index > rhs.m_index; }
+  friend constexpr bool operator<=(const StridedIterator& lhs, const StridedIterator& rhs) { return lhs.m_index <= rhs.m_index; }
+  friend constexpr bool operator>=(const StridedIterator& lhs, const StridedIterator& rhs) { return lhs.m_index >= rhs.m_index; }
+  };
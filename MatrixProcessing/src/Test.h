@@ -1,10 +1,26 @@
 #pragma once
 
 #include <cassert>
+#include <cmath>
+#include <numeric>
+#include <functional>
+#include <algorithm>
+#include <sstream>
 #include "Matrix.h"
 #include "MatrixVectRow.h"
 #include "MatrixVectCol.h"
+#include "DynamicMatrix.h"
+#include "MatrixBatch.h"
+#include "TransposedView.h"
+#include "MatrixView.h"
+#include "MatrixFile.h"
+#include "MatrixText.h"
+#include "HalfFloat.h"
+#include "Quantization.h"
+#include "SparseMatrix.h"
+#include "Instrumentation.h"
 #include "MatrixProcessors.h"
+#include "MatrixExpression.h"
 
 /// <summary>
 /// Contains tests for Matrices and Matrix Processors
@@ -28,6 +44,32 @@ namespace Tests {
   void test_multiply_mat_int_3_3_mat_int_3_2();
   void test_multiply_mat_int_3_4_mat_int_4_1();
   void test_multiply_mat_int_4_4_mat_float_4_4();
+  void test_multiply_mat_float_37_300_mat_float_300_41();
+  void test_multiply_mat_int_67_45_mat_double_45_101();
+  void test_elementwise_kernels_every_instruction_set();
+  void test_lazy_expression_mat_int_mat_double_scalars();
+  void test_small_matrix_inline_storage();
+  void test_large_matrix_aligned_storage();
+  void test_dynamic_matrix_operations();
+  void test_dynamic_matrix_fixed_matrix_interop();
+  void test_parallel_policy_matches_serial();
+  void test_perform_operation_into_existing_matrix();
+  void test_matrix_batch_matches_single_matrices();
+  void test_strassen_multiply_accuracy();
+  void test_transpose_and_transposed_view();
+  void test_matrix_views_as_operands_and_outputs();
+  void test_binary_file_write_and_map();
+  void test_out_of_core_multiply();
+  void test_sparse_matrix_multiply();
+  void test_instrumentation_counters();
+  void test_constexpr_matrix_operations();
+  void test_unrolled_small_products();
+  void test_unchecked_access_and_iterators();
+  void test_text_write_and_parse();
+  void test_reduced_precision_and_quantized_products();
+  void test_fused_multiply_add();
+  void test_matrix_vector_products();
+  void test_outer_product_and_rank_one_update();
 
   void run_all_automatic_tests()
     {
@@ -49,6 +91,32 @@ namespace Tests {
     test_multiply_mat_int_3_3_mat_int_3_2();
     test_multiply_mat_int_3_4_mat_int_4_1();
     test_multiply_mat_int_4_4_mat_float_4_4();
+    test_multiply_mat_float_37_300_mat_float_300_41();
+    test_multiply_mat_int_67_45_mat_double_45_101();
+    test_elementwise_kernels_every_instruction_set();
+    test_lazy_expression_mat_int_mat_double_scalars();
+    test_small_matrix_inline_storage();
+    test_large_matrix_aligned_storage();
+    test_dynamic_matrix_operations();
+    test_dynamic_matrix_fixed_matrix_interop();
+    test_parallel_policy_matches_serial();
+    test_perform_operation_into_existing_matrix();
+    test_matrix_batch_matches_single_matrices();
+    test_strassen_multiply_accuracy();
+    test_transpose_and_transposed_view();
+    test_matrix_views_as_operands_and_outputs();
+    test_binary_file_write_and_map();
+    test_out_of_core_multiply();
+    test_sparse_matrix_multiply();
+    test_instrumentation_counters();
+    test_constexpr_matrix_operations();
+    test_unrolled_small_products();
+    test_unchecked_access_and_iterators();
+    test_text_write_and_parse();
+    test_reduced_precision_and_quantized_products();
+    test_fused_multiply_add();
+    test_matrix_vector_products();
+    test_outer_product_and_rank_one_update();
     }
 
 
@@ -506,5 +574,1412 @@ namespace Tests {
     std::cout << "\n";
     }
 
-  }
 
+
+  void test_multiply_mat_float_37_300_mat_float_300_41()
+    {
+    std::cout << " >>> test_multiply_mat_float_37_300_mat_float_300_41()\t";
+    std::vector<float> lhs_data(37 * 300);
+    std::vector<float> rhs_data(300 * 41);
+    for (size_t i = 0; i < lhs_data.size(); ++i) { lhs_data[i] = float(int(i * 7 % 11) - 5); }
+    for (size_t i = 0; i < rhs_data.size(); ++i) { rhs_data[i] = float(int(i * 5 % 13) - 6); }
+
+    std::vector<float> expected_data(37 * 41, 0);
+    for (size_t i = 0; i < 37; ++i)
+      for (size_t k = 0; k < 300; ++k)
+        for (size_t j = 0; j < 41; ++j)
+          expected_data[i * 41 + j] += lhs_data[i * 300 + k] * rhs_data[k * 41 + j];
+
+    const Matrix<float, 37, 300> mat_float1(lhs_data);
+    const Matrix<float, 300, 41> mat_float2(rhs_data);
+
+    auto mat_result = mat_float1.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_float2);
+
+    Matrix<float, 37, 41> expected_result(expected_data);
+
+    // the portable and the AVX2 micro-kernels are both reachable whatever the build flags
+    bool every_kernel = true;
+    for (MatrixProcessors::Simd::InstructionSet isa : { MatrixProcessors::Simd::InstructionSet::SSE2, MatrixProcessors::Simd::InstructionSet::AVX2 })
+      {
+      MatrixProcessors::Simd::force_instruction_set(isa);
+      every_kernel = every_kernel && mat_float1.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_float2) == expected_result;
+      }
+    MatrixProcessors::Simd::force_instruction_set(MatrixProcessors::Simd::detect_instruction_set());
+
+    expected_result != mat_result || !every_kernel ? std::cout << "...FAILED !!!" : std::cout << "...PASSED";
+    std::cout << "\n";
+    }
+
+
+
+  void test_multiply_mat_int_67_45_mat_double_45_101()
+    {
+    std::cout << " >>> test_multiply_mat_int_67_45_mat_double_45_101()\t";
+    std::vector<int> lhs_data(67 * 45);
+    std::vector<double> rhs_data(45 * 101);
+    for (size_t i = 0; i < lhs_data.size(); ++i) { lhs_data[i] = int(i * 3 % 17) - 8; }
+    for (size_t i = 0; i < rhs_data.size(); ++i) { rhs_data[i] = (int(i * 5 % 13) - 6) * 0.5; }
+
+    std::vector<double> expected_data(67 * 101, 0);
+    for (size_t i = 0; i < 67; ++i)
+      for (size_t k = 0; k < 45; ++k)
+        for (size_t j = 0; j < 101; ++j)
+          expected_data[i * 101 + j] += lhs_data[i * 45 + k] * rhs_data[k * 101 + j];
+
+    const Matrix<int, 67, 45> mat_int(lhs_data);
+    const Matrix<double, 45, 101> mat_double(rhs_data);
+
+    auto mat_result = mat_int.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_double);
+
+    Matrix<double, 67, 101> expected_result(expected_data);
+
+    // the portable and the AVX2 micro-kernels are both reachable whatever the build flags
+    bool every_kernel = true;
+    for (MatrixProcessors::Simd::InstructionSet isa : { MatrixProcessors::Simd::InstructionSet::SSE2, MatrixProcessors::Simd::InstructionSet::AVX2 })
+      {
+      MatrixProcessors::Simd::force_instruction_set(isa);
+      every_kernel = every_kernel && mat_int.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_double) == expected_result;
+      }
+    MatrixProcessors::Simd::force_instruction_set(MatrixProcessors::Simd::detect_instruction_set());
+
+    expected_result != mat_result || !every_kernel ? std::cout << "...FAILED !!!" : std::cout << "...PASSED";
+    std::cout << "\n";
+    }
+
+
+
+  void test_elementwise_kernels_every_instruction_set()
+    {
+    std::cout << " >>> test_elementwise_kernels_every_instruction_set()\t";
+    using MatrixProcessors::Simd::InstructionSet;
+
+    std::vector<int> int_data(7 * 13);
+    std::vector<float> float_data(7 * 13);
+    for (size_t i = 0; i < int_data.size(); ++i)
+      {
+      int_data[i] = int(i * 7 % 23) - 11;
+      float_data[i] = float(int(i * 5 % 19) - 9) * 0.25f;
+      }
+
+    const Matrix<int, 7, 13> mat_int(int_data);
+    const Matrix<float, 7, 13> mat_float(float_data);
+
+    std::vector<double> sum_scalar(int_data.size());
+    std::vector<int> product_scalar(int_data.size());
+    std::vector<float> difference_scalar(int_data.size());
+    std::vector<float> sum_matrix(int_data.size());
+    for (size_t i = 0; i < int_data.size(); ++i)
+      {
+      sum_scalar[i] = int_data[i] + 10.5;
+      product_scalar[i] = int_data[i] * -3;
+      difference_scalar[i] = float_data[i] - 2;
+      sum_matrix[i] = int_data[i] + float_data[i];
+      }
+
+    int test_number = 0;
+    for (InstructionSet isa : { InstructionSet::Scalar, InstructionSet::SSE2, InstructionSet::AVX2, InstructionSet::AVX512 })
+      {
+      MatrixProcessors::Simd::force_instruction_set(isa);
+      bool passed = Matrix<double, 7, 13>(sum_scalar) == mat_int.UnaryOperation(MatrixProcessors::AddScalar{}, 10.5)
+                 && Matrix<int, 7, 13>(product_scalar) == mat_int.UnaryOperation(MatrixProcessors::MultiplyScalar{}, -3)
+                 && Matrix<float, 7, 13>(difference_scalar) == mat_float.UnaryOperation(MatrixProcessors::SubtractScalar{}, 2)
+                 && Matrix<float, 7, 13>(sum_matrix) == mat_int.BinaryOperation(MatrixProcessors::AddMatrix{}, mat_float);
+
+      ++test_number;
+      passed ? std::cout << "...#" << test_number << " PASSED" : std::cout << "...#" << test_number << " FAILED !!!";
+      }
+    MatrixProcessors::Simd::force_instruction_set(MatrixProcessors::Simd::detect_instruction_set());
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_lazy_expression_mat_int_mat_double_scalars()
+    {
+    std::cout << " >>> test_lazy_expression_mat_int_mat_double_scalars()\t";
+    using MatrixExpressions::lazy;
+
+    const Matrix<int, 3, 3> mat_int({ 1, 2, 3,
+                                      4, 5, 6,
+                                      7, 8, 9 });
+
+    const Matrix<double, 3, 3> mat_double({ 0.5, 0.5, 0.5,
+                                            1.5, 1.5, 1.5,
+                                            2.5, 2.5, 2.5 });
+
+    Matrix<double, 3, 3> mat_result((lazy(mat_int) + mat_double) * 2 - 1);
+
+    Matrix<double, 3, 3> expected_result = { 2,  4,  6,
+                                             10, 12, 14,
+                                             18, 20, 22 };
+
+    expected_result != mat_result ? std::cout << "...#1 FAILED !!!" : std::cout << "...#1 PASSED";
+
+    auto eager_result = mat_int.BinaryOperation(MatrixProcessors::AddMatrix{}, mat_double)
+                               .UnaryOperation(MatrixProcessors::MultiplyScalar{}, 2)
+                               .UnaryOperation(MatrixProcessors::SubtractScalar{}, 1);
+
+    auto lazy_result = lazy(mat_int).BinaryOperation(MatrixProcessors::AddMatrix{}, mat_double)
+                                    .UnaryOperation(MatrixProcessors::MultiplyScalar{}, 2)
+                                    .UnaryOperation(MatrixProcessors::SubtractScalar{}, 1)
+                                    .evaluate();
+
+    eager_result != lazy_result ? std::cout << "...#2 FAILED !!!" : std::cout << "...#2 PASSED";
+
+    mat_result = lazy(mat_result) * 0.5;
+
+    Matrix<double, 3, 3> expected_result_in_place = { 1, 2,  3,
+                                                      5, 6,  7,
+                                                      9, 10, 11 };
+
+    expected_result_in_place != mat_result ? std::cout << "...#3 FAILED !!!" : std::cout << "...#3 PASSED";
+
+    // large expressions are evaluated by blocks on several threads, the last block is shorter
+    std::vector<int> big_int_data(301 * 307);
+    std::vector<double> big_double_data(301 * 307);
+    for (size_t i = 0; i < big_int_data.size(); ++i)
+      {
+      big_int_data[i] = int(i % 29) - 14;
+      big_double_data[i] = double(int(i % 13) - 6) * 0.25;
+      }
+    const Matrix<int, 301, 307> big_int(big_int_data);
+    const Matrix<double, 301, 307> big_double(big_double_data);
+    const auto big_eager = big_int.BinaryOperation(MatrixProcessors::AddMatrix{}, big_double)
+                                  .UnaryOperation(MatrixProcessors::MultiplyScalar{}, 2)
+                                  .UnaryOperation(MatrixProcessors::SubtractScalar{}, 1);
+    const auto big_parallel = ((lazy(big_int) + big_double) * 2 - 1).evaluate(ExecutionPolicy::parallel(4));
+    const Matrix<double, 301, 307> big_serial((lazy(big_int) + big_double) * 2 - 1);
+    MatrixProcessors::Simd::force_instruction_set(MatrixProcessors::Simd::InstructionSet::SSE2);
+    const auto big_sse2 = ((lazy(big_int) + big_double) * 2 - 1).evaluate();
+    MatrixProcessors::Simd::force_instruction_set(MatrixProcessors::Simd::detect_instruction_set());
+    big_eager == big_parallel && big_eager == big_serial && big_eager == big_sse2 ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_small_matrix_inline_storage()
+    {
+    std::cout << " >>> test_small_matrix_inline_storage()\t\t\t";
+    const Matrix<float, 4, 4> mat_float({ 1, 0, 0, 1,
+                                          0, 1, 0, 2,
+                                          0, 0, 1, 3,
+                                          0, 0, 0, 1 });
+
+    const MatrixVectCol<float, 4> vec_c({ 1, 1, 1, 1 });
+
+    auto mat_result = mat_float.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_float);
+    auto vec_result = mat_float.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, vec_c);
+
+    std::is_same_v<decltype(mat_result)::storage_type, InlineStorage<float, 16>> ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+    std::is_same_v<decltype(vec_result)::storage_type, InlineStorage<float, 4>> ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+    std::is_same_v<Matrix<double, 64, 64>::storage_type, std::vector<double, AlignedAllocator<double>>> ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    Matrix<float, 4, 4> expected_mat_result = { 1, 0, 0, 2,
+                                                0, 1, 0, 4,
+                                                0, 0, 1, 6,
+                                                0, 0, 0, 1 };
+
+    Matrix<float, 4, 1> expected_vec_result = { 2, 3, 4, 1 };
+
+    expected_mat_result != mat_result ? std::cout << "...#4 FAILED !!!" : std::cout << "...#4 PASSED";
+    expected_vec_result != vec_result ? std::cout << "...#5 FAILED !!!" : std::cout << "...#5 PASSED";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_large_matrix_aligned_storage()
+    {
+    std::cout << " >>> test_large_matrix_aligned_storage()\t\t\t";
+    const Matrix<int, 9, 11> mat_int(std::vector<int, AlignedAllocator<int>>(9 * 11, 2));
+    const Matrix<float, 11, 9, AlignedAllocator<float, 128>> mat_float(std::vector<float, AlignedAllocator<float, 128>>(11 * 9, 0.5f));
+
+    auto sum_result = mat_int.UnaryOperation(MatrixProcessors::AddScalar{}, 0.5);
+    auto product_result = mat_float.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_int);
+
+    reinterpret_cast<uintptr_t>(mat_int.data()) % 64 == 0 ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+    reinterpret_cast<uintptr_t>(mat_float.data()) % 128 == 0 ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+    reinterpret_cast<uintptr_t>(sum_result.data()) % 64 == 0 ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+    std::is_same_v<decltype(product_result)::allocator_type, AlignedAllocator<float, 128>> ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    Matrix<double, 9, 11> expected_sum_result(std::vector<double, AlignedAllocator<double>>(9 * 11, 2.5));
+    Matrix<float, 11, 11, AlignedAllocator<float, 128>> expected_product_result(std::vector<float, AlignedAllocator<float, 128>>(11 * 11, 9.0f));
+
+    expected_sum_result != sum_result ? std::cout << "...#5 FAILED !!!" : std::cout << "...#5 PASSED";
+    expected_product_result != product_result ? std::cout << "...#6 FAILED !!!" : std::cout << "...#6 PASSED";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_dynamic_matrix_operations()
+    {
+    std::cout << " >>> test_dynamic_matrix_operations()\t\t\t";
+    const DynamicMatrix<int> mat_int(3, 3, { 1, 2, 3,
+                                             4, 5, 6,
+                                             7, 8, 9 });
+
+    const DynamicMatrix<double> mat_double(3, 2, { 1, 4,
+                                                   2, 5,
+                                                   3, 6.5 });
+
+    auto product_result = mat_int.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_double);
+    auto sum_result = mat_int.UnaryOperation(MatrixProcessors::AddScalar{}, 0.5)
+                             .BinaryOperation(MatrixProcessors::AddMatrix{}, mat_int);
+
+    DynamicMatrix<double> expected_product_result(3, 2, { 14, 33.5,
+                                                          32, 80,
+                                                          50, 126.5 });
+
+    DynamicMatrix<double> expected_sum_result(3, 3, { 2.5,  4.5,  6.5,
+                                                      8.5,  10.5, 12.5,
+                                                      14.5, 16.5, 18.5 });
+
+    expected_product_result != product_result ? std::cout << "...#1 FAILED !!!" : std::cout << "...#1 PASSED";
+    expected_sum_result != sum_result ? std::cout << "...#2 FAILED !!!" : std::cout << "...#2 PASSED";
+
+    try
+      {
+      mat_double.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_int);
+      std::cout << "...#3 FAILED !!!";
+      }
+    catch (const std::length_error&)
+      {
+      std::cout << "...#3 PASSED";
+      }
+
+    try
+      {
+      mat_double.BinaryOperation(MatrixProcessors::AddMatrix{}, mat_int);
+      std::cout << "...#4 FAILED !!!";
+      }
+    catch (const std::length_error&)
+      {
+      std::cout << "...#4 PASSED";
+      }
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_dynamic_matrix_fixed_matrix_interop()
+    {
+    std::cout << " >>> test_dynamic_matrix_fixed_matrix_interop()\t\t";
+    std::vector<double> data(20 * 30);
+    for (size_t i = 0; i < data.size(); ++i) { data[i] = double(i); }
+
+    Matrix<double, 20, 30> mat_fixed(data);
+    const double* buffer = mat_fixed.data();
+
+    DynamicMatrix<double> mat_dynamic(std::move(mat_fixed));
+    buffer == mat_dynamic.data() ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+    29.0 == mat_dynamic.at(1, 30) && 30.0 == mat_dynamic.at(2, 1) ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    auto mat_back = std::move(mat_dynamic).to_fixed<20, 30>();
+    buffer == mat_back.data() ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+    Matrix<double, 20, 30>(data) == mat_back ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    try
+      {
+      DynamicMatrix<double>(mat_back).to_fixed<30, 20>();
+      std::cout << "...#5 FAILED !!!";
+      }
+    catch (const std::length_error&)
+      {
+      std::cout << "...#5 PASSED";
+      }
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_parallel_policy_matches_serial()
+    {
+    std::cout << " >>> test_parallel_policy_matches_serial()\t\t";
+    std::vector<float> lhs_data(300 * 280);
+    std::vector<double> rhs_data(280 * 260);
+    for (size_t i = 0; i < lhs_data.size(); ++i) { lhs_data[i] = 1.0f / float(i % 97 + 1); }
+    for (size_t i = 0; i < rhs_data.size(); ++i) { rhs_data[i] = 1.0 / double(i % 89 + 1); }
+
+    const Matrix<float, 300, 280> mat_float(lhs_data);
+    const Matrix<double, 280, 260> mat_double(rhs_data);
+    const DynamicMatrix<float> dyn_float(300, 280, lhs_data);
+    const DynamicMatrix<double> dyn_double(280, 260, rhs_data);
+
+    const ExecutionPolicy serial = ExecutionPolicy::serial();
+    const ExecutionPolicy parallel = ExecutionPolicy::parallel(4);
+
+    auto serial_product = mat_float.BinaryOperation(MatrixProcessors::MultiplyMatrix{ serial }, mat_double);
+    auto parallel_product = mat_float.BinaryOperation(MatrixProcessors::MultiplyMatrix{ parallel }, mat_double);
+    serial_product == parallel_product ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    auto serial_scaled = mat_float.UnaryOperation(MatrixProcessors::MultiplyScalar{ serial }, 3.0);
+    auto parallel_scaled = mat_float.UnaryOperation(MatrixProcessors::MultiplyScalar{ parallel }, 3.0);
+    serial_scaled == parallel_scaled ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    auto serial_sum = serial_product.BinaryOperation(MatrixProcessors::AddMatrix{ serial }, serial_product);
+    auto parallel_sum = serial_product.BinaryOperation(MatrixProcessors::AddMatrix{ parallel }, serial_product);
+    serial_sum == parallel_sum ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    auto dyn_product = dyn_float.BinaryOperation(MatrixProcessors::MultiplyMatrix{ parallel }, dyn_double);
+    DynamicMatrix<double>(std::move(serial_product)) == dyn_product ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_perform_operation_into_existing_matrix()
+    {
+    std::cout << " >>> test_perform_operation_into_existing_matrix()\t\t";
+    std::vector<double> lhs_data(40 * 50);
+    std::vector<double> rhs_data(50 * 30);
+    for (size_t i = 0; i < lhs_data.size(); ++i) { lhs_data[i] = double(i % 13); }
+    for (size_t i = 0; i < rhs_data.size(); ++i) { rhs_data[i] = double(i % 7) - 3.0; }
+
+    const Matrix<double, 40, 50> mat_lhs(lhs_data);
+    const Matrix<double, 50, 30> mat_rhs(rhs_data);
+
+    Matrix<double, 40, 30> product;
+    product.at(1, 1) = 1000.0;
+    const double* buffer = product.data();
+    MatrixProcessors::MultiplyMatrix{}.perform_operation_into(mat_lhs, mat_rhs, product);
+    buffer == product.data() && product == mat_lhs.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_rhs) ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    Matrix<double, 40, 50> mat_acc(mat_lhs);
+    mat_acc += 1.5;
+    mat_acc *= 2.0;
+    mat_acc -= 3.0;
+    mat_acc += mat_lhs;
+    bool in_place_ok = true;
+    for (size_t i = 0; i < lhs_data.size(); ++i)
+      {
+      in_place_ok = in_place_ok && mat_acc.get_data()[i] == (lhs_data[i] + 1.5) * 2.0 - 3.0 + lhs_data[i];
+      }
+    in_place_ok ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    Matrix<int, 2, 2> mat_int({ 1, 2, 3, 4 });
+    MatrixProcessors::AddMatrix{}.perform_operation_into(mat_int, mat_int, mat_int);
+    mat_int == Matrix<int, 2, 2>({ 2, 4, 6, 8 }) ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    DynamicMatrix<double> dyn_square(30, 30, std::vector<double, AlignedAllocator<double>>(30 * 30, 1.0));
+    try
+      {
+      MatrixProcessors::MultiplyMatrix{}.perform_operation_into(dyn_square, dyn_square, dyn_square);
+      std::cout << "...#4 FAILED !!!";
+      }
+    catch (const std::invalid_argument&)
+      {
+      std::cout << "...#4 PASSED";
+      }
+
+    DynamicMatrix<double> dyn_wrong(3, 3);
+    try
+      {
+      MatrixProcessors::AddScalar{}.perform_operation_into(dyn_square, 1.0, dyn_wrong);
+      std::cout << "...#5 FAILED !!!";
+      }
+    catch (const std::length_error&)
+      {
+      std::cout << "...#5 PASSED";
+      }
+
+    dyn_square += 1.0;
+    dyn_square == DynamicMatrix<double>(30, 30, std::vector<double, AlignedAllocator<double>>(30 * 30, 2.0)) ? std::cout << "...#6 PASSED" : std::cout << "...#6 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_matrix_batch_matches_single_matrices()
+    {
+    std::cout << " >>> test_matrix_batch_matches_single_matrices()\t\t";
+    const size_t size = 1037;
+    std::vector<Matrix<float, 4, 4>> mats;
+    std::vector<Matrix<float, 4, 1>> vecs;
+    for (size_t b = 0; b < size; ++b)
+      {
+      std::vector<float> mat_data(16);
+      for (size_t e = 0; e < 16; ++e) { mat_data[e] = float((b * 7 + e * 3) % 23) / 8.0f; }
+      mats.emplace_back(mat_data);
+      vecs.emplace_back(std::vector<float>{ float(b % 5), 0.5f, -1.25f, float(b % 3) });
+      }
+
+    const MatrixBatch<float, 4, 4> batch_mats(mats);
+    const MatrixBatch<float, 4, 1> batch_vecs(vecs);
+
+    mats[17] == batch_mats.get(17) && mats[17].at(2, 3) == batch_mats.at(17, 2, 3) ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    auto batch_product = batch_mats.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, batch_vecs);
+    bool product_ok = true;
+    for (size_t b = 0; b < size; ++b)
+      {
+      product_ok = product_ok && batch_product.get(b) == mats[b].BinaryOperation(MatrixProcessors::MultiplyMatrix{}, vecs[b]);
+      }
+    product_ok ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    auto batch_scaled = batch_mats.UnaryOperation(MatrixProcessors::MultiplyScalar{}, 2.0);
+    auto batch_sum = batch_mats.BinaryOperation(MatrixProcessors::AddMatrix{}, batch_mats);
+    batch_scaled.get(500) == mats[500].UnaryOperation(MatrixProcessors::MultiplyScalar{}, 2.0)
+      && batch_sum.get(1036) == mats[1036].BinaryOperation(MatrixProcessors::AddMatrix{}, mats[1036]) ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    try
+      {
+      batch_mats.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, MatrixBatch<float, 4, 1>(size - 1));
+      std::cout << "...#4 FAILED !!!";
+      }
+    catch (const std::length_error&)
+      {
+      std::cout << "...#4 PASSED";
+      }
+
+    const MatrixBatch<Float16, 4, 4> half_batch(3);
+    half_batch.get_batch_size() == 3 && float(half_batch.at(2, 3, 3)) == 0.0f ? std::cout << "...#5 PASSED" : std::cout << "...#5 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  template <typename T>
+  T max_abs_difference(const DynamicMatrix<T>& mat1, const DynamicMatrix<T>& mat2)
+    {
+    T result = 0;
+    for (size_t i = 0; i < mat1.get_data().size(); ++i)
+      {
+      result = std::max(result, std::abs(mat1.get_data()[i] - mat2.get_data()[i]));
+      }
+    return result;
+    }
+
+
+  void test_strassen_multiply_accuracy()
+    {
+    std::cout << " >>> test_strassen_multiply_accuracy()\t\t";
+    const size_t m = 301;
+    const size_t k = 257;
+    const size_t n = 299;
+    std::vector<double> lhs_data(m * k);
+    std::vector<double> rhs_data(k * n);
+    for (size_t i = 0; i < lhs_data.size(); ++i) { lhs_data[i] = double(int(i * 7919 % 2001) - 1000) / 1000.0; }
+    for (size_t i = 0; i < rhs_data.size(); ++i) { rhs_data[i] = double(int(i * 104729 % 2001) - 1000) / 1000.0; }
+    std::vector<float> lhs_float(lhs_data.begin(), lhs_data.end());
+    std::vector<float> rhs_float(rhs_data.begin(), rhs_data.end());
+
+    // three levels with odd sizes peeled on every one of them
+    const MatrixProcessors::StrassenMultiplyMatrix strassen(32);
+
+    const DynamicMatrix<double> lhs_double(m, k, lhs_data);
+    const DynamicMatrix<double> rhs_double(k, n, rhs_data);
+    const double error_double = max_abs_difference(lhs_double.BinaryOperation(strassen, rhs_double),
+                                                   lhs_double.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, rhs_double));
+    error_double < double(k) * 2e-15 ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    const DynamicMatrix<float> lhs_single(m, k, lhs_float);
+    const DynamicMatrix<float> rhs_single(k, n, rhs_float);
+    const float error_float = max_abs_difference(lhs_single.BinaryOperation(strassen, rhs_single),
+                                                 lhs_single.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, rhs_single));
+    error_float < float(k) * 1e-6f ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    std::vector<int> int_data(71 * 71);
+    for (size_t i = 0; i < int_data.size(); ++i) { int_data[i] = int(i * 31 % 17) - 8; }
+    const Matrix<int, 71, 71> mat_int(int_data);
+    mat_int.BinaryOperation(MatrixProcessors::StrassenMultiplyMatrix(8), mat_int) == mat_int.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_int) ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_transpose_and_transposed_view()
+    {
+    std::cout << " >>> test_transpose_and_transposed_view()\t\t";
+    std::vector<double> data_a(90 * 70);
+    std::vector<double> data_b(90 * 50);
+    for (size_t i = 0; i < data_a.size(); ++i) { data_a[i] = double(i % 31) - 15.0; }
+    for (size_t i = 0; i < data_b.size(); ++i) { data_b[i] = double(i % 17) / 4.0; }
+
+    const Matrix<double, 90, 70> mat_a(data_a);
+    const Matrix<double, 90, 50> mat_b(data_b);
+
+    auto mat_a_t = mat_a.UnaryOperation(MatrixProcessors::Transpose{});
+    bool transpose_ok = true;
+    for (size_t row = 1; row <= 70; ++row)
+      {
+      for (size_t col = 1; col <= 90; ++col)
+        {
+        transpose_ok = transpose_ok && mat_a_t.at(row, col) == mat_a.at(col, row) && transposed(mat_a).at(row, col) == mat_a.at(col, row);
+        }
+      }
+    transpose_ok ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    auto product_view = MatrixProcessors::MultiplyMatrix{}.perform_operation(transposed(mat_a), mat_b);
+    product_view == mat_a_t.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_b) ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    const Matrix<double, 50, 90> mat_b_t = mat_b.UnaryOperation(MatrixProcessors::Transpose{});
+    auto product_rhs_view = MatrixProcessors::MultiplyMatrix{}.perform_operation(mat_a_t, transposed(mat_b_t));
+    auto product_both_views = MatrixProcessors::MultiplyMatrix{}.perform_operation(transposed(mat_a), transposed(mat_b_t));
+    product_rhs_view == product_view && product_both_views == product_view ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    std::vector<float> data_c(7 * 5);
+    for (size_t i = 0; i < data_c.size(); ++i) { data_c[i] = float(i); }
+    const Matrix<float, 7, 5> mat_c(data_c);
+    auto small_product = MatrixProcessors::MultiplyMatrix{}.perform_operation(transposed(mat_c), mat_c);
+    small_product == mat_c.UnaryOperation(MatrixProcessors::Transpose{}).BinaryOperation(MatrixProcessors::MultiplyMatrix{}, mat_c) ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    const DynamicMatrix<int> dyn(3, 2, { 1, 2, 3, 4, 5, 6 });
+    dyn.UnaryOperation(MatrixProcessors::Transpose{}) == DynamicMatrix<int>(2, 3, { 1, 3, 5, 2, 4, 6 }) ? std::cout << "...#5 PASSED" : std::cout << "...#5 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_matrix_views_as_operands_and_outputs()
+    {
+    std::cout << " >>> test_matrix_views_as_operands_and_outputs()\t\t";
+    std::vector<double> data(6 * 8);
+    for (size_t i = 0; i < data.size(); ++i) { data[i] = double(i); }
+    Matrix<double, 6, 8> mat(data);
+
+    auto block = submatrix<2, 3>(mat, 2, 4);
+    block.at(1, 1) == mat.at(2, 4) && block.data() == &mat.at(2, 4) && row_view(mat, 3).at(1, 8) == mat.at(3, 8) && col_view(mat, 5).at(6, 1) == mat.at(6, 5) ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    // per-row pipeline in place, other rows stay untouched
+    row_view(mat, 2) *= 2.0;
+    row_view(mat, 2) += row_view(mat, 1);
+    bool rows_ok = true;
+    for (size_t col = 1; col <= 8; ++col)
+      {
+      rows_ok = rows_ok && mat.at(2, col) == data[8 + col - 1] * 2.0 + data[col - 1] && mat.at(3, col) == data[16 + col - 1];
+      }
+    rows_ok ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    // block product written straight into a block of another matrix
+    const Matrix<double, 6, 8> mat_src(data);
+    Matrix<double, 6, 8> mat_dst;
+    MatrixProcessors::MultiplyMatrix{}.perform_operation_into(submatrix<3, 4>(mat_src, 1, 1), submatrix<4, 2>(mat_src, 3, 5), submatrix<3, 2>(mat_dst, 4, 7));
+    auto expected = to_matrix(submatrix<3, 4>(mat_src, 1, 1)).BinaryOperation(MatrixProcessors::MultiplyMatrix{}, to_matrix(submatrix<4, 2>(mat_src, 3, 5)));
+    to_matrix(submatrix<3, 2>(mat_dst, 4, 7)) == expected && mat_dst.at(1, 1) == 0.0 && mat_dst.at(4, 6) == 0.0 ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    auto sum = MatrixProcessors::AddMatrix{}.perform_operation(submatrix<2, 2>(mat_src, 1, 1), Matrix<double, 2, 2>({ 1.0, 1.0, 1.0, 1.0 }));
+    auto col_t = MatrixProcessors::Transpose{}.perform_operation(col_view(mat_src, 3));
+    sum == Matrix<double, 2, 2>({ 1.0, 2.0, 9.0, 10.0 }) && col_t == Matrix<double, 1, 6>({ 2.0, 10.0, 18.0, 26.0, 34.0, 42.0 }) ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    try
+      {
+      MatrixProcessors::MultiplyMatrix{}.perform_operation_into(submatrix<2, 2>(mat_dst, 1, 1), submatrix<2, 2>(mat_dst, 1, 3), submatrix<2, 2>(mat_dst, 2, 2));
+      std::cout << "...#5 FAILED !!!";
+      }
+    catch (const std::invalid_argument&)
+      {
+      std::cout << "...#5 PASSED";
+      }
+
+    // elementwise output may be the operand itself, but not shifted over it
+    Matrix<double, 6, 8> mat_shifted(data);
+    bool shifted_thrown = true;
+    try
+      {
+      MatrixProcessors::AddScalar{}.perform_operation_into(submatrix<1, 6>(mat_shifted, 1, 1), 100.0, submatrix<1, 6>(mat_shifted, 1, 2));
+      shifted_thrown = false;
+      }
+    catch (const std::invalid_argument&)
+      {
+      }
+    try
+      {
+      MatrixProcessors::AddMatrix{}.perform_operation_into(submatrix<2, 2>(mat_shifted, 1, 1), submatrix<2, 2>(mat_shifted, 3, 3), submatrix<2, 2>(mat_shifted, 2, 2));
+      shifted_thrown = false;
+      }
+    catch (const std::invalid_argument&)
+      {
+      }
+    MatrixProcessors::MultiplyScalar{}.perform_operation_into(submatrix<2, 3>(mat_shifted, 4, 4), 2.0, submatrix<2, 3>(mat_shifted, 4, 4));
+    shifted_thrown && mat_shifted.at(1, 2) == data[1] && mat_shifted.at(2, 2) == data[9] && mat_shifted.at(4, 4) == 2.0 * data[27] ? std::cout << "...#6 PASSED" : std::cout << "...#6 FAILED !!!";
+
+    try
+      {
+      submatrix<2, 2>(mat_src, 6, 1);
+      std::cout << "...#7 FAILED !!!";
+      }
+    catch (const std::out_of_range&)
+      {
+      std::cout << "...#7 PASSED";
+      }
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_binary_file_write_and_map()
+    {
+    std::cout << " >>> test_binary_file_write_and_map()\t\t";
+    const std::string path = "test_binary_file_write_and_map.bin";
+    std::vector<double> data(9 * 13);
+    for (size_t i = 0; i < data.size(); ++i) { data[i] = double(i) * 0.5 - 7.0; }
+    const Matrix<double, 9, 13> mat(data);
+
+    MatrixIO::write_binary(path, mat);
+      {
+      MatrixIO::MappedMatrix<double> mapped(path);
+      mapped.get_n_rows() == 9 && mapped.get_n_cols() == 13 && mapped.at(9, 13) == mat.at(9, 13) && reinterpret_cast<uintptr_t>(mapped.data()) % 64 == 0 ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+      // mapped pages are consumed by the processors directly
+      auto doubled = MatrixProcessors::MultiplyScalar{}.perform_operation(mapped.view<9, 13>(), 2.0);
+      doubled == mat.UnaryOperation(MatrixProcessors::MultiplyScalar{}, 2.0) ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+      try
+        {
+        mapped.view<13, 9>();
+        std::cout << "...#3 FAILED !!!";
+        }
+      catch (const std::length_error&)
+        {
+        std::cout << "...#3 PASSED";
+        }
+      }
+
+    try
+      {
+      MatrixIO::MappedMatrix<float> wrong_type(path);
+      std::cout << "...#4 FAILED !!!";
+      }
+    catch (const std::runtime_error&)
+      {
+      std::cout << "...#4 PASSED";
+      }
+
+    // block of a matrix is written as a dense matrix
+    MatrixIO::write_binary(path, submatrix<2, 3>(mat, 4, 5));
+    const DynamicMatrix<double> block = MatrixIO::read_binary<double>(path);
+    block.get_n_rows() == 2 && block.get_n_cols() == 3 && block == DynamicMatrix<double>(to_matrix(submatrix<2, 3>(mat, 4, 5))) ? std::cout << "...#5 PASSED" : std::cout << "...#5 FAILED !!!";
+
+    std::remove(path.c_str());
+    std::cout << "\n";
+    }
+
+
+
+  void test_out_of_core_multiply()
+    {
+    std::cout << " >>> test_out_of_core_multiply()\t\t";
+    const std::string path_a = "test_out_of_core_multiply_a.bin";
+    const std::string path_b = "test_out_of_core_multiply_b.bin";
+    const std::string path_c = "test_out_of_core_multiply_c.bin";
+
+    DynamicMatrix<int> mat_a(301, 157);
+    DynamicMatrix<int> mat_b(157, 229);
+    for (size_t i = 0; i < 301 * 157; ++i) { mat_a.data()[i] = int(i % 19) - 9; }
+    for (size_t i = 0; i < 157 * 229; ++i) { mat_b.data()[i] = int(i % 23) - 11; }
+    MatrixIO::write_binary(path_a, mat_a);
+    MatrixIO::write_binary(path_b, mat_b);
+    const MatrixIO::MatrixFile<int> file_a(path_a);
+    const MatrixIO::MatrixFile<int> file_b(path_b);
+    const auto file_c = MatrixIO::MatrixFile<int>::create(path_c, 301, 229);
+
+    // budget for 100 x 100 tiles, so every dimension is split with a partial last tile
+    const MatrixProcessors::OutOfCoreMultiplyMatrix processor(5 * 100 * 100 * sizeof(int));
+    processor.perform_operation_into(file_a, file_b, file_c);
+    MatrixIO::read_binary<int>(path_c) == MatrixProcessors::MultiplyMatrix{}.perform_operation(mat_a, mat_b) ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    DynamicMatrix<int> block(2, 3);
+    std::ifstream stream_c = file_c.open_for_reading();
+    file_c.read_block(stream_c, 300, 227, 2, 3, block.data());
+    block.at(2, 3) == MatrixIO::MappedMatrix<int>(path_c).at(301, 229) ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    try
+      {
+      processor.perform_operation_into(file_a, file_a, file_c);
+      std::cout << "...#3 FAILED !!!";
+      }
+    catch (const std::length_error&)
+      {
+      std::cout << "...#3 PASSED";
+      }
+
+    try
+      {
+      const auto file_square = MatrixIO::MatrixFile<int>::create(path_b, 157, 157);
+      processor.perform_operation_into(file_a, file_square, MatrixIO::MatrixFile<int>(path_a));
+      std::cout << "...#4 FAILED !!!";
+      }
+    catch (const std::invalid_argument&)
+      {
+      std::cout << "...#4 PASSED";
+      }
+
+    try
+      {
+      MatrixProcessors::OutOfCoreMultiplyMatrix(1024).perform_operation_into(file_a, file_b, file_c);
+      std::cout << "...#5 FAILED !!!";
+      }
+    catch (const std::invalid_argument&)
+      {
+      std::cout << "...#5 PASSED";
+      }
+
+    std::remove(path_a.c_str());
+    std::remove(path_b.c_str());
+    std::remove(path_c.c_str());
+    std::cout << "\n";
+    }
+
+
+
+  void test_sparse_matrix_multiply()
+    {
+    std::cout << " >>> test_sparse_matrix_multiply()\t\t";
+    // about 5% of elements are nonzero
+    std::vector<int> data(61 * 43, 0);
+    for (size_t i = 0; i < data.size(); i += 19) { data[i] = int(i % 13) - 6; }
+    const Matrix<int, 61, 43> dense(data);
+    const CsrMatrix<int, 61, 43> csr(dense);
+    const CscMatrix<int, 61, 43> csc(dense);
+
+    csr.to_dense() == dense && csc.to_dense() == dense && csr.to_layout<SparseLayout::CSC>() == csc && csc.to_layout<SparseLayout::CSR>() == csr
+      && csr.at(1, 1) == dense.at(1, 1) && csc.at(61, 43) == dense.at(61, 43) && csr.get_n_nonzeros() < data.size() / 10 ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    std::vector<int> data_vec(43);
+    for (size_t i = 0; i < 43; ++i) { data_vec[i] = int(i) - 20; }
+    const MatrixVectCol<int, 43> vec(data_vec);
+    const auto expected_vec = MatrixProcessors::MultiplyMatrix{}.perform_operation(dense, vec);
+    MatrixProcessors::MultiplyMatrix{}.perform_operation(csr, vec) == expected_vec && csc.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, vec) == expected_vec ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    std::vector<double> data_mat(43 * 37);
+    for (size_t i = 0; i < data_mat.size(); ++i) { data_mat[i] = double(i % 11) - 5.0; }
+    const Matrix<double, 43, 37> mat(data_mat);
+    const auto expected_mat = MatrixProcessors::MultiplyMatrix{}.perform_operation(dense, mat);
+    const MatrixProcessors::MultiplyMatrix parallel(ExecutionPolicy::parallel(4));
+    parallel.perform_operation(csr, mat) == expected_mat && parallel.perform_operation(csc, mat) == expected_mat ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    try
+      {
+      CsrMatrix<int, 2, 3>({ 0, 2, 3 }, { 2, 1, 0 }, { 1, 2, 3 });
+      std::cout << "...#4 FAILED !!!";
+      }
+    catch (const std::invalid_argument&)
+      {
+      std::cout << "...#4 PASSED";
+      }
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_instrumentation_counters()
+    {
+    std::cout << " >>> test_instrumentation_counters()\t\t";
+    Instrumentation::reset();
+
+    const Matrix<float, 4, 4> mat({ 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f, 10.0f, 11.0f, 12.0f, 13.0f, 14.0f, 15.0f, 16.0f });
+    Matrix<float, 4, 4> out;
+    for (int i = 0; i < 3; ++i)
+      {
+      MatrixProcessors::MultiplyScalar{}.perform_operation(mat, 2.0f);
+      }
+    MatrixProcessors::MultiplyScalar{}.perform_operation_into(mat, 3.0f, out);
+    const DynamicMatrix<double> dyn(30, 40);
+    dyn.BinaryOperation(MatrixProcessors::AddMatrix{}, dyn);
+
+    const auto snapshots = Instrumentation::snapshot();
+    auto find = [&](const std::string& processor, const std::string& shape)
+      {
+      const auto it = std::find_if(snapshots.begin(), snapshots.end(), [&](const Instrumentation::Snapshot& snap) { return snap.processor == processor && snap.shape == shape; });
+      return it == snapshots.end() ? Instrumentation::Snapshot{} : *it;
+      };
+    const auto scalar_calls = find("MatrixProcessors::MultiplyScalar", "4x4, scalar");
+    const auto matrix_calls = find("MatrixProcessors::AddMatrix", "30x40, 30x40");
+
+    if (Instrumentation::enabled)
+      {
+      uint64_t histogram_total = 0;
+      for (const uint64_t count : scalar_calls.latency_histogram) { histogram_total += count; }
+      scalar_calls.calls == 4 && scalar_calls.elements == 4 * 16 && scalar_calls.bytes_allocated == 0 && histogram_total == 4 ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+      matrix_calls.calls == 1 && matrix_calls.elements == 2 * 1200 && matrix_calls.bytes_allocated == 1200 * sizeof(double) ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+      std::ostringstream json;
+      Instrumentation::write_json(json, snapshots);
+      json.str().find("\"processor\": \"MatrixProcessors::AddMatrix\", \"shape\": \"30x40, 30x40\", \"calls\": 1") != std::string::npos ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+      }
+    else
+      {
+      snapshots.empty() ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+      }
+
+    Instrumentation::reset();
+    Instrumentation::snapshot().empty() ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_constexpr_matrix_operations()
+    {
+    std::cout << " >>> test_constexpr_matrix_operations()\t\t";
+
+    // every line below is evaluated by the compiler, the test fails to build if any of them can't be
+    static_assert(std::is_trivially_destructible_v<Matrix<double, 4, 4>> && std::is_trivially_destructible_v<MatrixVectCol<int, 3>>);
+
+    constexpr Matrix<int, 2, 2> quarter_turn { 0, -1, 1, 0 };
+    constexpr MatrixProcessors::MultiplyMatrix multiply;
+    constexpr auto half_turn = multiply.perform_operation(quarter_turn, quarter_turn);
+    constexpr auto full_turn = multiply.perform_operation(half_turn, half_turn);
+    constexpr auto scaled = full_turn.UnaryOperation(MatrixProcessors::MultiplyScalar{}, 3);
+    static_assert(half_turn == Matrix<int, 2, 2>{ -1, 0, 0, -1 });
+    static_assert(scaled.at(1, 1) == 3 && scaled.at(1, 2) == 0 && scaled.at(2, 1) == 0 && scaled.at(2, 2) == 3);
+
+    constexpr Matrix<double, 2, 3> basis { 1.0, 2.0, 3.0, 4.0, 5.0, 6.0 };
+    constexpr auto transposed = MatrixProcessors::Transpose{}.perform_operation(basis);
+    constexpr auto shifted = MatrixProcessors::SubtractScalar{}.perform_operation(MatrixProcessors::AddScalar{}.perform_operation(transposed, 1.5), 0.5);
+    constexpr auto doubled = MatrixProcessors::AddMatrix{}.perform_operation(shifted, shifted);
+    static_assert(doubled.at(3, 1) == 8.0 && doubled.at(1, 2) == 10.0 && doubled.at(3, 2) == 14.0);
+
+    constexpr MatrixVectRow<int, 3> row { 1, 2, 3 };
+    constexpr MatrixVectCol<double, 3> col { 0.5, 0.5, 1.0 };
+    constexpr auto dot = multiply.perform_operation(row, col);
+    static_assert(dot.at(1, 1) == 4.5 && row.at(3) == 3 && col.at(1) == 0.5);
+    std::cout << "...#1 PASSED";
+
+    // run time evaluation of the same chain takes the SIMD and threaded paths and must agree
+    Matrix<int, 2, 2> turn = quarter_turn;
+    const MatrixProcessors::MultiplyMatrix parallel(ExecutionPolicy::parallel(2));
+    for (int i = 0; i < 3; ++i)
+      {
+      turn = parallel.perform_operation(turn, quarter_turn);
+      }
+    const Matrix<double, 2, 3> runtime_basis = basis;
+    const auto runtime_shifted = MatrixProcessors::SubtractScalar{}.perform_operation(MatrixProcessors::AddScalar{}.perform_operation(MatrixProcessors::Transpose{}.perform_operation(runtime_basis), 1.5), 0.5);
+    turn.UnaryOperation(MatrixProcessors::MultiplyScalar{}, 3) == scaled && runtime_shifted.BinaryOperation(MatrixProcessors::AddMatrix{}, runtime_shifted) == doubled ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  // product by the unrolled kernel must be the same as by the plain loop
+  template <typename T, typename U, size_t N, size_t M>
+  bool unrolled_product_matches_plain_loop()
+    {
+    using W = decltype(std::declval<T>() + std::declval<U>());
+    std::vector<T> lhs_data(N * N);
+    std::vector<U> rhs_data(N * M);
+    // halves and quarters keep every sum exact, whether the compiler fuses multiply-adds or not
+    for (size_t i = 0; i < lhs_data.size(); ++i) { lhs_data[i] = T(int(i * 7 % 11) - 5) / T(2); }
+    for (size_t i = 0; i < rhs_data.size(); ++i) { rhs_data[i] = U(int(i * 5 % 13) - 6) / U(4); }
+    const Matrix<T, N, N> lhs(lhs_data);
+    const Matrix<U, N, M> rhs(rhs_data);
+
+    std::vector<W> expected(N * M, W(0));
+    MatrixProcessors::Gemm::multiply_small(N, M, N, lhs.data(), rhs.data(), expected.data());
+    const auto product = MatrixProcessors::MultiplyMatrix{}.perform_operation(lhs, rhs);
+    return product == Matrix<W, N, M>(expected);
+    }
+
+
+
+  void test_unrolled_small_products()
+    {
+    std::cout << " >>> test_unrolled_small_products()\t\t";
+
+    unrolled_product_matches_plain_loop<float, float, 2, 2>() && unrolled_product_matches_plain_loop<float, float, 3, 3>() && unrolled_product_matches_plain_loop<float, float, 4, 4>()
+      && unrolled_product_matches_plain_loop<float, float, 2, 1>() && unrolled_product_matches_plain_loop<float, float, 3, 1>() && unrolled_product_matches_plain_loop<float, float, 4, 1>() ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    unrolled_product_matches_plain_loop<double, double, 2, 2>() && unrolled_product_matches_plain_loop<double, double, 3, 3>() && unrolled_product_matches_plain_loop<double, double, 4, 4>()
+      && unrolled_product_matches_plain_loop<double, double, 2, 1>() && unrolled_product_matches_plain_loop<double, double, 3, 1>() && unrolled_product_matches_plain_loop<double, double, 4, 1>() ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    unrolled_product_matches_plain_loop<int, int, 4, 4>() && unrolled_product_matches_plain_loop<int, int, 3, 1>() && unrolled_product_matches_plain_loop<float, double, 4, 4>()
+      && unrolled_product_matches_plain_loop<int, float, 4, 1>() ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    // vector classes select the matrix-vector kernel through their base
+    const Matrix<float, 4, 4> scale({ 2.0f, 0.0f, 0.0f, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f, 4.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f });
+    const MatrixVectCol<float, 4> point({ 1.0f, -1.0f, 0.5f, 1.0f });
+    scale.BinaryOperation(MatrixProcessors::MultiplyMatrix{}, point) == Matrix<float, 4, 1>({ 2.0f, -3.0f, 2.0f, 1.0f }) ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_unchecked_access_and_iterators()
+    {
+    std::cout << " >>> test_unchecked_access_and_iterators()\t\t";
+    static_assert(std::is_same_v<std::iterator_traits<Matrix<int, 3, 4>::col_iterator>::iterator_category, std::random_access_iterator_tag>);
+
+    Matrix<int, 3, 4> mat({ 5, 1, 9, 2, 7, 3, 8, 6, 4, 0, 11, 10 });
+    bool same_as_at = true;
+    for (size_t row = 1; row <= 3; ++row)
+      {
+      for (size_t col = 1; col <= 4; ++col)
+        {
+        same_as_at = same_as_at && &mat(row, col) == &mat.at(row, col);
+        }
+      }
+    mat(3, 4) = 12;
+    same_as_at && mat.at(3, 4) == 12 && std::accumulate(mat.begin(), mat.end(), 0) == 68 ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    // rows are contiguous, columns are walked with stride, both work with STL algorithms that need random access
+    std::sort(mat.row_begin(2), mat.row_end(2));
+    std::sort(mat.col_begin(3), mat.col_end(3), std::greater<int>());
+    const Matrix<int, 3, 4>& const_mat = mat;
+    const_mat == Matrix<int, 3, 4>({ 5, 1, 11, 2, 3, 6, 9, 8, 4, 0, 7, 12 }) && const_mat.col_end(2) - const_mat.col_begin(2) == 3
+      && *std::max_element(const_mat.col_begin(1), const_mat.col_end(1)) == 5 && const_mat.col_begin(4)[2] == 12 ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    MatrixVectRow<double, 3> row({ 1.0, 2.0, 3.0 });
+    MatrixVectCol<double, 3> col({ 4.0, 5.0, 6.0 });
+    row(2) = 20.0;
+    row(2) == row.at(2) && row(1, 3) == 3.0 && col(3) == 6.0 && std::inner_product(row.begin(), row.end(), col.begin(), 0.0) == 122.0 ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    DynamicMatrix<float> dyn(2, 3, { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f });
+    std::transform(dyn.col_begin(2), dyn.col_end(2), dyn.col_begin(2), [](float value) { return -value; });
+    dyn(2, 2) == -5.0f && dyn.at(1, 2) == -2.0f && std::accumulate(dyn.row_begin(2), dyn.row_end(2), 0.0f) == 5.0f && std::count(dyn.begin(), dyn.end(), 3.0f) == 1 ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    constexpr Matrix<int, 2, 3> constant { 1, 2, 3, 4, 5, 6 };
+    constexpr int column_sum = [](const Matrix<int, 2, 3>& m) { int sum = 0; for (auto it = m.col_begin(3); it != m.col_end(3); ++it) { sum += *it; } return sum; }(constant);
+    static_assert(column_sum == 9 && constant(2, 1) == 4);
+    std::cout << "...#5 PASSED";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_text_write_and_parse()
+    {
+    std::cout << " >>> test_text_write_and_parse()\t\t";
+
+    // operator<< writes to the stream it is given, not to std::cout
+    std::ostringstream printed;
+    printed << Matrix<int, 2, 2>({ 1, 2, 3, 4 }) << MatrixVectRow<int, 2>({ 5, 6 });
+    printed.str() == "| 1\t2 |\n| 3\t4 |\n| 5\t6 |\n" ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    const Matrix<double, 3, 2> mat({ 0.1, -2.5, 1e-300, 3.0, 1.0 / 3.0, -0.0 });
+    std::ostringstream csv;
+    std::ostringstream whitespace;
+    std::ostringstream market;
+    MatrixIO::write_text(csv, mat);
+    MatrixIO::write_text(whitespace, mat, MatrixIO::TextFormat::Whitespace);
+    MatrixIO::write_text(market, mat, MatrixIO::TextFormat::MatrixMarket);
+    csv.str() == "0.1,-2.5\n1e-300,3\n0.3333333333333333,-0\n"
+      && market.str() == "%%MatrixMarket matrix array real general\n3 2\n0.1\n1e-300\n0.3333333333333333\n-2.5\n3\n-0\n"
+      && MatrixIO::parse_text<double>(csv.str()) == DynamicMatrix<double>(mat)
+      && MatrixIO::parse_text<double>(whitespace.str(), MatrixIO::TextFormat::Whitespace) == DynamicMatrix<double>(mat)
+      && MatrixIO::parse_text<double>(market.str(), MatrixIO::TextFormat::MatrixMarket) == DynamicMatrix<double>(mat) ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    // blank lines, spaces around separators, \r\n and leading plus are accepted
+    const DynamicMatrix<int> loose = MatrixIO::parse_text<int>("\n 1 , +2,3\r\n\n4,5 ,-6\r\n");
+    const DynamicMatrix<float> tabs = MatrixIO::parse_text<float>("1.5\t 2\n-3 4e2\n", MatrixIO::TextFormat::Whitespace);
+    loose == DynamicMatrix<int>(2, 3, { 1, 2, 3, 4, 5, -6 }) && tabs == DynamicMatrix<float>(2, 2, { 1.5f, 2.0f, -3.0f, 400.0f }) ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    // coordinate entries, comments, symmetric and skew-symmetric storage
+    const SparseMatrix<int, 3, 3> sparse(Matrix<int, 3, 3>({ 0, 7, 0, 0, 0, 0, -1, 0, 2 }));
+    std::ostringstream coordinate;
+    MatrixIO::write_text(coordinate, sparse, MatrixIO::TextFormat::MatrixMarket);
+    const DynamicMatrix<int> symmetric = MatrixIO::parse_text<int>("%%MatrixMarket matrix coordinate integer symmetric\n% comment\n2 2 2\n1 1 5\n2 1 3\n", MatrixIO::TextFormat::MatrixMarket);
+    const DynamicMatrix<double> skew = MatrixIO::parse_text<double>("%%MatrixMarket matrix array real skew-symmetric\n2 2\n4\n", MatrixIO::TextFormat::MatrixMarket);
+    coordinate.str() == "%%MatrixMarket matrix coordinate integer general\n3 3 3\n1 2 7\n3 1 -1\n3 3 2\n"
+      && MatrixIO::parse_text<int>(coordinate.str(), MatrixIO::TextFormat::MatrixMarket) == DynamicMatrix<int>(sparse.to_dense())
+      && symmetric == DynamicMatrix<int>(2, 2, { 5, 3, 3, 0 }) && skew == DynamicMatrix<double>(2, 2, { 0.0, -4.0, 4.0, 0.0 }) ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    // a few MB, so the text is formatted and parsed in several blocks and chunks by several threads
+    DynamicMatrix<double> big(2000, 150);
+    for (size_t i = 0; i < big.get_data().size(); ++i)
+      {
+      big.data()[i] = std::sin(double(i)) * 1000.0;
+      }
+    const std::string path = "test_text_write_and_parse.csv";
+    MatrixIO::write_text(path, big, MatrixIO::TextFormat::Csv, ExecutionPolicy::parallel(4));
+    std::ostringstream serial;
+    MatrixIO::write_text(serial, big, MatrixIO::TextFormat::Csv, ExecutionPolicy::serial());
+    const DynamicMatrix<double> parsed = MatrixIO::read_text<double>(path, MatrixIO::TextFormat::Csv, ExecutionPolicy::parallel(4));
+    std::ifstream file(path, std::ios::binary);
+    const std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path.c_str());
+    written == serial.str() && parsed == big && MatrixIO::parse_text<double>(written, MatrixIO::TextFormat::Csv, ExecutionPolicy::serial()) == big ? std::cout << "...#5 PASSED" : std::cout << "...#5 FAILED !!!";
+
+    int n_errors = 0;
+    const std::vector<std::pair<std::string, MatrixIO::TextFormat>> malformed = {
+      { "1,2\n3\n", MatrixIO::TextFormat::Csv },
+      { "1,,2\n", MatrixIO::TextFormat::Csv },
+      { "1,2,\n", MatrixIO::TextFormat::Csv },
+      { "1 x\n", MatrixIO::TextFormat::Whitespace },
+      { "%%MatrixMarket matrix array real general\n2 2\n1\n2\n3\n", MatrixIO::TextFormat::MatrixMarket },
+      { "%%MatrixMarket matrix coordinate real general\n2 2 1\n3 1 1\n", MatrixIO::TextFormat::MatrixMarket },
+      { "%%MatrixMarket matrix coordinate complex general\n2 2 1\n1 1 1 0\n", MatrixIO::TextFormat::MatrixMarket },
+      { "1 2\n", MatrixIO::TextFormat::MatrixMarket } };
+    for (const auto& text : malformed)
+      {
+      try
+        {
+        MatrixIO::parse_text<double>(text.first, text.second);
+        }
+      catch (const std::runtime_error&)
+        {
+        ++n_errors;
+        }
+      }
+    n_errors == int(malformed.size()) ? std::cout << "...#6 PASSED" : std::cout << "...#6 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+
+  void test_reduced_precision_and_quantized_products()
+    {
+    std::cout << " >>> test_reduced_precision_and_quantized_products()\t\t";
+
+    // rounding to nearest even, overflow, subnormals and the bfloat16 layout
+    Float16(1.0f).bits() == 0x3c00 && Float16(65504.0f).bits() == 0x7bff && Float16(65520.0f).bits() == 0x7c00
+      && Float16(std::ldexp(1.0f, -24)).bits() == 0x0001 && Float16(1.0f + std::ldexp(1.0f, -11)).bits() == 0x3c00
+      && Float16(1.0f + 3.0f * std::ldexp(1.0f, -11)).bits() == 0x3c02 && float(Float16::from_bits(0xc000)) == -2.0f
+      && BFloat16(1.0f).bits() == 0x3f80 && float(BFloat16(3.0f)) == 3.0f && float(BFloat16(1.0f + std::ldexp(1.0f, -8))) == 1.0f ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    // half-size storage, products accumulated in float; values are dyadic, so every sum is exact
+    DynamicMatrix<float> a(40, 48);
+    DynamicMatrix<float> b(48, 36);
+    for (size_t i = 0; i < a.get_data().size(); ++i)
+      {
+      a.data()[i] = float(int(i % 17) - 8) / 4.0f;
+      }
+    for (size_t i = 0; i < b.get_data().size(); ++i)
+      {
+      b.data()[i] = float(int(i % 13) - 6) / 2.0f;
+      }
+    const auto a16 = MatrixProcessors::ConvertMatrix<Float16>().perform_operation(a);
+    const auto b16 = MatrixProcessors::ConvertMatrix<BFloat16>().perform_operation(b);
+    const DynamicMatrix<float> product = MatrixProcessors::MultiplyMatrix().perform_operation(a, b);
+    const DynamicMatrix<Float16> product16 = MatrixProcessors::WideMultiplyMatrix<float, Float16>().perform_operation(a16, b16);
+    MatrixProcessors::ConvertMatrix<float>().perform_operation(a16) == a && MatrixProcessors::MultiplyMatrix().perform_operation(a16, b16) == product
+      && MatrixProcessors::ConvertMatrix<float>().perform_operation(product16) == MatrixProcessors::ConvertMatrix<float>().perform_operation(MatrixProcessors::ConvertMatrix<Float16>().perform_operation(product)) ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    // int products accumulated in int64 don`t overflow
+    const Matrix<int, 2, 2> big({ 2000000000, 2000000000, 1, -1 });
+    const Matrix<int64_t, 2, 2> wide = MatrixProcessors::WideMultiplyMatrix<int64_t>().perform_operation(big, big);
+    wide == Matrix<int64_t, 2, 2>({ 4000000002000000000, 3999999998000000000, 1999999999, 2000000001 }) ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    // quantized values read back within half a step, zero exactly
+    const auto a_params = MatrixProcessors::Quantization::choose_params<uint8_t>(a.data(), a.get_data().size());
+    const auto b_params = MatrixProcessors::Quantization::choose_params<int8_t>(-3.0f, 5.0f);
+    const DynamicMatrix<uint8_t> qa = MatrixProcessors::Quantization::quantize<uint8_t>(a, a_params);
+    const DynamicMatrix<int8_t> qb = MatrixProcessors::Quantization::quantize<int8_t>(b, b_params);
+    const DynamicMatrix<float> back = MatrixProcessors::Quantization::dequantize(qa, a_params);
+    bool within_step = b_params.zero_point == -32;
+    for (size_t i = 0; i < a.get_data().size(); ++i)
+      {
+      within_step = within_step && std::abs(back.data()[i] - a.data()[i]) <= a_params.scale / 2.0f * 1.0001f && (a.data()[i] != 0.0f || back.data()[i] == 0.0f);
+      }
+    within_step ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    // accumulators are the exact product of A - za and B - zb, serial or parallel, big enough for the pair engine, odd inner dimension
+    DynamicMatrix<uint8_t> qa_odd(40, 47, std::vector<uint8_t, AlignedAllocator<uint8_t>>(qa.get_data().begin(), qa.get_data().begin() + 40 * 47));
+    DynamicMatrix<int8_t> qb_odd(47, 36, std::vector<int8_t, AlignedAllocator<int8_t>>(qb.get_data().begin(), qb.get_data().begin() + 47 * 36));
+    qb_odd.at(1, 1) = -128;
+    qa_odd.at(1, 1) = 255;
+    DynamicMatrix<int32_t> expected(40, 36);
+    for (size_t i = 1; i <= 40; ++i)
+      {
+      for (size_t j = 1; j <= 36; ++j)
+        {
+        int32_t sum = 0;
+        for (size_t p = 1; p <= 47; ++p)
+          {
+          sum += (int32_t(qa_odd.at(i, p)) - a_params.zero_point) * (int32_t(qb_odd.at(p, j)) - b_params.zero_point);
+          }
+        expected.at(i, j) = sum;
+        }
+      }
+    DynamicMatrix<int32_t> serial(40, 36);
+    DynamicMatrix<int32_t> parallel(40, 36);
+    MatrixProcessors::QuantizedMultiplyMatrix<>(ExecutionPolicy::serial(), a_params, b_params).perform_operation_into(qa_odd, qb_odd, serial);
+    MatrixProcessors::QuantizedMultiplyMatrix<>(ExecutionPolicy::parallel(4), a_params, b_params).perform_operation_into(qa_odd, qb_odd, parallel);
+    DynamicMatrix<int32_t> sse2_pairs(40, 36);
+    MatrixProcessors::Simd::force_instruction_set(MatrixProcessors::Simd::InstructionSet::SSE2);
+    MatrixProcessors::QuantizedMultiplyMatrix<>(a_params, b_params).perform_operation_into(qa_odd, qb_odd, sse2_pairs);
+    MatrixProcessors::Simd::force_instruction_set(MatrixProcessors::Simd::detect_instruction_set());
+    const Matrix<int8_t, 2, 3> small_a({ 1, -2, 3, 4, 5, -6 });
+    const Matrix<int8_t, 3, 1> small_b({ 7, 8, -9 });
+    Matrix<int64_t, 2, 1> small;
+    MatrixProcessors::QuantizedMultiplyMatrix<int64_t>({ 1.0f, 1 }, { 1.0f, -1 }).perform_operation_into(small_a, small_b, small);
+    serial == expected && parallel == expected && sse2_pairs == expected && small == Matrix<int64_t, 2, 1>({ -43, 116 }) ? std::cout << "...#5 PASSED" : std::cout << "...#5 FAILED !!!";
+
+    // real result is scale_a * scale_b times the accumulators and close to the float product
+    const DynamicMatrix<float> real = MatrixProcessors::QuantizedMultiplyMatrix<>(a_params, b_params).perform_operation(qa, qb);
+    bool close = true;
+    for (size_t i = 0; i < product.get_data().size(); ++i)
+      {
+      close = close && std::abs(real.data()[i] - product.data()[i]) <= 0.5f;
+      }
+    close ? std::cout << "...#6 PASSED" : std::cout << "...#6 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+  void test_fused_multiply_add()
+    {
+    std::cout << " >>> test_fused_multiply_add()\t\t";
+
+    // matches the chain of MultiplyMatrix, MultiplyScalar and AddMatrix
+    const Matrix<double, 2, 3> a({ 1, 2, 3, 4, 5, 6 });
+    const Matrix<double, 3, 2> b({ 7, 8, 9, 10, 11, 12 });
+    const Matrix<double, 2, 2> c({ 1, -1, 0.5, 2 });
+    const Matrix<double, 2, 2> fused = MatrixProcessors::MultiplyAddMatrix(2.0, -1.0).perform_operation(a, b, c);
+    fused == Matrix<double, 2, 2>({ 115, 129, 277.5, 306 }) ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    // GEMM engine with more than one kc block; values are dyadic, so every sum is exact and the order doesn`t matter
+    DynamicMatrix<float> big_a(70, 300);
+    DynamicMatrix<float> big_b(300, 50);
+    DynamicMatrix<float> big_c(70, 50);
+    for (size_t i = 0; i < big_a.get_data().size(); ++i)
+      {
+      big_a.data()[i] = float(int(i % 17) - 8) / 4.0f;
+      }
+    for (size_t i = 0; i < big_b.get_data().size(); ++i)
+      {
+      big_b.data()[i] = float(int(i % 13) - 6) / 2.0f;
+      }
+    for (size_t i = 0; i < big_c.get_data().size(); ++i)
+      {
+      big_c.data()[i] = float(int(i % 7) - 3);
+      }
+    const DynamicMatrix<float> product = MatrixProcessors::MultiplyMatrix().perform_operation(big_a, big_b);
+    DynamicMatrix<float> expected(70, 50);
+    for (size_t i = 0; i < expected.get_data().size(); ++i)
+      {
+      expected.data()[i] = 0.5f * product.data()[i] + 2.0f * big_c.data()[i];
+      }
+    MatrixProcessors::MultiplyAddMatrix(0.5, 2.0).perform_operation(big_a, big_b, big_c) == expected ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    // accumulation in place, serial or parallel; beta = 0 doesn`t read C
+    DynamicMatrix<float> serial(big_c);
+    DynamicMatrix<float> parallel(big_c);
+    MatrixProcessors::MultiplyAddMatrix(ExecutionPolicy::serial(), 0.5, 2.0).perform_operation_into(big_a, big_b, serial);
+    MatrixProcessors::MultiplyAddMatrix(ExecutionPolicy::parallel(4), 0.5, 2.0).perform_operation_into(big_a, big_b, parallel);
+    DynamicMatrix<float> overwritten(70, 50, std::vector<float, AlignedAllocator<float>>(70 * 50, std::numeric_limits<float>::quiet_NaN()));
+    MatrixProcessors::MultiplyAddMatrix(1.0, 0.0).perform_operation_into(big_a, big_b, overwritten);
+    Matrix<double, 2, 2> accumulated(c);
+    MatrixProcessors::MultiplyAddMatrix().perform_operation_into(a, b, accumulated);
+    serial == expected && parallel == expected && overwritten == product
+      && accumulated == Matrix<double, 2, 2>({ 59, 63, 139.5, 156 }) ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    // shapes are checked, C must not overlap the operands
+    bool length_thrown = false;
+    bool aliasing_thrown = false;
+    try
+      {
+      DynamicMatrix<float> wrong(70, 49);
+      MatrixProcessors::MultiplyAddMatrix().perform_operation_into(big_a, big_b, wrong);
+      }
+    catch (const std::length_error&)
+      {
+      length_thrown = true;
+      }
+    try
+      {
+      DynamicMatrix<float> square(8, 8);
+      MatrixProcessors::MultiplyAddMatrix().perform_operation_into(square, square, square);
+      }
+    catch (const std::invalid_argument&)
+      {
+      aliasing_thrown = true;
+      }
+    length_thrown && aliasing_thrown ? std::cout << "...#4 PASSED" : std::cout << "...#4 FAILED !!!";
+
+    // integral results take whole alpha and beta only, fractions would be truncated
+    const Matrix<int, 2, 3> int_a({ 1, 2, 3, 4, 5, 6 });
+    const Matrix<int, 3, 2> int_b({ 7, 8, 9, 10, 11, 12 });
+    const Matrix<int, 2, 2> int_c({ 1, -1, 3, 2 });
+    const DynamicMatrix<int> int_x(3, 1, std::vector<int, AlignedAllocator<int>>{ 1, 2, 3 });
+    const DynamicMatrix<int> int_y(1, 2, std::vector<int, AlignedAllocator<int>>{ 4, 5 });
+    DynamicMatrix<int> int_rank_one(3, 2, std::vector<int, AlignedAllocator<int>>(6, 1));
+    bool fraction_thrown = true;
+    try
+      {
+      MatrixProcessors::MultiplyAddMatrix(0.5, 1.5).perform_operation(int_a, int_b, int_c);
+      fraction_thrown = false;
+      }
+    catch (const std::invalid_argument&)
+      {
+      }
+    try
+      {
+      MatrixProcessors::MultiplyAddMatrix(0.5, 1.0).perform_operation_into(int_x, int_y, int_rank_one);
+      fraction_thrown = false;
+      }
+    catch (const std::invalid_argument&)
+      {
+      }
+    const Matrix<int, 2, 2> int_fused = MatrixProcessors::MultiplyAddMatrix(2.0, -1.0).perform_operation(int_a, int_b, int_c);
+    fraction_thrown && int_rank_one == DynamicMatrix<int>(3, 2, std::vector<int, AlignedAllocator<int>>(6, 1))
+      && int_fused == Matrix<int, 2, 2>({ 115, 129, 275, 306 }) ? std::cout << "...#5 PASSED" : std::cout << "...#5 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+  void test_matrix_vector_products()
+    {
+    std::cout << " >>> test_matrix_vector_products()\t\t";
+
+    // dyadic values, so every sum is exact and matches the plain loop whatever the order
+    std::vector<double> mat_data(7 * 37);
+    std::vector<double> vec_data(37);
+    for (size_t i = 0; i < mat_data.size(); ++i)
+      {
+      mat_data[i] = double(int(i % 11) - 5) / 4.0;
+      }
+    for (size_t i = 0; i < vec_data.size(); ++i)
+      {
+      vec_data[i] = double(int(i % 5) - 2) / 2.0;
+      }
+    const Matrix<double, 7, 37> mat(mat_data);
+    const MatrixVectCol<double, 37> col(vec_data);
+    const MatrixVectRow<double, 7> row(std::vector<double>(vec_data.begin(), vec_data.begin() + 7));
+    Matrix<double, 7, 1> expected_col;
+    Matrix<double, 1, 37> expected_row;
+    for (size_t i = 1; i <= 7; ++i)
+      {
+      for (size_t j = 1; j <= 37; ++j)
+        {
+        expected_col.at(i, 1) += mat.at(i, j) * col.at(j);
+        expected_row.at(1, j) += row.at(i) * mat.at(i, j);
+        }
+      }
+    MatrixProcessors::MultiplyMatrix().perform_operation(mat, col) == expected_col
+      && MatrixProcessors::MultiplyMatrix().perform_operation(row, mat) == expected_row ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    // rounded sums are the same on every instruction set, with any policy and for a row taken alone
+    DynamicMatrix<float> big(1001, 203);
+    DynamicMatrix<float> x(203, 1);
+    for (size_t i = 0; i < big.get_data().size(); ++i)
+      {
+      big.data()[i] = std::sin(float(i));
+      }
+    for (size_t i = 0; i < x.get_data().size(); ++i)
+      {
+      x.data()[i] = std::cos(float(i));
+      }
+    const DynamicMatrix<float> reference = MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation(big, x);
+    bool same = MatrixProcessors::MultiplyMatrix(ExecutionPolicy::parallel(4)).perform_operation(big, x) == reference;
+    for (MatrixProcessors::Simd::InstructionSet isa : { MatrixProcessors::Simd::InstructionSet::Scalar, MatrixProcessors::Simd::InstructionSet::SSE2, MatrixProcessors::Simd::InstructionSet::AVX2 })
+      {
+      MatrixProcessors::Simd::force_instruction_set(isa);
+      same = same && MatrixProcessors::MultiplyMatrix().perform_operation(big, x) == reference;
+      }
+    MatrixProcessors::Simd::force_instruction_set(MatrixProcessors::Simd::detect_instruction_set());
+    const DynamicMatrix<float> row_5(1, 203, std::vector<float, AlignedAllocator<float>>(big.get_data().begin() + 5 * 203, big.get_data().begin() + 6 * 203));
+    same && MatrixProcessors::MultiplyMatrix().perform_operation(row_5, x).at(1, 1) == reference.at(6, 1) ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    // vector times matrix sums in order of the inner index, as the plain loop; serial and parallel runs agree
+    DynamicMatrix<float> y(1, 1001);
+    for (size_t i = 0; i < y.get_data().size(); ++i)
+      {
+      y.data()[i] = float(int(i % 9) - 4) / 8.0f;
+      }
+    DynamicMatrix<float> dyadic(1001, 203);
+    for (size_t i = 0; i < dyadic.get_data().size(); ++i)
+      {
+      dyadic.data()[i] = float(int(i % 13) - 6);
+      }
+    DynamicMatrix<float> expected_y(1, 203);
+    for (size_t p = 1; p <= 1001; ++p)
+      {
+      for (size_t j = 1; j <= 203; ++j)
+        {
+        expected_y.at(1, j) += y.at(1, p) * dyadic.at(p, j);
+        }
+      }
+    MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation(y, dyadic) == expected_y
+      && MatrixProcessors::MultiplyMatrix(ExecutionPolicy::parallel(4)).perform_operation(y, dyadic) == expected_y ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    std::cout << "\n";
+    }
+
+
+  void test_outer_product_and_rank_one_update()
+    {
+    std::cout << " >>> test_outer_product_and_rank_one_update()\t\t";
+
+    // column times row, every element is a single product
+    const MatrixVectCol<int, 3> col({ 1, -2, 3 });
+    const MatrixVectRow<int, 4> row({ 4, 5, -6, 7 });
+    const Matrix<int, 3, 4> outer = MatrixProcessors::MultiplyMatrix().perform_operation(col, row);
+    constexpr Matrix<int, 2, 1> constexpr_col({ 2, 3 });
+    constexpr Matrix<int, 1, 2> constexpr_row({ -1, 4 });
+    constexpr Matrix<int, 2, 2> constexpr_outer = MatrixProcessors::MultiplyMatrix().perform_operation(constexpr_col, constexpr_row);
+    static_assert(constexpr_outer.at(2, 2) == 12);
+    outer == Matrix<int, 3, 4>({ 4, 5, -6, 7, -8, -10, 12, -14, 12, 15, -18, 21 })
+      && constexpr_outer == Matrix<int, 2, 2>({ -2, 8, -3, 12 }) ? std::cout << "...#1 PASSED" : std::cout << "...#1 FAILED !!!";
+
+    // big enough to have taken the GEMM engine, serial and parallel runs agree
+    DynamicMatrix<float> x(301, 1);
+    DynamicMatrix<float> y(1, 203);
+    for (size_t i = 0; i < x.get_data().size(); ++i)
+      {
+      x.data()[i] = std::sin(float(i));
+      }
+    for (size_t j = 0; j < y.get_data().size(); ++j)
+      {
+      y.data()[j] = std::cos(float(j));
+      }
+    DynamicMatrix<float> expected(301, 203);
+    for (size_t i = 1; i <= 301; ++i)
+      {
+      for (size_t j = 1; j <= 203; ++j)
+        {
+        expected.at(i, j) = x.at(i, 1) * y.at(1, j);
+        }
+      }
+    MatrixProcessors::MultiplyMatrix(ExecutionPolicy::serial()).perform_operation(x, y) == expected
+      && MatrixProcessors::MultiplyMatrix(ExecutionPolicy::parallel(4)).perform_operation(x, y) == expected ? std::cout << "...#2 PASSED" : std::cout << "...#2 FAILED !!!";
+
+    // rank-1 update in place, plain and scaled; values are dyadic, so every result is exact
+    DynamicMatrix<double> u(64, 1);
+    DynamicMatrix<double> v(1, 96);
+    DynamicMatrix<double> a(64, 96);
+    for (size_t i = 0; i < u.get_data().size(); ++i)
+      {
+      u.data()[i] = double(int(i % 7) - 3) / 2.0;
+      }
+    for (size_t j = 0; j < v.get_data().size(); ++j)
+      {
+      v.data()[j] = double(int(j % 5) - 2);
+      }
+    for (size_t i = 0; i < a.get_data().size(); ++i)
+      {
+      a.data()[i] = double(int(i % 11) - 5) / 4.0;
+      }
+    DynamicMatrix<double> updated(a);
+    DynamicMatrix<double> scaled(a);
+    MatrixProcessors::MultiplyAddMatrix().perform_operation_into(u, v, updated);
+    MatrixProcessors::MultiplyAddMatrix(ExecutionPolicy::parallel(4), -0.5, 2.0).perform_operation_into(u, v, scaled);
+    bool exact = true;
+    for (size_t i = 1; i <= 64; ++i)
+      {
+      for (size_t j = 1; j <= 96; ++j)
+        {
+        exact = exact && updated.at(i, j) == a.at(i, j) + u.at(i, 1) * v.at(1, j) && scaled.at(i, j) == 2.0 * a.at(i, j) - 0.5 * u.at(i, 1) * v.at(1, j);
+        }
+      }
+    Matrix<int, 3, 4> accumulated(outer);
+    MatrixProcessors::MultiplyAddMatrix().perform_operation_into(col, row, accumulated);
+    Matrix<int, 3, 4> doubled(outer);
+    doubled *= 2;
+    exact && accumulated == doubled ? std::cout << "...#3 PASSED" : std::cout << "...#3 FAILED !!!";
+
+    std::cout << "\n";
+    }
+}
@@ -0,0 +1,220 @@
+/*
+
+This class represents persistent pool of worker threads shared by all processors
+
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ExecutionPolicy.h"
+
+
+class ThreadPool
+  {
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+
+  // current job, changed only under m_mutex while no worker is busy
+  const std::function<void(size_t)>* m_task = nullptr;
+  size_t m_n_tasks = 0;
+  size_t m_n_participants = 0;
+  size_t m_generation = 0;
+  size_t m_busy = 0;
+  std::atomic<size_t> m_next_task { 0 };
+  std::atomic<size_t> m_finished_tasks { 0 };
+  std::exception_ptr m_error;
+  bool m_stop = false;
+
+  // one job runs at a time, other callers do their work serially
+  std::mutex m_submit;
+
+  static bool& inside_task()
+    {
+    thread_local bool flag = false;
+    return flag;
+    }
+
+  public:
+
+  ThreadPool() = default;
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool()
+    {
+      {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+      }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+      {
+      worker.join();
+      }
+    }
+
+  static ThreadPool& instance()
+    {
+    static ThreadPool pool;
+    return pool;
+    }
+
+  /// <summary>
+  /// Turns thread count of the policy into the real one.
+  /// </summary>
+  static size_t resolve_n_threads(const ExecutionPolicy& policy)
+    {
+    const size_t n_threads = policy.get_n_threads();
+    if (n_threads != ExecutionPolicy::all_threads)
+      {
+      return n_threads;
+      }
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+  /// <summary>
+  /// Calls task(i) for every i in [0, n_tasks) on up to n_threads threads, the calling one included.
+  /// Returns when all tasks are finished. Calls made from inside a task run serially.
+  /// </summary>
+  void run(size_t n_tasks, size_t n_threads, const std::function<void(size_t)>& task)
+    {
+    n_threads = std::min(n_threads, n_tasks);
+    std::unique_lock<std::mutex> submit(m_submit, std::try_to_lock);
+    if (n_threads <= 1 || inside_task() || !submit.owns_lock())
+      {
+      for (size_t i = 0; i < n_tasks; ++i)
+        {
+        task(i);
+        }
+      return;
+      }
+
+      {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (m_workers.size() < n_threads - 1)
+        {
+        m_workers.emplace_back([this, index = m_workers.size()] { worker_loop(index); });
+        }
+      m_done.wait(lock, [this] { return m_busy == 0; });
+      m_task = &task;
+      m_n_tasks = n_tasks;
+      m_n_participants = n_threads - 1;
+      m_next_task.store(0);
+      m_finished_tasks.store(0);
+      m_error = nullptr;
+      ++m_generation;
+      }
+    m_wake.notify_all();
+
+    drain(task, n_tasks);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this, n_tasks] { return m_busy == 0 && m_finished_tasks.load() == n_tasks; });
+    m_task = nullptr;
+    if (m_error)
+      {
+      std::rethrow_exception(m_error);
+      }
+    }
+
+  private:
+
+  void drain(const std::function<void(size_t)>& task, size_t n_tasks)
+    {
+    inside_task() = true;
+    for (size_t i = m_next_task.fetch_add(1); i < n_tasks; i = m_next_task.fetch_add(1))
+      {
+      try
+        {
+        task(i);
+        }
+      catch (...)
+        {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_error)
+          {
+          m_error = std::current_exception();
+          }
+        }
+      m_finished_tasks.fetch_add(1);
+      }
+    inside_task() = false;
+    }
+
+  void worker_loop(size_t index)
+    {
+    size_t seen_generation = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+      {
+      m_wake.wait(lock, [this, seen_generation] { return m_stop || m_generation != seen_generation; });
+      if (m_stop)
+        {
+        return;
+        }
+      seen_generation = m_generation;
+      if (index >= m_n_participants)
+        {
+        continue;
+        }
+
+      // woke up after the job was already finished by others
+      if (m_task == nullptr)
+        {
+        continue;
+        }
+
+      const std::function<void(size_t)>* task = m_task;
+      const size_t n_tasks = m_n_tasks;
+      ++m_busy;
+      lock.unlock();
+
+      drain(*task, n_tasks);
+
+      lock.lock();
+      --m_busy;
+      m_done.notify_all();
+      }
+    }
+  };
+
+
+/// <summary>
+/// Splits [0, n) into chunks of at least grain items (multiples of grain) and calls f(begin, end)
+/// for each of them on the threads allowed by the policy. Falls back to one serial call
+/// when there is not enough work for two chunks.
+/// </summary>
+template <typename F>
+void parallel_for(const ExecutionPolicy& policy, size_t n, size_t grain, F&& f)
+  {
+  const size_t n_threads = ThreadPool::resolve_n_threads(policy);
+  const size_t n_chunks = std::min(n_threads, n / std::max<size_t>(grain, 1));
+  if (n_chunks <= 1)
+    {
+    if (n > 0)
+      {
+      f(size_t(0), n);
+      }
+    return;
+    }
+
+  size_t chunk = (n + n_chunks - 1) / n_chunks;
+  chunk = (chunk + grain - 1) / grain * grain;
+  const size_t n_tasks = (n + chunk - 1) / chunk;
+
+  ThreadPool::instance().run(n_tasks, n_threads, [&](size_t task)
+    {
+    f(task * chunk, std::min(n, (task + 1) * chunk));
+    });
+  }
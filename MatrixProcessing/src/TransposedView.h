@@ -0,0 +1,64 @@
+/*
+
+This class represents read-only transposed view over existing Matrix
+
+*/
+
+#pragma once
+
+#include <stdexcept>
+#include "Matrix.h"
+
+
+/// <summary>
+/// R x C view over C x R Matrix. Nothing is copied: element (row, col) of the view is element
+/// (col, row) of the matrix, so rows of the view are strided by one and columns by R.
+/// The matrix must outlive the view.
+/// </summary>
+template <typename T, size_t R, size_t C>
+class TransposedView
+  {
+  const T* m_data;
+
+  public:
+
+  template <typename A>
+  explicit TransposedView(const Matrix<T, C, R, A>& mat) : m_data(mat.data()) {}
+
+  /// <summary>
+  /// Data of the viewed C x R matrix.
+  /// </summary>
+  const T* data() const
+    {
+    return m_data;
+    }
+
+  static constexpr size_t get_n_rows() { return R; }
+  static constexpr size_t get_n_cols() { return C; }
+
+  // distance between elements of neighbouring rows and columns of the view
+  static constexpr size_t get_row_stride() { return 1; }
+  static constexpr size_t get_col_stride() { return R; }
+
+  const T& at(size_t row, size_t col) const
+    {
+    if (row == 0 || row > R || col == 0 || col > C)
+      {
+      throw std::out_of_range("Index is out of matrix bounds");
+      }
+    return m_data[(col - 1) * R + row - 1];
+    }
+  };
+
+
+/// <summary>
+/// Returns transposed view over the matrix. The matrix must outlive the view.
+/// </summary>
+template <typename T, size_t R, size_t C, typename A>
+TransposedView<T, C, R> transposed(const Matrix<T, R, C, A>& mat)
+  {
+  return TransposedView<T, C, R>(mat);
+  }
+
+template <typename T, size_t R, size_t C, typename A>
+TransposedView<T, C, R> transposed(const Matrix<T, R, C, A>&& mat) = delete;